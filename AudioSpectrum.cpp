@@ -0,0 +1,335 @@
+#include "AudioSpectrum.h"
+#include <sndfile.h>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ST_USE_SSE2
+#endif
+
+#define SPECTRUM_SMOOTHING 0.8f
+#define SPECTRUM_MIN_DB -100.0f
+#define SPECTRUM_MAX_DB -30.0f
+
+namespace st
+{
+	/////// DECODING ///////
+	struct AudioStream
+	{
+		const std::string* Data;
+		sf_count_t Position;
+	};
+	sf_count_t AudioGetLength(void* user)
+	{
+		return ((AudioStream*)user)->Data->size();
+	}
+	sf_count_t AudioSeek(sf_count_t offset, int whence, void* user)
+	{
+		AudioStream* stream = (AudioStream*)user;
+		sf_count_t size = stream->Data->size();
+		if (whence == SEEK_CUR)
+			offset += stream->Position;
+		else if (whence == SEEK_END)
+			offset += size;
+		stream->Position = std::min(std::max<sf_count_t>(offset, 0), size);
+		return stream->Position;
+	}
+	sf_count_t AudioRead(void* ptr, sf_count_t count, void* user)
+	{
+		AudioStream* stream = (AudioStream*)user;
+		count = std::min<sf_count_t>(count, stream->Data->size() - stream->Position);
+		memcpy(ptr, stream->Data->data() + stream->Position, count);
+		stream->Position += count;
+		return count;
+	}
+	sf_count_t AudioWrite(const void* ptr, sf_count_t count, void* user)
+	{
+		return 0;
+	}
+	sf_count_t AudioTell(void* user)
+	{
+		return ((AudioStream*)user)->Position;
+	}
+	bool DecodeAudio(const std::string& fileData, std::vector<float>& samples, int& sampleRate)
+	{
+		SF_VIRTUAL_IO io = { AudioGetLength, AudioSeek, AudioRead, AudioWrite, AudioTell };
+		AudioStream stream = { &fileData, 0 };
+		SF_INFO info;
+		memset(&info, 0, sizeof(info));
+
+		SNDFILE* file = sf_open_virtual(&io, SFM_READ, &info, &stream);
+		if (file == nullptr)
+			return false;
+
+		sampleRate = info.samplerate;
+		samples.clear();
+		samples.reserve(info.frames > 0 ? (size_t)info.frames : 0);
+
+		std::vector<float> chunk(4096 * info.channels);
+		sf_count_t read = 0;
+		while ((read = sf_readf_float(file, chunk.data(), 4096)) > 0) {
+			for (sf_count_t i = 0; i < read; i++) {
+				float sum = 0.0f;
+				for (int c = 0; c < info.channels; c++)
+					sum += chunk[i * info.channels + c];
+				samples.push_back(sum / info.channels);
+			}
+		}
+
+		sf_close(file);
+		return !samples.empty() && sampleRate > 0;
+	}
+
+	/////// FFT ///////
+	struct FFTTables
+	{
+		std::vector<int> BitReverse;
+		std::vector<float> Cos, Sin; // twiddles of every stage, stored one stage after another
+		std::vector<float> Window;
+	};
+	FFTTables BuildFFTTables()
+	{
+		const int n = SPECTRUM_FFT_SIZE;
+		const double pi = 3.14159265358979323846;
+
+		FFTTables ret;
+		ret.BitReverse.resize(n);
+		int bits = 0;
+		while ((1 << bits) < n)
+			bits++;
+		for (int i = 0; i < n; i++) {
+			int r = 0;
+			for (int b = 0; b < bits; b++)
+				r |= ((i >> b) & 1) << (bits - 1 - b);
+			ret.BitReverse[i] = r;
+		}
+
+		for (int size = 2; size <= n; size *= 2)
+			for (int k = 0; k < size / 2; k++) {
+				ret.Cos.push_back((float)cos(-2.0 * pi * k / size));
+				ret.Sin.push_back((float)sin(-2.0 * pi * k / size));
+			}
+
+		// AnalyserNode uses the Blackman window
+		ret.Window.resize(n);
+		for (int i = 0; i < n; i++)
+			ret.Window[i] = (float)(0.42 - 0.5 * cos(2.0 * pi * i / n) + 0.08 * cos(4.0 * pi * i / n));
+
+		return ret;
+	}
+	/* in place radix-2 FFT of SPECTRUM_FFT_SIZE values, real & imaginary parts are stored in separate arrays */
+	void FFT(const FFTTables& tables, float* re, float* im)
+	{
+		const int n = SPECTRUM_FFT_SIZE;
+		const float* twCos = tables.Cos.data();
+		const float* twSin = tables.Sin.data();
+
+		for (int size = 2; size <= n; size *= 2) {
+			int half = size / 2;
+			for (int start = 0; start < n; start += size) {
+				float* aRe = re + start, *aIm = im + start;
+				float* bRe = aRe + half, *bIm = aIm + half;
+
+				int k = 0;
+#ifdef ST_USE_SSE2
+				for (; k + 4 <= half; k += 4) {
+					__m128 wr = _mm_loadu_ps(twCos + k), wi = _mm_loadu_ps(twSin + k);
+					__m128 xr = _mm_loadu_ps(bRe + k), xi = _mm_loadu_ps(bIm + k);
+					__m128 tr = _mm_sub_ps(_mm_mul_ps(wr, xr), _mm_mul_ps(wi, xi));
+					__m128 ti = _mm_add_ps(_mm_mul_ps(wr, xi), _mm_mul_ps(wi, xr));
+					__m128 ar = _mm_loadu_ps(aRe + k), ai = _mm_loadu_ps(aIm + k);
+					_mm_storeu_ps(bRe + k, _mm_sub_ps(ar, tr));
+					_mm_storeu_ps(bIm + k, _mm_sub_ps(ai, ti));
+					_mm_storeu_ps(aRe + k, _mm_add_ps(ar, tr));
+					_mm_storeu_ps(aIm + k, _mm_add_ps(ai, ti));
+				}
+#endif
+				for (; k < half; k++) {
+					float tr = twCos[k] * bRe[k] - twSin[k] * bIm[k];
+					float ti = twCos[k] * bIm[k] + twSin[k] * bRe[k];
+					bRe[k] = aRe[k] - tr;
+					bIm[k] = aIm[k] - ti;
+					aRe[k] += tr;
+					aIm[k] += ti;
+				}
+			}
+			twCos += half;
+			twSin += half;
+		}
+	}
+
+	/////// SPECTROGRAM ///////
+	/* the analysed window of a frame ends at the frame's time, samples before the start are silent */
+	void ComputeMagnitudes(const std::vector<float>& samples, int sampleRate, int frameBegin, int frameEnd, std::vector<float>& magnitudes, std::vector<unsigned char>& frames)
+	{
+		static const FFTTables tables = BuildFFTTables();
+		const int n = SPECTRUM_FFT_SIZE;
+
+		float re[SPECTRUM_FFT_SIZE], im[SPECTRUM_FFT_SIZE];
+		float window[SPECTRUM_FFT_SIZE];
+		for (int f = frameBegin; f < frameEnd; f++) {
+			long long end = (long long)f * sampleRate / SPECTRUM_FRAME_RATE;
+			for (int i = 0; i < n; i++) {
+				long long s = end - n + i;
+				window[i] = (s >= 0 && s < (long long)samples.size()) ? samples[s] : 0.0f;
+			}
+
+			// getByteTimeDomainData() - the first half of the window fits in the row
+			unsigned char* wave = frames.data() + (size_t)f * SPECTRUM_WIDTH * 2 + SPECTRUM_WIDTH;
+			for (int i = 0; i < SPECTRUM_WIDTH; i++)
+				wave[i] = (unsigned char)std::min(255.0f, std::max(0.0f, 128.0f * (window[i] + 1.0f)));
+
+			for (int i = 0; i < n; i++) {
+				re[tables.BitReverse[i]] = window[i] * tables.Window[i];
+				im[tables.BitReverse[i]] = 0.0f;
+			}
+			FFT(tables, re, im);
+
+			float* mag = magnitudes.data() + (size_t)f * SPECTRUM_WIDTH;
+			for (int i = 0; i < SPECTRUM_WIDTH; i++)
+				mag[i] = sqrtf(re[i] * re[i] + im[i] * im[i]) / n;
+		}
+	}
+	void ComputeSpectrogram(const std::vector<float>& samples, int sampleRate, std::vector<unsigned char>& frames)
+	{
+		int frameCount = (int)((long long)samples.size() * SPECTRUM_FRAME_RATE / sampleRate) + 1;
+		frames.assign((size_t)frameCount * SPECTRUM_WIDTH * 2, 0);
+		std::vector<float> magnitudes((size_t)frameCount * SPECTRUM_WIDTH);
+
+		unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+		int workers = std::min<int>(threadCount, std::max(1, frameCount / 64));
+		int framesPerWorker = (frameCount + workers - 1) / workers;
+		std::vector<std::thread> threads;
+		for (int i = 1; i < workers; i++)
+			threads.push_back(std::thread(ComputeMagnitudes, std::cref(samples), sampleRate, i * framesPerWorker, std::min(frameCount, (i + 1) * framesPerWorker), std::ref(magnitudes), std::ref(frames)));
+		ComputeMagnitudes(samples, sampleRate, 0, std::min(frameCount, framesPerWorker), magnitudes, frames);
+		for (auto& thread : threads)
+			thread.join();
+
+		// the smoothing depends on the previous frame so it runs after all FFTs are done
+		std::vector<float> smoothed(SPECTRUM_WIDTH, 0.0f);
+		for (int f = 0; f < frameCount; f++) {
+			const float* mag = magnitudes.data() + (size_t)f * SPECTRUM_WIDTH;
+			unsigned char* fft = frames.data() + (size_t)f * SPECTRUM_WIDTH * 2;
+			for (int i = 0; i < SPECTRUM_WIDTH; i++) {
+				smoothed[i] = SPECTRUM_SMOOTHING * smoothed[i] + (1.0f - SPECTRUM_SMOOTHING) * mag[i];
+				float db = smoothed[i] > 0.0f ? 20.0f * log10f(smoothed[i]) : SPECTRUM_MIN_DB;
+				float value = 255.0f * (db - SPECTRUM_MIN_DB) / (SPECTRUM_MAX_DB - SPECTRUM_MIN_DB);
+				fft[i] = (unsigned char)std::min(255.0f, std::max(0.0f, value));
+			}
+		}
+	}
+	bool WriteSpectrogram(const std::string& path, int sampleRate, const std::vector<unsigned char>& frames)
+	{
+		SpectrogramHeader header;
+		memcpy(header.Magic, "STSP", 4);
+		header.Version = 1;
+		header.Width = SPECTRUM_WIDTH;
+		header.FrameRate = SPECTRUM_FRAME_RATE;
+		header.FrameCount = frames.size() / (SPECTRUM_WIDTH * 2);
+		header.SampleRate = sampleRate;
+
+		FILE* file = fopen(path.c_str(), "wb");
+		if (file == nullptr)
+			return false;
+
+		bool ok = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(frames.data(), 1, frames.size(), file) == frames.size();
+		fclose(file);
+		return ok;
+	}
+
+	/////// MEMORY MAPPED FILE ///////
+#ifdef _WIN32
+	SpectrogramFile::SpectrogramFile() : m_header(nullptr), m_frames(nullptr), m_size(0), m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr) { }
+#else
+	SpectrogramFile::SpectrogramFile() : m_header(nullptr), m_frames(nullptr), m_size(0), m_file(-1) { }
+#endif
+	SpectrogramFile::~SpectrogramFile()
+	{
+		Close();
+	}
+	bool SpectrogramFile::Open(const std::string& path)
+	{
+		Close();
+
+		const void* view = nullptr;
+#ifdef _WIN32
+		m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		GetFileSizeEx(m_file, &size);
+		m_size = (size_t)size.QuadPart;
+		m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_mapping != nullptr)
+			view = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+		m_file = open(path.c_str(), O_RDONLY);
+		if (m_file < 0)
+			return false;
+
+		struct stat info;
+		if (fstat(m_file, &info) == 0 && info.st_size > 0) {
+			m_size = info.st_size;
+			view = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+			if (view == MAP_FAILED)
+				view = nullptr;
+		}
+#endif
+
+		m_header = (const SpectrogramHeader*)view;
+		if (m_header == nullptr || m_size < sizeof(SpectrogramHeader) || memcmp(m_header->Magic, "STSP", 4) != 0 ||
+			m_header->Width != SPECTRUM_WIDTH || m_header->FrameCount == 0 ||
+			m_size < sizeof(SpectrogramHeader) + (size_t)m_header->FrameCount * SPECTRUM_WIDTH * 2) {
+			Close();
+			return false;
+		}
+
+		m_frames = (const unsigned char*)view + sizeof(SpectrogramHeader);
+		return true;
+	}
+	void SpectrogramFile::Close()
+	{
+#ifdef _WIN32
+		if (m_header != nullptr)
+			UnmapViewOfFile(m_header);
+		if (m_mapping != nullptr)
+			CloseHandle(m_mapping);
+		if (m_file != INVALID_HANDLE_VALUE)
+			CloseHandle(m_file);
+		m_mapping = nullptr;
+		m_file = INVALID_HANDLE_VALUE;
+#else
+		if (m_header != nullptr)
+			munmap((void*)m_header, m_size);
+		if (m_file >= 0)
+			close(m_file);
+		m_file = -1;
+#endif
+		m_header = nullptr;
+		m_frames = nullptr;
+		m_size = 0;
+	}
+	const unsigned char* SpectrogramFile::GetFrame(float time) const
+	{
+		if (m_header == nullptr)
+			return nullptr;
+
+		long long frame = (long long)(std::max(0.0f, time) * m_header->FrameRate);
+		return m_frames + (size_t)(frame % m_header->FrameCount) * SPECTRUM_WIDTH * 2;
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+#include <string>
+
+#define SPECTRUM_FFT_SIZE 1024 // AnalyserNode.fftSize used by Shadertoy
+#define SPECTRUM_WIDTH 512 // FFT bins & waveform samples per row
+#define SPECTRUM_FRAME_RATE 60 // precomputed frames per second
+#define SPECTRUM_EXTENSION ".stspec"
+
+namespace st
+{
+	/* .stspec file: the header followed by FrameCount 512x2 R8 frames (FFT row, then waveform row) */
+	struct SpectrogramHeader
+	{
+		char Magic[4]; // STSP
+		unsigned int Version;
+		unsigned int Width;
+		unsigned int FrameRate;
+		unsigned int FrameCount;
+		unsigned int SampleRate; // of the decoded audio
+	};
+
+	/* any format libsndfile can read (MP3, Ogg Vorbis, WAV, FLAC, ...) - channels are mixed down to mono */
+	bool DecodeAudio(const std::string& fileData, std::vector<float>& samples, int& sampleRate);
+
+	/* emulates the Web Audio AnalyserNode (Blackman window, 0.8 smoothing, -100..-30 dB) at SPECTRUM_FRAME_RATE,
+	   the FFTs of the frames are split between threads */
+	void ComputeSpectrogram(const std::vector<float>& samples, int sampleRate, std::vector<unsigned char>& frames);
+	bool WriteSpectrogram(const std::string& path, int sampleRate, const std::vector<unsigned char>& frames);
+
+	/* memory-mapped .stspec file */
+	class SpectrogramFile
+	{
+	public:
+		SpectrogramFile();
+		~SpectrogramFile();
+
+		bool Open(const std::string& path);
+		void Close();
+
+		const unsigned char* GetFrame(float time) const; // loops
+		inline int GetFrameCount() const { return m_header == nullptr ? 0 : m_header->FrameCount; }
+
+	private:
+		const SpectrogramHeader* m_header;
+		const unsigned char* m_frames;
+		size_t m_size;
+
+#ifdef _WIN32
+		void* m_file;
+		void* m_mapping;
+#else
+		int m_file;
+#endif
+	};
+}
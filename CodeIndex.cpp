@@ -0,0 +1,609 @@
+#include "CodeIndex.h"
+#include <json11/json11.hpp>
+#include <ghc/filesystem.hpp>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <atomic>
+#include <mutex>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define CODE_INDEX_ID_SIZE 8
+#define CODE_INDEX_SNIPPET_LENGTH 120
+
+namespace st
+{
+	/////// HELPERS ///////
+	struct ShaderCode
+	{
+		std::string Name;
+		std::vector<std::pair<std::string, std::string>> Passes; // name, code
+	};
+	bool ParseShaderCode(const std::string& response, ShaderCode& code)
+	{
+		std::string err;
+		json11::Json jdata = json11::Json::parse(response, err);
+		const json11::Json& shader = jdata["Shader"];
+		if (!err.empty() || !shader.is_object())
+			return false;
+
+		code.Name = shader["info"]["name"].string_value();
+		for (const auto& pass : shader["renderpass"].array_items())
+			code.Passes.push_back(std::make_pair(pass["name"].string_value(), pass["code"].string_value()));
+		return true;
+	}
+	void GetTrigrams(const std::string& str, std::vector<unsigned int>& trigrams)
+	{
+		trigrams.clear();
+		for (size_t i = 0; i + 2 < str.size(); i++)
+			trigrams.push_back(((unsigned char)str[i] << 16) | ((unsigned char)str[i + 1] << 8) | (unsigned char)str[i + 2]);
+		std::sort(trigrams.begin(), trigrams.end());
+		trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+	}
+	void WriteVarint(std::vector<unsigned char>& out, unsigned int value)
+	{
+		while (value >= 0x80) {
+			out.push_back((unsigned char)(value | 0x80));
+			value >>= 7;
+		}
+		out.push_back((unsigned char)value);
+	}
+	void IntersectSorted(std::vector<std::string>& a, const std::vector<std::string>& b)
+	{
+		std::vector<std::string> ret;
+		std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(ret));
+		a.swap(ret);
+	}
+	bool IsIdentifierChar(char c)
+	{
+		return isalnum((unsigned char)c) || c == '_';
+	}
+
+	/////// INDEX ///////
+#ifdef _WIN32
+	CodeIndex::CodeIndex() : m_header(nullptr), m_docs(nullptr), m_trigrams(nullptr), m_postings(nullptr), m_size(0), m_log(nullptr), m_logSize(0), m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr) { }
+#else
+	CodeIndex::CodeIndex() : m_header(nullptr), m_docs(nullptr), m_trigrams(nullptr), m_postings(nullptr), m_size(0), m_log(nullptr), m_logSize(0), m_file(-1) { }
+#endif
+	CodeIndex::~CodeIndex()
+	{
+		Close();
+	}
+	bool CodeIndex::Open(const std::string& dir)
+	{
+		Close();
+		m_dir = dir;
+
+		std::error_code ec;
+		ghc::filesystem::create_directories(dir, ec);
+
+		// code.idx doesn't exist until the first merge
+		m_map(dir + "/" CODE_INDEX_FILE);
+
+		std::string logPath = dir + "/" CODE_INDEX_LOG_FILE;
+		m_log = fopen(logPath.c_str(), "r+b");
+		if (m_log == nullptr)
+			m_log = fopen(logPath.c_str(), "w+b");
+		if (m_log == nullptr)
+			return false;
+
+		// log records: null padded ID, u32 trigram count & the trigrams
+		unsigned long long fileSize = GetStoreFileSize(m_log);
+		char id[CODE_INDEX_ID_SIZE + 1] = { 0 };
+		unsigned int count = 0;
+		std::vector<unsigned int> trigrams;
+		SeekFile(m_log, 0);
+		while (fread(id, 1, CODE_INDEX_ID_SIZE, m_log) == CODE_INDEX_ID_SIZE && fread(&count, sizeof(count), 1, m_log) == 1) {
+			unsigned long long recordStart = m_logSize + CODE_INDEX_ID_SIZE + sizeof(count);
+			if (count > (fileSize - recordStart) / sizeof(unsigned int))
+				break; // more trigrams than the rest of the file holds
+
+			trigrams.resize(count);
+			if (count > 0 && fread(trigrams.data(), sizeof(unsigned int), count, m_log) != count)
+				break;
+
+			m_addLogDoc(id, trigrams);
+			m_logSize += CODE_INDEX_ID_SIZE + sizeof(count) + count * sizeof(unsigned int);
+		}
+
+		// drop the partially written record at the end
+		if (fileSize > m_logSize) {
+			fclose(m_log);
+			ghc::filesystem::resize_file(logPath, m_logSize, ec);
+			m_log = fopen(logPath.c_str(), "r+b");
+		}
+
+		return m_log != nullptr;
+	}
+	void CodeIndex::Close()
+	{
+		m_unmap();
+		if (m_log != nullptr)
+			fclose(m_log);
+		m_log = nullptr;
+		m_logSize = 0;
+		m_logIDs.clear();
+		m_logPostings.clear();
+		m_logLatest.clear();
+	}
+	bool CodeIndex::Has(const std::string& id) const
+	{
+		if (m_logLatest.count(id) > 0)
+			return true;
+		return m_findDoc(id) >= 0;
+	}
+	bool CodeIndex::Add(const std::string& id, const std::string& response)
+	{
+		ShaderCode code;
+		if (m_log == nullptr || id.empty() || id.size() > CODE_INDEX_ID_SIZE || !ParseShaderCode(response, code))
+			return false;
+
+		std::string allCode = "";
+		for (const auto& pass : code.Passes)
+			allCode += pass.second + "\n";
+
+		std::vector<unsigned int> trigrams;
+		GetTrigrams(allCode, trigrams);
+
+		char paddedID[CODE_INDEX_ID_SIZE] = { 0 };
+		memcpy(paddedID, id.data(), id.size());
+		unsigned int count = trigrams.size();
+
+		if (!SeekFile(m_log, m_logSize) || fwrite(paddedID, 1, CODE_INDEX_ID_SIZE, m_log) != CODE_INDEX_ID_SIZE || fwrite(&count, sizeof(count), 1, m_log) != 1 ||
+			(count > 0 && fwrite(trigrams.data(), sizeof(unsigned int), count, m_log) != count) || fflush(m_log) != 0)
+			return false;
+
+		m_addLogDoc(id, trigrams);
+		m_logSize += CODE_INDEX_ID_SIZE + sizeof(count) + count * sizeof(unsigned int);
+
+		if (m_logIDs.size() >= CODE_INDEX_LOG_LIMIT)
+			return Compact();
+		return true;
+	}
+	bool CodeIndex::Compact()
+	{
+		if (m_log == nullptr)
+			return false;
+		if (m_logIDs.empty())
+			return true;
+
+		// new doc order: every live shader sorted by ID
+		std::vector<std::pair<std::string, int>> docs; // ID, old main index or -(log index + 1)
+		int mainCount = m_header == nullptr ? 0 : m_header->DocCount;
+		for (int i = 0; i < mainCount; i++)
+			if (!m_stale[i])
+				docs.push_back(std::make_pair(std::string(m_docs + i * CODE_INDEX_ID_SIZE, strnlen(m_docs + i * CODE_INDEX_ID_SIZE, CODE_INDEX_ID_SIZE)), i));
+		for (const auto& pair : m_logLatest)
+			docs.push_back(std::make_pair(pair.first, -(int)pair.second - 1));
+		std::sort(docs.begin(), docs.end());
+
+		std::vector<int> mainRemap(mainCount, -1), logRemap(m_logIDs.size(), -1);
+		std::vector<char> docIDs(docs.size() * CODE_INDEX_ID_SIZE, 0);
+		for (int i = 0; i < docs.size(); i++) {
+			if (docs[i].second >= 0)
+				mainRemap[docs[i].second] = i;
+			else
+				logRemap[-docs[i].second - 1] = i;
+			memcpy(docIDs.data() + i * CODE_INDEX_ID_SIZE, docs[i].first.data(), docs[i].first.size());
+		}
+
+		// merge the postings of every trigram
+		std::vector<unsigned int> trigramKeys;
+		for (int i = 0; m_header != nullptr && i < m_header->TrigramCount; i++)
+			trigramKeys.push_back(m_trigrams[i].Trigram);
+		for (const auto& pair : m_logPostings)
+			trigramKeys.push_back(pair.first);
+		std::sort(trigramKeys.begin(), trigramKeys.end());
+		trigramKeys.erase(std::unique(trigramKeys.begin(), trigramKeys.end()), trigramKeys.end());
+
+		std::vector<CodeIndexTrigram> table;
+		std::vector<unsigned char> postings;
+		std::vector<unsigned int> mainDocs, merged;
+		for (unsigned int trigram : trigramKeys) {
+			merged.clear();
+
+			mainDocs.clear();
+			if (m_header != nullptr)
+				m_getPostings(trigram, mainDocs);
+			for (unsigned int doc : mainDocs)
+				if (doc < mainCount && mainRemap[doc] >= 0)
+					merged.push_back(mainRemap[doc]);
+
+			auto logIt = m_logPostings.find(trigram);
+			if (logIt != m_logPostings.end())
+				for (unsigned int doc : logIt->second)
+					if (logRemap[doc] >= 0)
+						merged.push_back(logRemap[doc]);
+
+			if (merged.empty())
+				continue;
+			std::sort(merged.begin(), merged.end());
+
+			CodeIndexTrigram entry;
+			entry.Trigram = trigram;
+			entry.Offset = postings.size();
+			entry.Count = merged.size();
+			unsigned int last = 0;
+			for (unsigned int doc : merged) {
+				WriteVarint(postings, doc - last);
+				last = doc;
+			}
+			table.push_back(entry);
+		}
+
+		CodeIndexHeader header;
+		memcpy(header.Magic, "STCI", 4);
+		header.Version = CODE_INDEX_VERSION;
+		header.DocCount = docs.size();
+		header.TrigramCount = table.size();
+		header.PostingsSize = postings.size();
+
+		std::string path = m_dir + "/" CODE_INDEX_FILE;
+		std::string tempPath = path + ".tmp";
+		FILE* file = fopen(tempPath.c_str(), "wb");
+		if (file == nullptr)
+			return false;
+
+		bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+		if (!docIDs.empty())
+			ok &= fwrite(docIDs.data(), 1, docIDs.size(), file) == docIDs.size();
+		if (!table.empty())
+			ok &= fwrite(table.data(), sizeof(CodeIndexTrigram), table.size(), file) == table.size();
+		if (!postings.empty())
+			ok &= fwrite(postings.data(), 1, postings.size(), file) == postings.size();
+		ok &= fclose(file) == 0;
+		if (!ok)
+			return false;
+
+		// the old file has to be unmapped before it can be replaced
+		m_unmap();
+		remove(path.c_str());
+		if (rename(tempPath.c_str(), path.c_str()) != 0 || !m_map(path))
+			return false;
+
+		// everything in the log is in code.idx now
+		fclose(m_log);
+		m_log = fopen((m_dir + "/" CODE_INDEX_LOG_FILE).c_str(), "w+b");
+		m_logSize = 0;
+		m_logIDs.clear();
+		m_logPostings.clear();
+		m_logLatest.clear();
+
+		return m_log != nullptr;
+	}
+	int CodeIndex::GetCount() const
+	{
+		int count = m_logLatest.size();
+		for (int i = 0; i < m_stale.size(); i++)
+			count += !m_stale[i];
+		return count;
+	}
+	void CodeIndex::Search(const ShaderStore& store, const std::string& query, int maxHits, std::vector<CodeSearchHit>& hits) const
+	{
+		hits.clear();
+
+		std::vector<std::string> terms;
+		size_t start = query.find_first_not_of(" \t");
+		while (start != std::string::npos) {
+			size_t end = query.find_first_of(" \t", start);
+			terms.push_back(query.substr(start, end - start));
+			start = query.find_first_not_of(" \t", end);
+		}
+		if (terms.empty())
+			return;
+
+		// every term with at least one trigram narrows the candidates down, shorter terms are only verified
+		std::vector<std::string> candidates, termCandidates;
+		bool narrowed = false;
+		for (const auto& term : terms) {
+			if (term.size() < 3)
+				continue;
+
+			m_findCandidates(term, termCandidates);
+			if (narrowed)
+				IntersectSorted(candidates, termCandidates);
+			else
+				candidates.swap(termCandidates);
+			narrowed = true;
+
+			if (candidates.empty())
+				return;
+		}
+		if (!narrowed)
+			m_getAllDocs(candidates);
+
+		// verify & rank the candidates with the stored code on all cores
+		std::mutex hitsMutex;
+		std::atomic<int> next(0);
+		auto worker = [&]() {
+			for (int i = next++; i < (int)candidates.size(); i = next++) {
+				std::string response;
+				ShaderCode code;
+				if (!store.Get(candidates[i], response) || !ParseShaderCode(response, code))
+					continue;
+
+				CodeSearchHit hit;
+				hit.ID = candidates[i];
+				hit.Name = code.Name;
+				hit.Score = 0;
+				hit.Line = 0;
+
+				int bestMatch = -1;
+				bool hasAllTerms = true;
+				for (const auto& term : terms) {
+					bool found = false;
+					for (const auto& pass : code.Passes) {
+						const std::string& src = pass.second;
+						for (size_t pos = src.find(term); pos != std::string::npos; pos = src.find(term, pos + 1)) {
+							found = true;
+
+							int score = 1;
+							bool wholeWord = (pos == 0 || !IsIdentifierChar(src[pos - 1])) && (pos + term.size() >= src.size() || !IsIdentifierChar(src[pos + term.size()]));
+							if (wholeWord) {
+								score += 2;
+
+								// "<type> term(" is a definition
+								size_t after = src.find_first_not_of(" \t", pos + term.size());
+								size_t typeEnd = pos > 0 ? src.find_last_not_of(" \t", pos - 1) : std::string::npos;
+								if (after != std::string::npos && src[after] == '(' && typeEnd != std::string::npos && typeEnd + 1 < pos && IsIdentifierChar(src[typeEnd])) {
+									size_t typeStart = typeEnd;
+									while (typeStart > 0 && IsIdentifierChar(src[typeStart - 1]))
+										typeStart--;
+									if (src.compare(typeStart, typeEnd - typeStart + 1, "return") != 0)
+										score += 10;
+								}
+							}
+							hit.Score += score;
+
+							if (score > bestMatch) {
+								bestMatch = score;
+								size_t lineStart = src.rfind('\n', pos);
+								lineStart = lineStart == std::string::npos ? 0 : lineStart + 1;
+								size_t lineEnd = src.find('\n', pos);
+								std::string line = src.substr(lineStart, lineEnd == std::string::npos ? std::string::npos : lineEnd - lineStart);
+								size_t first = line.find_first_not_of(" \t\r");
+								line = first == std::string::npos ? "" : line.substr(first, line.find_last_not_of(" \t\r") - first + 1);
+								if (line.size() > CODE_INDEX_SNIPPET_LENGTH)
+									line = line.substr(0, CODE_INDEX_SNIPPET_LENGTH) + "...";
+
+								hit.Pass = pass.first;
+								hit.Line = std::count(src.begin(), src.begin() + pos, '\n') + 1;
+								hit.Snippet = line;
+							}
+						}
+					}
+					hasAllTerms &= found;
+				}
+
+				if (hasAllTerms) {
+					std::lock_guard<std::mutex> lock(hitsMutex);
+					hits.push_back(hit);
+				}
+			}
+		};
+
+		int threadCount = std::max(1, std::min((int)std::thread::hardware_concurrency(), (int)candidates.size() / 16));
+		std::vector<std::thread> threads;
+		for (int i = 1; i < threadCount; i++)
+			threads.push_back(std::thread(worker));
+		worker();
+		for (auto& thread : threads)
+			thread.join();
+
+		std::sort(hits.begin(), hits.end(), [](const CodeSearchHit& a, const CodeSearchHit& b) {
+			return a.Score != b.Score ? a.Score > b.Score : a.ID < b.ID;
+		});
+		if (maxHits > 0 && hits.size() > maxHits)
+			hits.resize(maxHits);
+	}
+
+	bool CodeIndex::m_map(const std::string& path)
+	{
+		m_unmap();
+
+		const void* view = nullptr;
+#ifdef _WIN32
+		m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		GetFileSizeEx(m_file, &size);
+		m_size = (size_t)size.QuadPart;
+		m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_mapping != nullptr)
+			view = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+		m_file = open(path.c_str(), O_RDONLY);
+		if (m_file < 0)
+			return false;
+
+		struct stat info;
+		if (fstat(m_file, &info) == 0 && info.st_size > 0) {
+			m_size = info.st_size;
+			view = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+			if (view == MAP_FAILED)
+				view = nullptr;
+		}
+#endif
+
+		m_header = (const CodeIndexHeader*)view;
+		if (m_header == nullptr || m_size < sizeof(CodeIndexHeader) || memcmp(m_header->Magic, "STCI", 4) != 0 ||
+			m_header->Version != CODE_INDEX_VERSION ||
+			m_size != sizeof(CodeIndexHeader) + (size_t)m_header->DocCount * CODE_INDEX_ID_SIZE + (size_t)m_header->TrigramCount * sizeof(CodeIndexTrigram) + m_header->PostingsSize) {
+			m_unmap();
+			return false;
+		}
+
+		m_docs = (const char*)view + sizeof(CodeIndexHeader);
+		m_trigrams = (const CodeIndexTrigram*)(m_docs + (size_t)m_header->DocCount * CODE_INDEX_ID_SIZE);
+		m_postings = (const unsigned char*)(m_trigrams + m_header->TrigramCount);
+		m_stale.assign(m_header->DocCount, false);
+		return true;
+	}
+	void CodeIndex::m_unmap()
+	{
+#ifdef _WIN32
+		if (m_header != nullptr)
+			UnmapViewOfFile(m_header);
+		if (m_mapping != nullptr)
+			CloseHandle(m_mapping);
+		if (m_file != INVALID_HANDLE_VALUE)
+			CloseHandle(m_file);
+		m_mapping = nullptr;
+		m_file = INVALID_HANDLE_VALUE;
+#else
+		if (m_header != nullptr)
+			munmap((void*)m_header, m_size);
+		if (m_file >= 0)
+			close(m_file);
+		m_file = -1;
+#endif
+		m_header = nullptr;
+		m_docs = nullptr;
+		m_trigrams = nullptr;
+		m_postings = nullptr;
+		m_size = 0;
+		m_stale.clear();
+	}
+	int CodeIndex::m_findDoc(const std::string& id) const
+	{
+		if (m_header == nullptr || id.size() > CODE_INDEX_ID_SIZE)
+			return -1;
+
+		char key[CODE_INDEX_ID_SIZE] = { 0 };
+		memcpy(key, id.data(), id.size());
+
+		int lo = 0, hi = (int)m_header->DocCount - 1;
+		while (lo <= hi) {
+			int mid = (lo + hi) / 2;
+			int cmp = memcmp(m_docs + (size_t)mid * CODE_INDEX_ID_SIZE, key, CODE_INDEX_ID_SIZE);
+			if (cmp == 0)
+				return mid;
+			if (cmp < 0)
+				lo = mid + 1;
+			else
+				hi = mid - 1;
+		}
+		return -1;
+	}
+	void CodeIndex::m_getPostings(unsigned int trigram, std::vector<unsigned int>& docs) const
+	{
+		docs.clear();
+		if (m_header == nullptr)
+			return;
+
+		const CodeIndexTrigram* end = m_trigrams + m_header->TrigramCount;
+		const CodeIndexTrigram* it = std::lower_bound(m_trigrams, end, trigram, [](const CodeIndexTrigram& entry, unsigned int trigram) {
+			return entry.Trigram < trigram;
+		});
+		if (it == end || it->Trigram != trigram)
+			return;
+
+		const unsigned char* data = m_postings + it->Offset;
+		const unsigned char* dataEnd = m_postings + m_header->PostingsSize;
+		unsigned int doc = 0;
+		docs.reserve(it->Count);
+		for (unsigned int i = 0; i < it->Count && data < dataEnd; i++) {
+			unsigned int delta = 0;
+			for (int shift = 0; data < dataEnd; shift += 7) {
+				delta |= (unsigned int)(*data & 0x7F) << shift;
+				if ((*data++ & 0x80) == 0)
+					break;
+			}
+			doc += delta;
+			docs.push_back(doc);
+		}
+	}
+	void CodeIndex::m_addLogDoc(const std::string& id, const std::vector<unsigned int>& trigrams)
+	{
+		unsigned int doc = m_logIDs.size();
+		m_logIDs.push_back(id);
+		m_logLatest[id] = doc;
+		for (unsigned int trigram : trigrams)
+			m_logPostings[trigram].push_back(doc);
+
+		int mainDoc = m_findDoc(id);
+		if (mainDoc >= 0)
+			m_stale[mainDoc] = true;
+	}
+	void CodeIndex::m_findCandidates(const std::string& term, std::vector<std::string>& ids) const
+	{
+		ids.clear();
+
+		std::vector<unsigned int> trigrams;
+		GetTrigrams(term, trigrams);
+
+		// code.idx - rarest trigrams first so that the intersection shrinks quickly
+		std::vector<std::pair<unsigned int, unsigned int>> order; // count, trigram
+		bool mainHasAll = m_header != nullptr;
+		for (unsigned int trigram : trigrams) {
+			const CodeIndexTrigram* end = m_trigrams + (m_header == nullptr ? 0 : m_header->TrigramCount);
+			const CodeIndexTrigram* it = m_header == nullptr ? end : std::lower_bound(m_trigrams, end, trigram, [](const CodeIndexTrigram& entry, unsigned int trigram) {
+				return entry.Trigram < trigram;
+			});
+			if (it == end || it->Trigram != trigram) {
+				mainHasAll = false;
+				break;
+			}
+			order.push_back(std::make_pair(it->Count, trigram));
+		}
+		if (mainHasAll) {
+			std::sort(order.begin(), order.end());
+
+			std::vector<unsigned int> docs, other, merged;
+			m_getPostings(order[0].second, docs);
+			for (int i = 1; i < order.size() && !docs.empty(); i++) {
+				m_getPostings(order[i].second, other);
+				merged.clear();
+				std::set_intersection(docs.begin(), docs.end(), other.begin(), other.end(), std::back_inserter(merged));
+				docs.swap(merged);
+			}
+
+			for (unsigned int doc : docs)
+				if (doc < m_header->DocCount && !m_stale[doc])
+					ids.push_back(std::string(m_docs + (size_t)doc * CODE_INDEX_ID_SIZE, strnlen(m_docs + (size_t)doc * CODE_INDEX_ID_SIZE, CODE_INDEX_ID_SIZE)));
+		}
+
+		// code.log
+		std::vector<unsigned int> logDocs;
+		for (int i = 0; i < trigrams.size(); i++) {
+			auto it = m_logPostings.find(trigrams[i]);
+			if (it == m_logPostings.end()) {
+				logDocs.clear();
+				break;
+			}
+
+			if (i == 0)
+				logDocs = it->second;
+			else {
+				std::vector<unsigned int> merged;
+				std::set_intersection(logDocs.begin(), logDocs.end(), it->second.begin(), it->second.end(), std::back_inserter(merged));
+				logDocs.swap(merged);
+			}
+		}
+		for (unsigned int doc : logDocs)
+			if (m_logLatest.at(m_logIDs[doc]) == doc)
+				ids.push_back(m_logIDs[doc]);
+
+		std::sort(ids.begin(), ids.end());
+	}
+	void CodeIndex::m_getAllDocs(std::vector<std::string>& ids) const
+	{
+		ids.clear();
+		for (int i = 0; i < m_stale.size(); i++)
+			if (!m_stale[i])
+				ids.push_back(std::string(m_docs + (size_t)i * CODE_INDEX_ID_SIZE, strnlen(m_docs + (size_t)i * CODE_INDEX_ID_SIZE, CODE_INDEX_ID_SIZE)));
+		for (const auto& pair : m_logLatest)
+			ids.push_back(pair.first);
+		std::sort(ids.begin(), ids.end());
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "ShaderStore.h"
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <map>
+
+#define CODE_INDEX_FILE "code.idx"
+#define CODE_INDEX_LOG_FILE "code.log"
+#define CODE_INDEX_VERSION 1
+#define CODE_INDEX_LOG_LIMIT 2000 // shaders in code.log before it's merged into code.idx
+
+namespace st
+{
+	/* code.idx: the header, DocCount null padded IDs (sorted), TrigramCount trigrams (sorted) and the postings
+	   (varint encoded doc index deltas) */
+	struct CodeIndexHeader
+	{
+		char Magic[4]; // STCI
+		unsigned int Version;
+		unsigned int DocCount;
+		unsigned int TrigramCount;
+		unsigned int PostingsSize;
+	};
+	struct CodeIndexTrigram
+	{
+		unsigned int Trigram; // 3 bytes of code
+		unsigned int Offset; // into the postings
+		unsigned int Count;
+	};
+
+	struct CodeSearchHit
+	{
+		std::string ID;
+		std::string Name;
+		std::string Pass; // of the best match
+		int Line;
+		std::string Snippet; // the line with the best match
+		int Score;
+	};
+
+	/* trigram index over the code of every renderpass of the stored shaders. Shaders are added to an
+	   append-only log that is merged into the memory-mapped code.idx once it holds CODE_INDEX_LOG_LIMIT shaders.
+	   A search intersects the postings of the trigrams of every (space separated) term and then verifies &
+	   ranks the candidates with the code from the store. Not thread safe. */
+	class CodeIndex
+	{
+	public:
+		CodeIndex();
+		~CodeIndex();
+
+		bool Open(const std::string& dir);
+		void Close();
+
+		bool Has(const std::string& id) const;
+		bool Add(const std::string& id, const std::string& response); // response = API JSON, replaces the older code
+		bool Compact(); // merges the log into code.idx
+
+		int GetCount() const;
+
+		/* terms must all appear in the shader; definitions & whole identifiers rank higher than other matches */
+		void Search(const ShaderStore& store, const std::string& query, int maxHits, std::vector<CodeSearchHit>& hits) const;
+
+	private:
+		bool m_map(const std::string& path);
+		void m_unmap();
+		int m_findDoc(const std::string& id) const;
+		void m_getPostings(unsigned int trigram, std::vector<unsigned int>& docs) const;
+		void m_addLogDoc(const std::string& id, const std::vector<unsigned int>& trigrams);
+		void m_findCandidates(const std::string& term, std::vector<std::string>& ids) const;
+		void m_getAllDocs(std::vector<std::string>& ids) const;
+
+		std::string m_dir;
+
+		// code.idx
+		const CodeIndexHeader* m_header;
+		const char* m_docs;
+		const CodeIndexTrigram* m_trigrams;
+		const unsigned char* m_postings;
+		size_t m_size;
+		std::vector<bool> m_stale; // doc was added again to the log
+
+		// code.log
+		FILE* m_log;
+		unsigned long long m_logSize;
+		std::vector<std::string> m_logIDs;
+		std::unordered_map<unsigned int, std::vector<unsigned int>> m_logPostings;
+		std::map<std::string, unsigned int> m_logLatest;
+
+#ifdef _WIN32
+		void* m_file;
+		void* m_mapping;
+#else
+		int m_file;
+#endif
+	};
+}
@@ -0,0 +1,237 @@
+#include "ComputePass.h"
+#include "ShaderAnalyzer.h"
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+
+namespace st
+{
+	const char* FragmentOnlyIdentifiers[] = {
+		"dFdx", "dFdy", "fwidth", "dFdxFine", "dFdyFine", "dFdxCoarse", "dFdyCoarse", "fwidthFine", "fwidthCoarse",
+		"discard", "gl_FragCoord", "gl_FrontFacing", "gl_PointCoord", "gl_FragDepth", "gl_SamplePosition"
+	};
+
+	bool ReadsScreenPixels(const RenderPass& reader, int channel)
+	{
+		std::string channelName = "iChannel" + std::to_string(channel);
+		if (DirectivesUse(reader.Code, channelName))
+			return true;
+
+		std::vector<Token> tokens;
+		std::vector<Define> defines;
+		TokenizeGLSL(reader.Code, 0, tokens, defines);
+
+		size_t argsOpen = 0, bodyOpen = 0, bodyClose = 0;
+		if (!FindFunction(tokens, "mainImage", argsOpen, bodyOpen, bodyClose))
+			return true;
+
+		// vec2 uv = fragCoord / iResolution.xy;
+		std::set<std::string> screenNames = { tokens[bodyOpen - 2].Text, "iResolution", "gl_FragCoord" };
+		for (size_t i = bodyOpen; i + 3 < bodyClose; i++) {
+			if (tokens[i + 1].Type != TokenType::Identifier || tokens[i + 2].Text != "=")
+				continue;
+			for (size_t j = i + 3; j < bodyClose && tokens[j].Text != ";"; j++)
+				if (screenNames.count(tokens[j].Text) > 0) {
+					screenNames.insert(tokens[i + 1].Text);
+					break;
+				}
+		}
+
+		for (size_t i = 0; i < tokens.size(); i++) {
+			if (tokens[i].Text != channelName)
+				continue;
+
+			// helper functions might get the screen coordinates through their arguments
+			if (i < 2 || i <= bodyOpen || i >= bodyClose || tokens[i - 1].Text != "(" || !IsTextureFunction(tokens[i - 2].Text) || tokens[i - 2].Text.compare(0, 10, "texelFetch") == 0)
+				return true;
+
+			size_t close = FindMatchingToken(tokens, i - 1);
+			for (size_t j = i + 1; j < close && j < tokens.size(); j++)
+				if (screenNames.count(tokens[j].Text) > 0)
+					return true;
+		}
+		return false;
+	}
+	bool IsComputeCompatible(const std::vector<RenderPass>& passes, int index)
+	{
+		const RenderPass& pass = passes[index];
+		if (pass.Type != "buffer" || pass.Outputs.empty())
+			return false;
+
+		// feedback would read & write the same image in one dispatch
+		for (const auto& inp : pass.Inputs) {
+			if (inp.Type == "buffer" && inp.ID == pass.Outputs[0].ID)
+				return false;
+
+			// compute shaders have no implicit LOD
+			if (inp.Sampler.Filter == "mipmap")
+				return false;
+		}
+
+		std::vector<Token> tokens;
+		std::vector<Define> defines;
+		TokenizeGLSL(pass.Code, 0, tokens, defines);
+
+		for (const char* name : FragmentOnlyIdentifiers)
+			if (UsesIdentifier(tokens, defines, name))
+				return false;
+
+		// the image doesn't follow the window size, so screen space reads would get the wrong pixels
+		for (const auto& reader : passes)
+			for (const auto& inp : reader.Inputs)
+				if (inp.Type == "buffer" && inp.ID == pass.Outputs[0].ID && ReadsScreenPixels(reader, inp.Channel))
+					return false;
+
+		size_t argsOpen = 0, bodyOpen = 0, bodyClose = 0;
+		return FindFunction(tokens, "mainImage", argsOpen, bodyOpen, bodyClose);
+	}
+
+	/////// SHARED MEMORY STAGING ///////
+	struct StagedRead
+	{
+		size_t Begin, End; // position in the code
+		int Channel;
+		int OffsetX, OffsetY;
+	};
+	bool MatchConstantOffset(const std::vector<Token>& tokens, size_t& i, int& out)
+	{
+		bool negative = MatchSequence(tokens, i, { "-" });
+		if (i >= tokens.size() || tokens[i].Type != TokenType::Number || tokens[i].Text.find_first_not_of("0123456789") != std::string::npos)
+			return false;
+
+		out = atoi(tokens[i].Text.c_str()) * (negative ? -1 : 1);
+		i++;
+		return true;
+	}
+	bool MatchNeighbourRead(const std::vector<Token>& tokens, size_t i, const std::string& channel, const std::string& fragCoord, StagedRead& read)
+	{
+		// texelFetch(iChannelN, ivec2(fragCoord) + ivec2(x, y), 0)
+		size_t j = i;
+		if (!MatchSequence(tokens, j, { "texelFetch", "(", channel, ",", "ivec2", "(" }) || !MatchFragCoord(tokens, j, fragCoord) || !MatchSequence(tokens, j, { ")" }))
+			return false;
+
+		read.OffsetX = read.OffsetY = 0;
+		if (MatchSequence(tokens, j, { "+", "ivec2", "(" })) {
+			if (!MatchConstantOffset(tokens, j, read.OffsetX) || !MatchSequence(tokens, j, { "," }) ||
+				!MatchConstantOffset(tokens, j, read.OffsetY) || !MatchSequence(tokens, j, { ")" }))
+				return false;
+		}
+
+		if (!MatchSequence(tokens, j, { ",", "0", ")" }))
+			return false;
+
+		read.Begin = tokens[i].Offset;
+		read.End = tokens[j - 1].Offset + 1;
+		return true;
+	}
+	int FindStagedReads(const std::vector<Token>& tokens, int channel, std::vector<StagedRead>& reads)
+	{
+		size_t argsOpen = 0, bodyOpen = 0, bodyClose = 0;
+		if (!FindFunction(tokens, "mainImage", argsOpen, bodyOpen, bodyClose))
+			return 0;
+
+		std::string fragCoord = tokens[bodyOpen - 2].Text;
+		if (IsModified(tokens, bodyOpen, bodyClose, fragCoord, tokens.size()))
+			return 0;
+
+		std::string channelName = "iChannel" + std::to_string(channel);
+		int halo = 0;
+		bool hasOffset = false;
+		for (size_t i = 0; i < tokens.size(); i++) {
+			if (tokens[i].Text != channelName)
+				continue;
+
+			StagedRead read;
+			if (i < 2 || i <= bodyOpen || i >= bodyClose || !MatchNeighbourRead(tokens, i - 2, channelName, fragCoord, read))
+				return 0;
+
+			halo = std::max(halo, std::max(abs(read.OffsetX), abs(read.OffsetY)));
+			hasOffset |= read.OffsetX != 0 || read.OffsetY != 0;
+			reads.push_back(read);
+		}
+
+		if (!hasOffset || halo > COMPUTE_MAX_HALO)
+			return 0;
+		return halo;
+	}
+
+	/////// CODE GENERATION ///////
+	std::string GenerateComputeShader(const RenderPass& pass, const std::string& common, bool renderOnce, const std::string& format)
+	{
+		// RGBA16F -> rgba16f
+		std::string layoutFormat = format;
+		std::transform(layoutFormat.begin(), layoutFormat.end(), layoutFormat.begin(), ::tolower);
+
+		std::vector<Token> tokens;
+		std::vector<Define> defines;
+		TokenizeGLSL(pass.Code, 0, tokens, defines);
+
+		std::string tile = std::to_string(COMPUTE_TILE_SIZE);
+		std::string code = pass.Code;
+		std::string staging = "", loaders = "";
+		std::vector<StagedRead> allReads;
+
+		for (int channel = 0; channel < 4; channel++) {
+			std::vector<StagedRead> reads;
+			int halo = FindStagedReads(tokens, channel, reads);
+			if (halo == 0 || DirectivesUse(pass.Code, "iChannel" + std::to_string(channel)))
+				continue;
+
+			std::string ch = std::to_string(channel);
+			std::string width = std::to_string(COMPUTE_TILE_SIZE + 2 * halo);
+			std::string border = std::to_string(halo);
+
+			staging += "shared vec4 shadertoy_tile" + ch + "[" + width + " * " + width + "];\n"
+				"vec4 shadertoy_fetch" + ch + "(ivec2 offset)\n{\n"
+				"\tivec2 p = ivec2(gl_LocalInvocationID.xy) + offset + " + border + ";\n"
+				"\treturn shadertoy_tile" + ch + "[p.y * " + width + " + p.x];\n"
+				"}\n";
+
+			loaders += "\t{\n"
+				"\t\tivec2 origin = ivec2(gl_WorkGroupID.xy) * " + tile + " - " + border + ";\n"
+				"\t\tivec2 maxCoord = textureSize(iChannel" + ch + ", 0) - 1;\n"
+				"\t\tfor (uint i = gl_LocalInvocationIndex; i < " + width + "u * " + width + "u; i += " + tile + "u * " + tile + "u)\n"
+				"\t\t\tshadertoy_tile" + ch + "[i] = texelFetch(iChannel" + ch + ", clamp(origin + ivec2(i % " + width + "u, i / " + width + "u), ivec2(0), maxCoord), 0);\n"
+				"\t}\n";
+
+			for (auto& read : reads) {
+				read.Channel = channel;
+				allReads.push_back(read);
+			}
+		}
+
+		// replace from the back so that the offsets stay valid
+		std::sort(allReads.begin(), allReads.end(), [](const StagedRead& a, const StagedRead& b) { return a.Begin > b.Begin; });
+		for (const auto& read : allReads) {
+			// texelFetch(iChannelN, ivec2(fragCoord) + ivec2(x, y), 0) -> shadertoy_fetchN(ivec2(x, y))
+			std::string offset = "ivec2(" + std::to_string(read.OffsetX) + ", " + std::to_string(read.OffsetY) + ")";
+			code.replace(read.Begin, read.End - read.Begin, "shadertoy_fetch" + std::to_string(read.Channel) + "(" + offset + ")");
+		}
+
+		std::string channels = "";
+		for (int i = 0; i < 4; i++)
+			channels += "layout (binding = " + std::to_string(i) + ") uniform " + GetChannelSamplerType(pass, i) + " iChannel" + std::to_string(i) + ";\n";
+
+		std::string ret = "#version 430\n\n" + common +
+			"layout (local_size_x = " + tile + ", local_size_y = " + tile + ") in;\n"
+			"layout (" + layoutFormat + ", binding = 0) uniform writeonly image2D shadertoy_output;\n"
+			"#define iResolution vec2(imageSize(shadertoy_output))\n"
+			"uniform float iTime;\n"
+			"uniform float iTimeDelta;\n"
+			"uniform int iFrame;\n"
+			"uniform vec4 iMouse;\n" + channels + staging + "\n" +
+			code + "\n"
+			"void main()\n{\n" +
+			std::string(renderOnce ? "\tif (iFrame > 0)\n\t\treturn;\n" : "") +
+			loaders +
+			std::string(loaders.empty() ? "" : "\tbarrier();\n") +
+			"\tivec2 pixel = ivec2(gl_GlobalInvocationID.xy);\n"
+			"\tif (any(greaterThanEqual(pixel, imageSize(shadertoy_output))))\n"
+			"\t\treturn;\n"
+			"\tvec4 color = vec4(0.0);\n"
+			"\tmainImage(color, vec2(pixel) + 0.5);\n"
+			"\timageStore(shadertoy_output, pixel, color);\n"
+			"}";
+		return ret;
+	}
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "RenderPass.h"
+#include <vector>
+#include <string>
+
+#define COMPUTE_TILE_SIZE 16 // local_size_x & local_size_y of the generated compute shaders
+#define COMPUTE_MAX_HALO 4 // largest texelFetch offset that is staged in shared memory
+#define COMPUTE_IMAGE_WIDTH 1920 // image objects have a fixed size
+#define COMPUTE_IMAGE_HEIGHT 1080
+
+namespace st
+{
+	/* iChannelN is read at screen space coordinates (fragCoord, iResolution, texelFetch) or in a way that isn't understood */
+	bool ReadsScreenPixels(const RenderPass& reader, int channel);
+
+	/* buffers that write one pixel per invocation (no derivatives, discard, gl_FragCoord or feedback) and whose readers
+	   don't sample them at screen space coordinates - the fixed size image wouldn't line up with the window */
+	bool IsComputeCompatible(const std::vector<RenderPass>& passes, int index);
+
+	/* wraps the mainImage code in a compute shader that writes to an image - neighbour texelFetch-es
+	   with constant offsets are served from a shared memory tile; common is placed on the 3rd line */
+	std::string GenerateComputeShader(const RenderPass& pass, const std::string& common, bool renderOnce, const std::string& format);
+}
@@ -0,0 +1,259 @@
+#include "CubemapPass.h"
+#include "ShaderAnalyzer.h"
+#include <GL/glew.h>
+#include <algorithm>
+
+namespace st
+{
+	/////// SHADERS ///////
+	const char* CubemapVertexShader = R"(#version 330
+
+void main()
+{
+	// full screen triangle without vertex buffers
+	vec2 pos = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+	gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+	const char* CubemapGeometryShader = R"(#version 330
+
+layout(triangles) in;
+layout(triangle_strip, max_vertices = 18) out;
+
+flat out int shadertoy_face;
+
+void main()
+{
+	for (int face = 0; face < 6; face++) {
+		for (int i = 0; i < 3; i++) {
+			gl_Layer = face;
+			shadertoy_face = face;
+			gl_Position = gl_in[i].gl_Position;
+			EmitVertex();
+		}
+		EndPrimitive();
+	}
+}
+)";
+
+	std::string GenerateCubemapShader(const RenderPass& pass, const std::string& code, const std::string& common)
+	{
+		std::string channels = "";
+		for (int i = 0; i < 4; i++)
+			channels += "uniform " + std::string(GetChannelSamplerType(pass, i)) + " iChannel" + std::to_string(i) + ";\n";
+
+		return "#version 330\n\n" + common +
+			"uniform vec2 iResolution;\n"
+			"uniform float iTime;\n"
+			"uniform float iTimeDelta;\n"
+			"uniform int iFrame;\n"
+			"uniform vec4 iMouse;\n" + channels +
+			"flat in int shadertoy_face;\n"
+			"out vec4 shadertoy_outcolor;\n\n" + code + "\n"
+			"void main()\n{\n"
+			"\tvec2 uv = gl_FragCoord.xy / iResolution * 2.0 - 1.0;\n"
+			"\tvec3 dir;\n"
+			"\tif (shadertoy_face == 0) dir = vec3(1.0, -uv.y, -uv.x);\n"
+			"\telse if (shadertoy_face == 1) dir = vec3(-1.0, -uv.y, uv.x);\n"
+			"\telse if (shadertoy_face == 2) dir = vec3(uv.x, 1.0, uv.y);\n"
+			"\telse if (shadertoy_face == 3) dir = vec3(uv.x, -1.0, -uv.y);\n"
+			"\telse if (shadertoy_face == 4) dir = vec3(uv.x, -uv.y, 1.0);\n"
+			"\telse dir = vec3(-uv.x, -uv.y, -1.0);\n"
+			"\tmainCubemap(shadertoy_outcolor, gl_FragCoord.xy, vec3(0.0), normalize(dir));\n"
+			"}\n";
+	}
+
+	/////// BUFFER ///////
+	CubemapBuffer::CubemapBuffer() : m_current(0), m_size(0), m_mipmaps(false), m_doubleBuffered(false)
+	{
+		m_textures[0] = m_textures[1] = 0;
+	}
+	CubemapBuffer::~CubemapBuffer()
+	{
+		Destroy();
+	}
+	bool CubemapBuffer::Create(int size, const std::string& filter, bool doubleBuffered)
+	{
+		Destroy();
+
+		m_size = size;
+		m_mipmaps = filter == "mipmap";
+		m_doubleBuffered = doubleBuffered;
+		m_current = 0;
+
+		int levels = 1;
+		while (m_mipmaps && (size >> levels) > 0)
+			levels++;
+
+		GLint minFilter = m_mipmaps ? GL_LINEAR_MIPMAP_LINEAR : (filter == "nearest" ? GL_NEAREST : GL_LINEAR);
+		GLint magFilter = filter == "nearest" ? GL_NEAREST : GL_LINEAR;
+
+		int count = doubleBuffered ? 2 : 1;
+		glGenTextures(count, m_textures);
+		for (int i = 0; i < count; i++) {
+			glBindTexture(GL_TEXTURE_CUBE_MAP, m_textures[i]);
+			for (int face = 0; face < 6; face++)
+				for (int level = 0; level < levels; level++) {
+					int levelSize = std::max(1, size >> level);
+					glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, level, GL_RGBA16F, levelSize, levelSize, 0, GL_RGBA, GL_HALF_FLOAT, nullptr);
+				}
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, levels - 1);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, minFilter);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, magFilter);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+		}
+		glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+		return glGetError() == GL_NO_ERROR;
+	}
+	void CubemapBuffer::Destroy()
+	{
+		for (int i = 0; i < 2; i++)
+			if (m_textures[i] != 0)
+				glDeleteTextures(1, &m_textures[i]);
+		m_textures[0] = m_textures[1] = 0;
+		m_size = 0;
+	}
+	void CubemapBuffer::Swap()
+	{
+		if (m_doubleBuffered)
+			m_current = 1 - m_current;
+	}
+
+	/////// PASS ///////
+	GLuint CompileShader(GLenum type, const char* source, std::string& log)
+	{
+		GLuint shader = glCreateShader(type);
+		glShaderSource(shader, 1, &source, nullptr);
+		glCompileShader(shader);
+
+		GLint status = 0;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+		if (!status) {
+			char info[1024];
+			glGetShaderInfoLog(shader, sizeof(info), nullptr, info);
+			log += info;
+			glDeleteShader(shader);
+			return 0;
+		}
+		return shader;
+	}
+
+	CubemapPass::CubemapPass() : m_program(0), m_vao(0), m_fbo(0) { }
+	CubemapPass::~CubemapPass()
+	{
+		Destroy();
+	}
+	bool CubemapPass::Compile(const std::string& fragmentSource, std::string& log)
+	{
+		Destroy();
+
+		GLuint vs = CompileShader(GL_VERTEX_SHADER, CubemapVertexShader, log);
+		GLuint gs = CompileShader(GL_GEOMETRY_SHADER, CubemapGeometryShader, log);
+		GLuint ps = CompileShader(GL_FRAGMENT_SHADER, fragmentSource.c_str(), log);
+
+		GLint status = 0;
+		if (vs != 0 && gs != 0 && ps != 0) {
+			m_program = glCreateProgram();
+			glAttachShader(m_program, vs);
+			glAttachShader(m_program, gs);
+			glAttachShader(m_program, ps);
+			glLinkProgram(m_program);
+
+			glGetProgramiv(m_program, GL_LINK_STATUS, &status);
+			if (!status) {
+				char info[1024];
+				glGetProgramInfoLog(m_program, sizeof(info), nullptr, info);
+				log += info;
+				glDeleteProgram(m_program);
+				m_program = 0;
+			}
+		}
+		glDeleteShader(vs);
+		glDeleteShader(gs);
+		glDeleteShader(ps);
+
+		if (m_program == 0)
+			return false;
+
+		const char* names[] = { "iResolution", "iTime", "iTimeDelta", "iFrame", "iMouse" };
+		for (int i = 0; i < 5; i++)
+			m_uniforms[i] = glGetUniformLocation(m_program, names[i]);
+
+		glUseProgram(m_program);
+		for (int i = 0; i < 4; i++)
+			glUniform1i(glGetUniformLocation(m_program, ("iChannel" + std::to_string(i)).c_str()), i);
+		glUseProgram(0);
+
+		glGenVertexArrays(1, &m_vao);
+		glGenFramebuffers(1, &m_fbo);
+
+		return true;
+	}
+	void CubemapPass::Destroy()
+	{
+		if (m_program != 0)
+			glDeleteProgram(m_program);
+		if (m_vao != 0)
+			glDeleteVertexArrays(1, &m_vao);
+		if (m_fbo != 0)
+			glDeleteFramebuffers(1, &m_fbo);
+		m_program = m_vao = m_fbo = 0;
+	}
+	void CubemapPass::Render(CubemapBuffer& target, float time, float timeDelta, int frame, const CubemapChannel(&channels)[4])
+	{
+		if (m_program == 0 || target.GetSize() == 0)
+			return;
+
+		// the host's state is restored after the draw
+		GLint oldFBO = 0, oldViewport[4];
+		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &oldFBO);
+		glGetIntegerv(GL_VIEWPORT, oldViewport);
+
+		// the whole cubemap is attached - the geometry shader picks the face with gl_Layer
+		glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+		glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, target.GetRenderTarget(), 0);
+		glViewport(0, 0, target.GetSize(), target.GetSize());
+		glDisable(GL_DEPTH_TEST);
+		glDisable(GL_BLEND);
+		glDisable(GL_CULL_FACE);
+
+		glUseProgram(m_program);
+		glUniform2f(m_uniforms[0], (float)target.GetSize(), (float)target.GetSize());
+		glUniform1f(m_uniforms[1], time);
+		glUniform1f(m_uniforms[2], timeDelta);
+		glUniform1i(m_uniforms[3], frame);
+		glUniform4f(m_uniforms[4], 0.0f, 0.0f, 0.0f, 0.0f);
+
+		for (int i = 0; i < 4; i++) {
+			glActiveTexture(GL_TEXTURE0 + i);
+			if (channels[i].Texture != 0)
+				glBindTexture(channels[i].Target, channels[i].Texture);
+		}
+
+		glBindVertexArray(m_vao);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glBindVertexArray(0);
+		glUseProgram(0);
+
+		for (int i = 0; i < 4; i++) {
+			glActiveTexture(GL_TEXTURE0 + i);
+			if (channels[i].Texture != 0)
+				glBindTexture(channels[i].Target, 0);
+		}
+		glActiveTexture(GL_TEXTURE0);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, oldFBO);
+		glViewport(oldViewport[0], oldViewport[1], oldViewport[2], oldViewport[3]);
+
+		if (target.HasMipmaps()) {
+			glBindTexture(GL_TEXTURE_CUBE_MAP, target.GetRenderTarget());
+			glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+			glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+		}
+
+		target.Swap();
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "RenderPass.h"
+#include <vector>
+#include <string>
+
+#define CUBEMAP_BUFFER_SIZE 1024 // face size of Shadertoy's cube buffers
+
+namespace st
+{
+	/* fragment shader of a layered draw - the face comes from the geometry shader and mainCubemap gets the ray of
+	   the pixel in GL_TEXTURE_CUBE_MAP_POSITIVE_X + face order; common is placed on the 3rd line */
+	std::string GenerateCubemapShader(const RenderPass& pass, const std::string& code, const std::string& common);
+
+	/* RGBA16F cube texture, feedback passes write to a second one that is swapped after each frame */
+	class CubemapBuffer
+	{
+	public:
+		CubemapBuffer();
+		~CubemapBuffer();
+
+		bool Create(int size, const std::string& filter, bool doubleBuffered);
+		void Destroy();
+
+		void Swap();
+
+		inline int GetSize() const { return m_size; }
+		inline bool HasMipmaps() const { return m_mipmaps; }
+		inline unsigned int GetTexture() const { return m_textures[m_current]; } // last rendered
+		inline unsigned int GetRenderTarget() const { return m_textures[m_doubleBuffered ? 1 - m_current : m_current]; }
+
+	private:
+		unsigned int m_textures[2];
+		int m_current;
+		int m_size;
+		bool m_mipmaps, m_doubleBuffered;
+	};
+
+	struct CubemapChannel
+	{
+		unsigned int Target; // GL_TEXTURE_2D, GL_TEXTURE_CUBE_MAP, ...
+		unsigned int Texture;
+	};
+
+	/* renders all six faces of a CubemapBuffer with one draw call */
+	class CubemapPass
+	{
+	public:
+		CubemapPass();
+		~CubemapPass();
+
+		bool Compile(const std::string& fragmentSource, std::string& log);
+		void Destroy();
+
+		void Render(CubemapBuffer& target, float time, float timeDelta, int frame, const CubemapChannel(&channels)[4]);
+
+	private:
+		unsigned int m_program, m_vao, m_fbo;
+		int m_uniforms[5]; // iResolution, iTime, iTimeDelta, iFrame, iMouse
+	};
+}
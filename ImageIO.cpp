@@ -0,0 +1,523 @@
+#include "ImageIO.h"
+#include <png.h>
+#include <cstdio>
+#include <jpeglib.h>
+#include <algorithm>
+#include <csetjmp>
+#include <cstring>
+#include <cmath>
+#include <thread>
+#include <functional>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ST_USE_SSE2
+#endif
+
+#define VOLUME_HEADER_SIZE 20 // Shadertoy .bin header
+
+namespace st
+{
+	/////// PNG ///////
+	bool DecodePNG(const std::string& fileData, Image& img)
+	{
+		png_image image;
+		memset(&image, 0, sizeof(image));
+		image.version = PNG_IMAGE_VERSION;
+
+		if (!png_image_begin_read_from_memory(&image, fileData.data(), fileData.size()))
+			return false;
+
+		image.format = PNG_FORMAT_RGBA;
+		img.Width = image.width;
+		img.Height = image.height;
+		img.Data.resize(PNG_IMAGE_SIZE(image));
+
+		if (!png_image_finish_read(&image, nullptr, img.Data.data(), 0, nullptr)) {
+			png_image_free(&image);
+			return false;
+		}
+		return true;
+	}
+	bool WritePNG(const std::string& path, const Image& img)
+	{
+		png_image image;
+		memset(&image, 0, sizeof(image));
+		image.version = PNG_IMAGE_VERSION;
+		image.width = img.Width;
+		image.height = img.Height;
+		image.format = PNG_FORMAT_RGBA;
+
+		return png_image_write_to_file(&image, path.c_str(), 0, img.Data.data(), 0, nullptr) != 0;
+	}
+
+	/////// JPEG ///////
+	struct JPEGError
+	{
+		jpeg_error_mgr Manager;
+		jmp_buf Jump;
+	};
+	void JPEGErrorExit(j_common_ptr cinfo)
+	{
+		longjmp(((JPEGError*)cinfo->err)->Jump, 1);
+	}
+	bool DecodeJPEG(const std::string& fileData, Image& img)
+	{
+		jpeg_decompress_struct cinfo;
+		JPEGError err;
+		cinfo.err = jpeg_std_error(&err.Manager);
+		err.Manager.error_exit = JPEGErrorExit;
+
+		std::vector<unsigned char> row;
+		if (setjmp(err.Jump)) {
+			jpeg_destroy_decompress(&cinfo);
+			return false;
+		}
+
+		jpeg_create_decompress(&cinfo);
+		jpeg_mem_src(&cinfo, (unsigned char*)fileData.data(), fileData.size());
+		jpeg_read_header(&cinfo, TRUE);
+		cinfo.out_color_space = JCS_RGB; // also expands grayscale images
+		jpeg_start_decompress(&cinfo);
+
+		img.Width = cinfo.output_width;
+		img.Height = cinfo.output_height;
+		img.Data.resize((size_t)img.Width * img.Height * 4);
+		row.resize((size_t)img.Width * 3);
+
+		while (cinfo.output_scanline < cinfo.output_height) {
+			unsigned char* rowPtr = row.data();
+			unsigned char* dst = img.Data.data() + (size_t)cinfo.output_scanline * img.Width * 4;
+			jpeg_read_scanlines(&cinfo, &rowPtr, 1);
+
+			for (int x = 0; x < img.Width; x++) {
+				dst[x * 4 + 0] = row[x * 3 + 0];
+				dst[x * 4 + 1] = row[x * 3 + 1];
+				dst[x * 4 + 2] = row[x * 3 + 2];
+				dst[x * 4 + 3] = 255;
+			}
+		}
+
+		jpeg_finish_decompress(&cinfo);
+		jpeg_destroy_decompress(&cinfo);
+		return true;
+	}
+
+	bool DecodeImage(const std::string& fileData, Image& img)
+	{
+		const unsigned char pngSignature[] = { 0x89, 'P', 'N', 'G' };
+		const unsigned char jpegSignature[] = { 0xFF, 0xD8 };
+
+		if (fileData.size() >= 4 && memcmp(fileData.data(), pngSignature, 4) == 0)
+			return DecodePNG(fileData, img);
+		if (fileData.size() >= 2 && memcmp(fileData.data(), jpegSignature, 2) == 0)
+			return DecodeJPEG(fileData, img);
+
+		return false;
+	}
+
+	/////// PIXEL OPERATIONS ///////
+	void FlipVertical(Image& img)
+	{
+		size_t rowSize = (size_t)img.Width * 4;
+		for (int y = 0; y < img.Height / 2; y++) {
+			unsigned char* top = img.Data.data() + y * rowSize;
+			unsigned char* bottom = img.Data.data() + (img.Height - 1 - y) * rowSize;
+
+			size_t x = 0;
+#ifdef ST_USE_SSE2
+			for (; x + 16 <= rowSize; x += 16) {
+				__m128i a = _mm_loadu_si128((const __m128i*)(top + x));
+				__m128i b = _mm_loadu_si128((const __m128i*)(bottom + x));
+				_mm_storeu_si128((__m128i*)(top + x), b);
+				_mm_storeu_si128((__m128i*)(bottom + x), a);
+			}
+#endif
+			std::swap_ranges(top + x, top + rowSize, bottom + x);
+		}
+	}
+	std::vector<unsigned char> BuildSRGBTable()
+	{
+		std::vector<unsigned char> ret(256);
+		for (int i = 0; i < 256; i++) {
+			float c = i / 255.0f;
+			float linear = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+			ret[i] = (unsigned char)(linear * 255.0f + 0.5f);
+		}
+		return ret;
+	}
+	void ConvertSRGBToLinear(Image& img)
+	{
+		static const std::vector<unsigned char> lut = BuildSRGBTable();
+
+		size_t count = img.Data.size();
+		unsigned char* data = img.Data.data();
+		for (size_t i = 0; i < count; i += 4) {
+			data[i + 0] = lut[data[i + 0]];
+			data[i + 1] = lut[data[i + 1]];
+			data[i + 2] = lut[data[i + 2]];
+		}
+	}
+
+	/////// MIPMAPS ///////
+	std::vector<float> BuildLinearTable()
+	{
+		std::vector<float> ret(256);
+		for (int i = 0; i < 256; i++) {
+			float c = i / 255.0f;
+			ret[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+		}
+		return ret;
+	}
+	std::vector<unsigned char> BuildEncodeTable()
+	{
+		// linear [0, 1] in 4096 steps -> sRGB
+		std::vector<unsigned char> ret(4096);
+		for (int i = 0; i < 4096; i++) {
+			float c = i / 4095.0f;
+			float srgb = c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+			ret[i] = (unsigned char)(srgb * 255.0f + 0.5f);
+		}
+		return ret;
+	}
+	void DownsampleRows(const Image& src, Image& dst, bool srgb, int rowBegin, int rowEnd)
+	{
+		static const std::vector<float> toLinear = BuildLinearTable();
+		static const std::vector<unsigned char> toSRGB = BuildEncodeTable();
+
+		size_t srcPitch = (size_t)src.Width * 4;
+		for (int y = rowBegin; y < rowEnd; y++) {
+			const unsigned char* row0 = src.Data.data() + std::min(y * 2, src.Height - 1) * srcPitch;
+			const unsigned char* row1 = src.Data.data() + std::min(y * 2 + 1, src.Height - 1) * srcPitch;
+			unsigned char* out = dst.Data.data() + (size_t)y * dst.Width * 4;
+
+			int x = 0;
+#ifdef ST_USE_SSE2
+			// 4 source pixels of both rows -> 2 destination pixels
+			if (!srgb) {
+				for (; x * 2 + 3 < src.Width && x + 1 < dst.Width; x += 2) {
+					__m128i a = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+					__m128i b = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+					__m128i v = _mm_avg_epu8(a, b);
+					__m128i even = _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 0, 2, 0));
+					__m128i odd = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 1, 3, 1));
+					_mm_storel_epi64((__m128i*)(out + x * 4), _mm_avg_epu8(even, odd));
+				}
+			}
+#endif
+			for (; x < dst.Width; x++) {
+				int x0 = std::min(x * 2, src.Width - 1) * 4;
+				int x1 = std::min(x * 2 + 1, src.Width - 1) * 4;
+				for (int c = 0; c < 4; c++) {
+					if (srgb && c < 3) {
+						float sum = toLinear[row0[x0 + c]] + toLinear[row0[x1 + c]] + toLinear[row1[x0 + c]] + toLinear[row1[x1 + c]];
+						out[x * 4 + c] = toSRGB[(int)(sum * 0.25f * 4095.0f + 0.5f)];
+					} else
+						out[x * 4 + c] = (row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4;
+				}
+			}
+		}
+	}
+	void GenerateMipmaps(const Image& img, bool srgb, std::vector<Image>& mips)
+	{
+		mips.clear();
+		mips.push_back(img);
+
+		unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+		while (mips.back().Width > 1 || mips.back().Height > 1) {
+			const Image& src = mips.back();
+
+			Image dst;
+			dst.Width = std::max(1, src.Width / 2);
+			dst.Height = std::max(1, src.Height / 2);
+			dst.Data.resize((size_t)dst.Width * dst.Height * 4);
+
+			// small levels aren't worth a thread
+			int workers = std::min<int>(threadCount, std::max(1, dst.Height / 32));
+			std::vector<std::thread> threads;
+			int rowsPerWorker = (dst.Height + workers - 1) / workers;
+			for (int i = 1; i < workers; i++)
+				threads.push_back(std::thread(DownsampleRows, std::cref(src), std::ref(dst), srgb, i * rowsPerWorker, std::min(dst.Height, (i + 1) * rowsPerWorker)));
+			DownsampleRows(src, dst, srgb, 0, std::min(dst.Height, rowsPerWorker));
+			for (auto& thread : threads)
+				thread.join();
+
+			mips.push_back(std::move(dst));
+		}
+	}
+
+	/////// RESIZE ///////
+	void ParallelRows(int rows, const std::function<void(int, int)>& func)
+	{
+		unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+		int workers = std::min<int>(threadCount, std::max(1, rows / 32));
+		int rowsPerWorker = (rows + workers - 1) / workers;
+
+		std::vector<std::thread> threads;
+		for (int i = 1; i < workers; i++)
+			threads.push_back(std::thread(func, i * rowsPerWorker, std::min(rows, (i + 1) * rowsPerWorker)));
+		func(0, std::min(rows, rowsPerWorker));
+		for (auto& thread : threads)
+			thread.join();
+	}
+	float MitchellFilter(float x)
+	{
+		// B = C = 1/3
+		x = fabsf(x);
+		if (x < 1.0f)
+			return (7.0f * x * x * x - 12.0f * x * x + 16.0f / 3.0f) / 6.0f;
+		if (x < 2.0f)
+			return (-7.0f / 3.0f * x * x * x + 12.0f * x * x - 20.0f * x + 32.0f / 3.0f) / 6.0f;
+		return 0.0f;
+	}
+	struct FilterTaps
+	{
+		std::vector<int> Start; // first source texel of every destination texel
+		int Count;
+		std::vector<float> Weights; // Count weights per destination texel, the taps past the edge are clamped
+	};
+	FilterTaps BuildFilterTaps(int srcSize, int dstSize)
+	{
+		float scale = (float)srcSize / dstSize;
+		float stretch = std::max(1.0f, scale);
+
+		FilterTaps ret;
+		ret.Count = (int)ceilf(2.0f * stretch) * 2 + 1;
+		ret.Start.resize(dstSize);
+		ret.Weights.resize((size_t)dstSize * ret.Count);
+		for (int i = 0; i < dstSize; i++) {
+			float center = (i + 0.5f) * scale - 0.5f;
+			int start = (int)floorf(center) - ret.Count / 2;
+			ret.Start[i] = start;
+
+			float sum = 0.0f;
+			float* weights = ret.Weights.data() + (size_t)i * ret.Count;
+			for (int t = 0; t < ret.Count; t++) {
+				weights[t] = MitchellFilter((start + t - center) / stretch);
+				sum += weights[t];
+			}
+			for (int t = 0; t < ret.Count; t++)
+				weights[t] /= sum;
+		}
+		return ret;
+	}
+	void ResizeImage(const Image& img, int width, int height, bool srgb, Image& out)
+	{
+		static const std::vector<float> toLinear = BuildLinearTable();
+		static const std::vector<unsigned char> toSRGB = BuildEncodeTable();
+
+		FilterTaps tapsX = BuildFilterTaps(img.Width, width);
+		FilterTaps tapsY = BuildFilterTaps(img.Height, height);
+
+		// horizontal pass into a [0, 1] float image, color is linearized first
+		std::vector<float> temp((size_t)width * img.Height * 4);
+		ParallelRows(img.Height, [&](int rowBegin, int rowEnd) {
+			for (int y = rowBegin; y < rowEnd; y++) {
+				const unsigned char* src = img.Data.data() + (size_t)y * img.Width * 4;
+				float* dst = temp.data() + (size_t)y * width * 4;
+				for (int x = 0; x < width; x++) {
+					const float* weights = tapsX.Weights.data() + (size_t)x * tapsX.Count;
+					float sum[4] = { 0, 0, 0, 0 };
+					for (int t = 0; t < tapsX.Count; t++) {
+						const unsigned char* px = src + std::min(std::max(tapsX.Start[x] + t, 0), img.Width - 1) * 4;
+						for (int c = 0; c < 4; c++)
+							sum[c] += weights[t] * (srgb && c < 3 ? toLinear[px[c]] : px[c] / 255.0f);
+					}
+					for (int c = 0; c < 4; c++)
+						dst[x * 4 + c] = sum[c];
+				}
+			}
+		});
+
+		out.Width = width;
+		out.Height = height;
+		out.Data.resize((size_t)width * height * 4);
+		ParallelRows(height, [&](int rowBegin, int rowEnd) {
+			for (int y = rowBegin; y < rowEnd; y++) {
+				const float* weights = tapsY.Weights.data() + (size_t)y * tapsY.Count;
+				unsigned char* dst = out.Data.data() + (size_t)y * width * 4;
+				for (int x = 0; x < width * 4; x++) {
+					float sum = 0.0f;
+					for (int t = 0; t < tapsY.Count; t++) {
+						int row = std::min(std::max(tapsY.Start[y] + t, 0), img.Height - 1);
+						sum += weights[t] * temp[(size_t)row * width * 4 + x];
+					}
+
+					// the negative lobes can overshoot
+					sum = std::min(1.0f, std::max(0.0f, sum));
+					if (srgb && x % 4 < 3)
+						dst[x] = toSRGB[(int)(sum * 4095.0f + 0.5f)];
+					else
+						dst[x] = (unsigned char)(sum * 255.0f + 0.5f);
+				}
+			}
+		});
+	}
+
+	/////// DDS ///////
+	bool WriteRGBADDS(const std::string& path, const std::vector<Image>* faces, int faceCount)
+	{
+		const std::vector<Image>& mips = faces[0];
+		if (mips.empty())
+			return false;
+
+		DDSHeader header;
+		memset(&header, 0, sizeof(header));
+		header.Size = sizeof(DDSHeader);
+		header.Flags = 0x1 | 0x2 | 0x4 | 0x8 | 0x1000 | (mips.size() > 1 ? 0x20000 : 0); // caps, height, width, pitch, pixel format, mip count
+		header.Height = mips[0].Height;
+		header.Width = mips[0].Width;
+		header.PitchOrLinearSize = mips[0].Width * 4;
+		header.MipMapCount = mips.size();
+		header.PixelFormat.Size = sizeof(DDSPixelFormat);
+		header.PixelFormat.Flags = 0x40 | 0x1; // RGB, alpha pixels
+		header.PixelFormat.RGBBitCount = 32;
+		header.PixelFormat.RBitMask = 0x000000FF;
+		header.PixelFormat.GBitMask = 0x0000FF00;
+		header.PixelFormat.BBitMask = 0x00FF0000;
+		header.PixelFormat.ABitMask = 0xFF000000;
+		header.Caps = 0x1000 | (mips.size() > 1 ? 0x8 | 0x400000 : 0); // texture, complex, mipmap
+		if (faceCount == 6) {
+			header.Caps |= 0x8;
+			header.Caps2 = 0x200 | 0xFC00; // cubemap with all faces
+		}
+
+		FILE* file = fopen(path.c_str(), "wb");
+		if (file == nullptr)
+			return false;
+
+		// every face is stored with its whole mip chain
+		bool ok = fwrite("DDS ", 1, 4, file) == 4 && fwrite(&header, sizeof(header), 1, file) == 1;
+		for (int i = 0; i < faceCount; i++) {
+			ok = ok && faces[i].size() == mips.size();
+			for (const auto& mip : faces[i])
+				ok = ok && fwrite(mip.Data.data(), 1, mip.Data.size(), file) == mip.Data.size();
+		}
+
+		fclose(file);
+		return ok;
+	}
+	bool WriteDDS(const std::string& path, const std::vector<Image>& mips)
+	{
+		return WriteRGBADDS(path, &mips, 1);
+	}
+	bool WriteCubeDDS(const std::string& path, const std::vector<Image> (&faces)[6])
+	{
+		return WriteRGBADDS(path, faces, 6);
+	}
+
+	/////// VOLUMES ///////
+	unsigned int GetVolumeDXGIFormat(const VolumeHeader& header)
+	{
+		// R8, RG8, RGBA8 / R32F, RG32F, RGB32F, RGBA32F
+		if (header.Format == 0)
+			return header.Channels == 1 ? 61 : (header.Channels == 2 ? 49 : (header.Channels == 4 ? 28 : 0));
+		if (header.Format == 10)
+			return header.Channels == 1 ? 41 : (header.Channels == 2 ? 16 : (header.Channels == 3 ? 6 : 2));
+		return 0;
+	}
+	unsigned int ReadUInt(const unsigned char* data, int bytes)
+	{
+		unsigned int ret = 0;
+		for (int i = 0; i < bytes; i++)
+			ret |= (unsigned int)data[i] << (i * 8);
+		return ret;
+	}
+
+	VolumeConverter::~VolumeConverter()
+	{
+		if (m_file != nullptr)
+			fclose(m_file);
+	}
+	bool VolumeConverter::Open(const std::string& path)
+	{
+		Close();
+		m_path = path;
+		m_headerData.clear();
+		m_remaining = 0;
+		m_failed = false;
+		memset(&m_header, 0, sizeof(m_header));
+		return true;
+	}
+	bool VolumeConverter::Write(const char* data, size_t size)
+	{
+		if (m_failed)
+			return false;
+
+		// the header can be split between chunks
+		if (m_file == nullptr) {
+			size_t headerBytes = std::min(size, VOLUME_HEADER_SIZE - m_headerData.size());
+			m_headerData.append(data, headerBytes);
+			data += headerBytes;
+			size -= headerBytes;
+
+			if (m_headerData.size() < VOLUME_HEADER_SIZE)
+				return true;
+			if (!m_writeHeader()) {
+				m_failed = true;
+				return false;
+			}
+		}
+
+		// anything past the texels is ignored
+		size_t texelBytes = (size_t)std::min<unsigned long long>(size, m_remaining);
+		if (fwrite(data, 1, texelBytes, m_file) != texelBytes) {
+			m_failed = true;
+			return false;
+		}
+		m_remaining -= texelBytes;
+		return true;
+	}
+	bool VolumeConverter::Close()
+	{
+		bool ok = !m_failed && m_file != nullptr && m_remaining == 0;
+		if (m_file != nullptr)
+			ok &= fclose(m_file) == 0;
+		m_file = nullptr;
+		return ok;
+	}
+	bool VolumeConverter::m_writeHeader()
+	{
+		// uint32 signature, width, height, depth, uint8 channels, uint8 layout, uint16 format
+		const unsigned char* data = (const unsigned char*)m_headerData.data();
+		m_header.Width = ReadUInt(data + 4, 4);
+		m_header.Height = ReadUInt(data + 8, 4);
+		m_header.Depth = ReadUInt(data + 12, 4);
+		m_header.Channels = data[16];
+		m_header.Format = ReadUInt(data + 18, 2);
+
+		unsigned int dxgiFormat = GetVolumeDXGIFormat(m_header);
+		if (m_header.Width == 0 || m_header.Height == 0 || m_header.Depth == 0 || dxgiFormat == 0)
+			return false;
+
+		int texelSize = m_header.Channels * (m_header.Format == 10 ? 4 : 1);
+		m_remaining = (unsigned long long)m_header.Width * m_header.Height * m_header.Depth * texelSize;
+
+		DDSHeader header;
+		memset(&header, 0, sizeof(header));
+		header.Size = sizeof(DDSHeader);
+		header.Flags = 0x1 | 0x2 | 0x4 | 0x8 | 0x1000 | 0x800000; // caps, height, width, pitch, pixel format, depth
+		header.Height = m_header.Height;
+		header.Width = m_header.Width;
+		header.Depth = m_header.Depth;
+		header.PitchOrLinearSize = m_header.Width * texelSize;
+		header.MipMapCount = 1;
+		header.PixelFormat.Size = sizeof(DDSPixelFormat);
+		header.PixelFormat.Flags = 0x4; // fourCC
+		header.PixelFormat.FourCC = 'D' | ('X' << 8) | ('1' << 16) | ('0' << 24);
+		header.Caps = 0x1000 | 0x8; // texture, complex
+		header.Caps2 = 0x200000; // volume
+
+		DDSHeaderDX10 dx10;
+		memset(&dx10, 0, sizeof(dx10));
+		dx10.Format = dxgiFormat;
+		dx10.ResourceDimension = 4; // texture 3D
+		dx10.ArraySize = 1;
+
+		m_file = fopen(m_path.c_str(), "wb");
+		if (m_file == nullptr)
+			return false;
+
+		return fwrite("DDS ", 1, 4, m_file) == 4 && fwrite(&header, sizeof(header), 1, m_file) == 1 && fwrite(&dx10, sizeof(dx10), 1, m_file) == 1;
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <cstdio>
+
+namespace st
+{
+	/* 8 bit RGBA pixels, top row first */
+	struct Image
+	{
+		int Width;
+		int Height;
+		std::vector<unsigned char> Data;
+	};
+
+	/* PNG & JPEG, detected from the signature */
+	bool DecodeImage(const std::string& fileData, Image& img);
+	bool WritePNG(const std::string& path, const Image& img);
+
+	void FlipVertical(Image& img);
+	void ConvertSRGBToLinear(Image& img); // alpha is left untouched
+
+	/* separable Mitchell-Netravali filter, srgb filters the color in linear space, rows are split between threads */
+	void ResizeImage(const Image& img, int width, int height, bool srgb, Image& out);
+
+	/* DDS file headers (without the "DDS " magic) */
+	struct DDSPixelFormat
+	{
+		unsigned int Size, Flags, FourCC, RGBBitCount, RBitMask, GBitMask, BBitMask, ABitMask;
+	};
+	struct DDSHeader
+	{
+		unsigned int Size, Flags, Height, Width, PitchOrLinearSize, Depth, MipMapCount;
+		unsigned int Reserved1[11];
+		DDSPixelFormat PixelFormat;
+		unsigned int Caps, Caps2, Caps3, Caps4, Reserved2;
+	};
+	struct DDSHeaderDX10
+	{
+		unsigned int Format, ResourceDimension, MiscFlag, ArraySize, MiscFlags2;
+	};
+
+	/* level 0 is the image itself - srgb averages the color in linear space, rows are split between threads */
+	void GenerateMipmaps(const Image& img, bool srgb, std::vector<Image>& mips);
+	bool WriteDDS(const std::string& path, const std::vector<Image>& mips);
+	bool WriteCubeDDS(const std::string& path, const std::vector<Image> (&faces)[6]); // +X, -X, +Y, -Y, +Z, -Z mip chains
+
+	/* Shadertoy .bin volume header, followed by the texels (x changes the fastest, then y, then z) */
+	struct VolumeHeader
+	{
+		unsigned int Width, Height, Depth;
+		int Channels;
+		int Format; // 0 = 8 bit unorm, 10 = 32 bit float
+	};
+
+	/* converts a .bin volume to a DDS volume texture while it's being downloaded - only the header is
+	   buffered, the texels are written to the file as they arrive */
+	class VolumeConverter
+	{
+	public:
+		VolumeConverter() : m_file(nullptr), m_remaining(0), m_failed(false) { }
+		~VolumeConverter();
+
+		bool Open(const std::string& path);
+		bool Write(const char* data, size_t size);
+		bool Close(); // false if the volume was invalid or incomplete
+
+		inline const VolumeHeader& GetHeader() const { return m_header; }
+
+	private:
+		bool m_writeHeader();
+
+		std::string m_path;
+		FILE* m_file;
+		std::string m_headerData;
+		VolumeHeader m_header;
+		unsigned long long m_remaining;
+		bool m_failed;
+	};
+}
@@ -0,0 +1,157 @@
+#include "MediaPack.h"
+#include <json11/json11.hpp>
+#include <ghc/filesystem.hpp>
+#include <openssl/sha.h>
+#include <openssl/evp.h>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+namespace st
+{
+	std::string FormatDigest(const unsigned char* digest, unsigned int length)
+	{
+		std::string ret = "";
+		char hex[3];
+		for (unsigned int i = 0; i < length; i++) {
+			snprintf(hex, sizeof(hex), "%02x", digest[i]);
+			ret += hex;
+		}
+		return ret;
+	}
+	std::string HashSHA256(const std::string& data)
+	{
+		unsigned char digest[SHA256_DIGEST_LENGTH];
+		SHA256((const unsigned char*)data.data(), data.size(), digest);
+		return FormatDigest(digest, SHA256_DIGEST_LENGTH);
+	}
+
+	void MediaPack::Create(const std::string& dir)
+	{
+		m_dir = dir;
+		m_revision = 0;
+		m_assets.clear();
+	}
+	bool MediaPack::Load(const std::string& dir)
+	{
+		Create(dir);
+
+		std::ifstream file(dir + "/" MEDIA_PACK_INDEX);
+		if (!file.is_open())
+			return false;
+
+		std::stringstream ss;
+		ss << file.rdbuf();
+
+		std::string err;
+		json11::Json index = json11::Json::parse(ss.str(), err);
+		if (!err.empty() || index["version"].int_value() != MEDIA_PACK_VERSION)
+			return false;
+
+		m_revision = index["revision"].int_value();
+		for (const auto& item : index["assets"].array_items()) {
+			MediaAsset asset;
+			asset.Source = item["source"].string_value();
+			asset.File = item["file"].string_value();
+			asset.Hash = item["sha256"].string_value();
+			asset.Size = (size_t)item["size"].number_value();
+			m_assets[asset.Source] = asset;
+		}
+
+		return true;
+	}
+	bool MediaPack::Save() const
+	{
+		std::vector<json11::Json> assets;
+		for (const auto& pair : m_assets) {
+			const MediaAsset& asset = pair.second;
+			assets.push_back(json11::Json::object {
+				{ "source", asset.Source },
+				{ "file", asset.File },
+				{ "sha256", asset.Hash },
+				{ "size", (double)asset.Size }
+			});
+		}
+
+		json11::Json index = json11::Json::object {
+			{ "version", MEDIA_PACK_VERSION },
+			{ "revision", m_revision },
+			{ "assets", assets }
+		};
+
+		std::ofstream file(m_dir + "/" MEDIA_PACK_INDEX);
+		if (!file.is_open())
+			return false;
+		file << index.dump();
+		return file.good();
+	}
+	bool MediaPack::Get(const std::string& source, std::string& data) const
+	{
+		data.clear();
+		return Read(source, [&data](const char* chunk, size_t size) {
+			data.append(chunk, size);
+			return true;
+		});
+	}
+	bool MediaPack::Read(const std::string& source, const std::function<bool(const char*, size_t)>& receiver) const
+	{
+		auto it = m_assets.find(source);
+		if (it == m_assets.end())
+			return false;
+
+		std::ifstream file(m_dir + "/" + it->second.File, std::ifstream::binary);
+		if (!file.is_open())
+			return false;
+
+		EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+		EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr);
+
+		std::vector<char> chunk(64 * 1024);
+		size_t total = 0;
+		bool ok = true;
+		while (ok && file) {
+			file.read(chunk.data(), chunk.size());
+			size_t size = file.gcount();
+			if (size == 0)
+				break;
+
+			EVP_DigestUpdate(ctx, chunk.data(), size);
+			ok = receiver(chunk.data(), size);
+			total += size;
+		}
+
+		unsigned char digest[EVP_MAX_MD_SIZE];
+		unsigned int digestLength = 0;
+		EVP_DigestFinal_ex(ctx, digest, &digestLength);
+		EVP_MD_CTX_free(ctx);
+
+		return ok && total == it->second.Size && FormatDigest(digest, digestLength) == it->second.Hash;
+	}
+	bool MediaPack::Add(const std::string& source, const std::string& data)
+	{
+		// only Shadertoy's media files, the path must stay inside of the pack
+		if (source.compare(0, 7, "/media/") != 0 || source.find("..") != std::string::npos || source.find('\\') != std::string::npos)
+			return false;
+
+		// /media/a/file.png -> media/a/file.png
+		MediaAsset asset;
+		asset.Source = source;
+		asset.File = source.substr(1);
+		asset.Hash = HashSHA256(data);
+		asset.Size = data.size();
+
+		ghc::filesystem::path path = ghc::filesystem::path(m_dir) / asset.File;
+		std::error_code ec;
+		ghc::filesystem::create_directories(path.parent_path(), ec);
+
+		std::ofstream file(path.string(), std::ofstream::binary);
+		if (!file.is_open())
+			return false;
+		file.write(data.data(), data.size());
+		if (!file.good())
+			return false;
+
+		m_assets[source] = asset;
+		return true;
+	}
+}
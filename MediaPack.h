@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <string>
+#include <map>
+#include <functional>
+
+#define MEDIA_PACK_VERSION 1 // format of the index, packs with a different version are ignored
+#define MEDIA_PACK_INDEX "index.json"
+
+namespace st
+{
+	struct MediaAsset
+	{
+		std::string Source; // path on shadertoy.com, e.g. /media/a/<hash>.png
+		std::string File; // relative to the pack directory
+		std::string Hash; // SHA-256 of the file, hex
+		size_t Size;
+	};
+
+	/* local copies of the Shadertoy stock media - a directory with the files and an index.json
+	   that maps the source paths to them */
+	class MediaPack
+	{
+	public:
+		MediaPack() : m_revision(0) { }
+
+		bool Load(const std::string& dir);
+		bool Save() const;
+		void Create(const std::string& dir);
+
+		/* false if the asset isn't packed or its file doesn't match the hash */
+		bool Get(const std::string& source, std::string& data) const;
+		bool Read(const std::string& source, const std::function<bool(const char*, size_t)>& receiver) const; // in chunks, the hash is checked at the end
+		bool Add(const std::string& source, const std::string& data); // (over)writes the file
+
+		inline const std::map<std::string, MediaAsset>& GetAssets() const { return m_assets; }
+		inline const std::string& GetDirectory() const { return m_dir; }
+		inline int GetRevision() const { return m_revision; }
+		inline void SetRevision(int rev) { m_revision = rev; }
+
+	private:
+		std::string m_dir;
+		int m_revision; // incremented by every refresh of the pack
+		std::map<std::string, MediaAsset> m_assets;
+	};
+
+	std::string HashSHA256(const std::string& data);
+}
@@ -0,0 +1,73 @@
+#include "MediaPack.h"
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+
+#define CPPHTTPLIB_OPENSSL_SUPPORT
+#include <httplib/httplib.h>
+
+/* builds & refreshes the local media pack that the importer reads the stock textures from:
+	mediapack <pack directory> [--refresh] [/media/a/<file>...] [@<file with one source per line>] */
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		printf("usage: %s <pack directory> [--refresh] [/media/a/<file>...] [@<source list>]\n", argv[0]);
+		return 1;
+	}
+
+	st::MediaPack pack;
+	if (!pack.Load(argv[1]))
+		pack.Create(argv[1]);
+
+	bool refresh = false;
+	std::vector<std::string> sources;
+	for (int i = 2; i < argc; i++) {
+		if (strcmp(argv[i], "--refresh") == 0)
+			refresh = true;
+		else if (argv[i][0] == '@') {
+			std::ifstream list(argv[i] + 1);
+			std::string line;
+			while (std::getline(list, line))
+				if (!line.empty() && line[0] == '/')
+					sources.push_back(line.substr(0, line.find_last_not_of(" \t\r") + 1));
+		} else
+			sources.push_back(argv[i]);
+	}
+
+	// refreshing downloads everything that is already in the pack again
+	if (refresh)
+		for (const auto& pair : pack.GetAssets())
+			sources.push_back(pair.first);
+	std::sort(sources.begin(), sources.end());
+	sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+
+	httplib::SSLClient cli("www.shadertoy.com");
+	int added = 0, failed = 0;
+	for (const auto& source : sources) {
+		std::string data;
+		if (!refresh && pack.Get(source, data))
+			continue;
+
+		auto res = cli.Get(source.c_str());
+		if (!res || res->status != 200 || !pack.Add(source, res->body)) {
+			printf("failed: %s\n", source.c_str());
+			failed++;
+			continue;
+		}
+
+		printf("%s %s\n", refresh ? "refreshed:" : "added:", source.c_str());
+		added++;
+	}
+
+	if (added > 0) {
+		pack.SetRevision(pack.GetRevision() + 1);
+		if (!pack.Save()) {
+			printf("failed to write %s/" MEDIA_PACK_INDEX "\n", argv[1]);
+			return 1;
+		}
+	}
+
+	printf("%d assets, revision %d (%d downloaded, %d failed)\n", (int)pack.GetAssets().size(), pack.GetRevision(), added, failed);
+	return failed > 0 ? 1 : 0;
+}
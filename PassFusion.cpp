@@ -0,0 +1,299 @@
+#include "PassFusion.h"
+#include "ShaderAnalyzer.h"
+#include <algorithm>
+#include <sstream>
+#include <set>
+
+namespace st
+{
+	bool IsIdentifierChar(char c)
+	{
+		return isalnum((unsigned char)c) || c == '_';
+	}
+	std::string ReplaceIdentifiers(const std::string& code, const std::map<std::string, std::string>& names)
+	{
+		std::string ret = "";
+		size_t i = 0;
+		while (i < code.size()) {
+			if (!IsIdentifierChar(code[i])) {
+				ret += code[i];
+				i++;
+				continue;
+			}
+
+			size_t start = i;
+			while (i < code.size() && IsIdentifierChar(code[i]))
+				i++;
+
+			std::string word = code.substr(start, i - start);
+			auto it = names.find(word);
+			ret += it == names.end() ? word : it->second;
+		}
+		return ret;
+	}
+	std::string GetSafeName(const std::string& name)
+	{
+		std::string ret = name;
+		for (char& c : ret)
+			if (!IsIdentifierChar(c))
+				c = '_';
+		return ret;
+	}
+
+	/////// PATTERN MATCHING ///////
+	bool MatchScreenUV(const std::vector<Token>& tokens, size_t& i, const std::string& fragCoord, const std::set<std::string>& uvVars)
+	{
+		// uv, fragCoord / iResolution, fragCoord.xy / iResolution.xy
+		if (i < tokens.size() && uvVars.count(tokens[i].Text) > 0) {
+			i++;
+			return true;
+		}
+
+		size_t j = i;
+		if (!MatchFragCoord(tokens, j, fragCoord) || !MatchSequence(tokens, j, { "/", "iResolution" }))
+			return false;
+		MatchSequence(tokens, j, { ".", "xy" });
+
+		i = j;
+		return true;
+	}
+	bool MatchPointRead(const std::vector<Token>& tokens, size_t i, const std::string& channel, const std::string& fragCoord, const std::set<std::string>& uvVars, size_t& end)
+	{
+		// texelFetch(iChannelN, ivec2(fragCoord), 0)
+		size_t j = i;
+		if (MatchSequence(tokens, j, { "texelFetch", "(", channel, ",", "ivec2", "(" }) && MatchFragCoord(tokens, j, fragCoord) && MatchSequence(tokens, j, { ")", ",", "0", ")" })) {
+			end = j;
+			return true;
+		}
+
+		// texture(iChannelN, fragCoord / iResolution.xy)
+		j = i;
+		if ((MatchSequence(tokens, j, { "texture", "(", channel, "," }) || MatchSequence(tokens, j, { "texture2D", "(", channel, "," })) &&
+			MatchScreenUV(tokens, j, fragCoord, uvVars) && MatchSequence(tokens, j, { ")" })) {
+			end = j;
+			return true;
+		}
+
+		return false;
+	}
+	std::set<std::string> GetGlobalNames(const std::vector<Token>& tokens, const std::vector<Define>& defines)
+	{
+		std::set<std::string> ret;
+
+		for (const auto& def : defines)
+			ret.insert(def.Name);
+
+		// float hash(...), const float PI = ..., struct Ray { ... }
+		int braceDepth = 0, parenDepth = 0;
+		for (size_t i = 0; i < tokens.size(); i++) {
+			const Token& tok = tokens[i];
+			if (tok.Text == "{") braceDepth++;
+			else if (tok.Text == "}") braceDepth--;
+			else if (tok.Text == "(") parenDepth++;
+			else if (tok.Text == ")") parenDepth--;
+			else if (braceDepth == 0 && parenDepth == 0 && i > 0 && i + 1 < tokens.size() && tok.Type == TokenType::Identifier && tokens[i - 1].Type == TokenType::Identifier) {
+				const std::string& next = tokens[i + 1].Text;
+				if (next == "(" || next == "=" || next == ";" || next == "[" || next == "," || next == "{")
+					ret.insert(tok.Text);
+			}
+		}
+
+		ret.erase("mainImage");
+
+		return ret;
+	}
+
+	/////// FUSION ///////
+	bool ReplacePointReads(const RenderPass& consumer, int channel, const std::string& color, std::string& code)
+	{
+		std::vector<Token> tokens;
+		std::vector<Define> defines;
+		TokenizeGLSL(consumer.Code, 0, tokens, defines);
+
+		size_t argsOpen = 0, bodyOpen = 0, bodyClose = 0;
+		if (!FindFunction(tokens, "mainImage", argsOpen, bodyOpen, bodyClose))
+			return false;
+
+		// void mainImage(out vec4 fragColor, in vec2 fragCoord)
+		std::string fragCoord = tokens[bodyOpen - 2].Text;
+		if (tokens[bodyOpen - 2].Type != TokenType::Identifier || IsModified(tokens, bodyOpen, bodyClose, fragCoord, tokens.size()))
+			return false;
+
+		// vec2 uv = fragCoord / iResolution.xy;
+		std::set<std::string> uvVars, noVars;
+		for (size_t i = bodyOpen; i + 3 < bodyClose; i++) {
+			if (tokens[i].Text != "vec2" || tokens[i + 1].Type != TokenType::Identifier || tokens[i + 2].Text != "=")
+				continue;
+
+			size_t j = i + 3;
+			if (MatchScreenUV(tokens, j, fragCoord, noVars) && j < bodyClose && tokens[j].Text == ";" && !IsModified(tokens, bodyOpen, bodyClose, tokens[i + 1].Text, i + 1))
+				uvVars.insert(tokens[i + 1].Text);
+		}
+
+		// every use of the channel has to be a read at the current pixel
+		std::string channelName = "iChannel" + std::to_string(channel);
+		std::vector<std::pair<size_t, size_t>> reads; // [begin, end) in the code
+		for (size_t i = 0; i < tokens.size(); i++) {
+			if (tokens[i].Text != channelName)
+				continue;
+
+			size_t end = 0;
+			if (i < 2 || i <= bodyOpen || i >= bodyClose || !MatchPointRead(tokens, i - 2, channelName, fragCoord, uvVars, end))
+				return false;
+
+			reads.push_back(std::make_pair(tokens[i - 2].Offset, tokens[end - 1].Offset + 1));
+		}
+		if (DirectivesUse(consumer.Code, channelName))
+			return false;
+
+		code = consumer.Code;
+		for (int i = reads.size() - 1; i >= 0; i--)
+			code.replace(reads[i].first, reads[i].second - reads[i].first, color);
+
+		return true;
+	}
+	bool FusePasses(const std::vector<RenderPass>& passes, int producerIndex, int consumerIndex, RenderPass& result)
+	{
+		const RenderPass& producer = passes[producerIndex];
+		const RenderPass& consumer = passes[consumerIndex];
+		int producerID = producer.Outputs[0].ID;
+
+		// passes are rendered from the last one to the first - the consumer has to read this frame's output
+		if (consumerIndex >= producerIndex)
+			return false;
+
+		// the consumer must bind the producer exactly once
+		int channel = -1;
+		for (const auto& inp : consumer.Inputs)
+			if (inp.Type == "buffer" && inp.ID == producerID) {
+				if (channel != -1)
+					return false;
+				channel = inp.Channel;
+			}
+		if (channel == -1)
+			return false;
+
+		// the producer's previous frame reads (its own output or a buffer that's rendered after it) would read this frame's
+		// content or a removed buffer once it's moved to the consumer
+		for (const auto& inp : producer.Inputs)
+			if (inp.Type == "buffer")
+				for (int i = 0; i <= producerIndex; i++)
+					for (const auto& out : passes[i].Outputs)
+						if (out.ID == inp.ID)
+							return false;
+
+		// name collisions
+		std::vector<Token> producerTokens, consumerTokens;
+		std::vector<Define> producerDefines, consumerDefines;
+		TokenizeGLSL(producer.Code, 0, producerTokens, producerDefines);
+		TokenizeGLSL(consumer.Code, 0, consumerTokens, consumerDefines);
+
+		for (const auto& tok : producerTokens)
+			if (tok.Text == "discard")
+				return false;
+
+		std::set<std::string> producerNames = GetGlobalNames(producerTokens, producerDefines);
+		std::set<std::string> consumerNames = GetGlobalNames(consumerTokens, consumerDefines);
+		for (const auto& name : producerNames)
+			if (consumerNames.count(name) > 0)
+				return false;
+
+		// producer's inputs get the channels that the consumer doesn't use
+		std::vector<ShaderInput> inputs;
+		bool usedChannels[4] = { false, false, false, false };
+		for (const auto& inp : consumer.Inputs)
+			if (inp.Channel != channel && inp.Channel >= 0 && inp.Channel < 4) {
+				inputs.push_back(inp);
+				usedChannels[inp.Channel] = true;
+			}
+
+		std::map<std::string, std::string> channelNames;
+		for (const auto& inp : producer.Inputs) {
+			int newChannel = -1;
+			for (const auto& other : inputs)
+				if (other.Type == inp.Type && other.ID == inp.ID && other.Source == inp.Source &&
+					other.Sampler.Filter == inp.Sampler.Filter && other.Sampler.Wrap == inp.Sampler.Wrap)
+					newChannel = other.Channel;
+
+			for (int i = 0; i < 4 && newChannel == -1; i++)
+				if (!usedChannels[i]) {
+					newChannel = i;
+					usedChannels[i] = true;
+
+					ShaderInput moved = inp;
+					moved.Channel = i;
+					inputs.push_back(moved);
+				}
+			if (newChannel == -1)
+				return false; // more than 4 inputs
+
+			channelNames["iChannel" + std::to_string(inp.Channel)] = "iChannel" + std::to_string(newChannel);
+		}
+
+		std::string producerName = GetSafeName(producer.Name);
+		std::string consumerName = GetSafeName(consumer.Name);
+		std::string color = "shadertoy_color_" + producerName;
+
+		std::string consumerCode = "";
+		if (!ReplacePointReads(consumer, channel, color, consumerCode))
+			return false;
+
+		channelNames["mainImage"] = "shadertoy_mainImage_" + producerName;
+		std::string producerCode = ReplaceIdentifiers(producer.Code, channelNames);
+
+		std::map<std::string, std::string> consumerNamesMap = { { "mainImage", "shadertoy_mainImage_" + consumerName } };
+		consumerCode = ReplaceIdentifiers(consumerCode, consumerNamesMap);
+
+		result = consumer;
+		result.Inputs = inputs;
+		result.Code = "// ##### " + producer.Name + " #####\n" + producerCode + "\n\n" +
+			"// ##### " + consumer.Name + " #####\n"
+			"vec4 " + color + ";\n\n" + consumerCode + "\n\n"
+			"void mainImage(out vec4 fragColor, in vec2 fragCoord)\n{\n"
+			"\tshadertoy_mainImage_" + producerName + "(" + color + ", fragCoord);\n"
+			"\tshadertoy_mainImage_" + consumerName + "(fragColor, fragCoord);\n"
+			"}\n";
+
+		return true;
+	}
+	std::vector<RenderPass> FusePointwisePasses(const std::vector<RenderPass>& passes, bool keepStatic, std::vector<FusedPass>& fused)
+	{
+		std::vector<RenderPass> ret = passes;
+
+		bool changed = true;
+		while (changed) {
+			changed = false;
+
+			std::vector<PassDependencies> deps;
+			if (keepStatic)
+				deps = AnalyzeDependencies(ret);
+
+			for (int i = 0; i < ret.size() && !changed; i++) {
+				if (ret[i].Type != "buffer" || ret[i].Outputs.empty() || (keepStatic && deps[i].IsStatic()))
+					continue;
+
+				// find the only pass that reads this buffer
+				int consumer = -1, readers = 0;
+				for (int j = 0; j < ret.size(); j++)
+					for (const auto& inp : ret[j].Inputs)
+						if (inp.Type == "buffer" && inp.ID == ret[i].Outputs[0].ID) {
+							consumer = j;
+							readers++;
+						}
+
+				if (readers != 1 || consumer >= i || (ret[consumer].Type != "buffer" && ret[consumer].Type != "image"))
+					continue;
+
+				RenderPass result;
+				if (FusePasses(ret, i, consumer, result)) {
+					fused.push_back({ ret[i].Name, ret[consumer].Name });
+					ret[consumer] = result;
+					ret.erase(ret.begin() + i);
+					changed = true;
+				}
+			}
+		}
+
+		return ret;
+	}
+}
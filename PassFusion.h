@@ -0,0 +1,20 @@
+#pragma once
+#include "RenderPass.h"
+#include <vector>
+#include <string>
+#include <map>
+
+namespace st
+{
+	struct FusedPass
+	{
+		std::string Producer; // removed buffer
+		std::string Consumer; // pass that now also runs the producer's code
+	};
+
+	/* merges buffers into the (only) pass that reads them, if that pass samples them only at its own fragCoord:
+	   the producer's mainImage is renamed & called first, its color replaces the texelFetch/texture calls */
+	std::vector<RenderPass> FusePointwisePasses(const std::vector<RenderPass>& passes, bool keepStatic, std::vector<FusedPass>& fused);
+
+	std::string ReplaceIdentifiers(const std::string& code, const std::map<std::string, std::string>& names);
+}
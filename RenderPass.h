@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include <string>
+
+namespace st
+{
+	struct ShaderOutput
+	{
+		int ID;
+		int Channel;
+	};
+	struct ShaderInputSampler
+	{
+		std::string Filter;
+		std::string Wrap;
+		bool FlipVertical;
+		bool SRGB;
+	};
+	struct ShaderInput
+	{
+		int ID;
+		int Channel;
+		std::string Type;
+		std::string Source;
+
+		ShaderInputSampler Sampler;
+	};
+	struct RenderPass
+	{
+		std::vector<ShaderOutput> Outputs;
+		std::vector<ShaderInput> Inputs;
+
+		std::string Name;
+		std::string Type;
+		std::string Code;
+	};
+}
@@ -0,0 +1,1279 @@
+#include "ShaderAnalyzer.h"
+#include <unordered_map>
+#include <algorithm>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+#include <map>
+#include <set>
+
+#define MAX_DEFINE_DEPTH 8
+
+namespace st
+{
+	const char* TextureFunctions[] = {
+		"texture", "texture2D", "textureCube", "textureLod", "textureGrad", "textureProj", "textureOffset",
+		"textureLodOffset", "textureGradOffset", "textureProjLod", "texelFetch", "texelFetchOffset", "textureGather"
+	};
+	const std::unordered_map<std::string, int> BuiltinCost = {
+		{ "sin", 4 }, { "cos", 4 }, { "tan", 8 }, { "asin", 8 }, { "acos", 8 }, { "atan", 8 },
+		{ "sinh", 8 }, { "cosh", 8 }, { "tanh", 8 }, { "exp", 4 }, { "exp2", 4 }, { "log", 4 }, { "log2", 4 },
+		{ "pow", 8 }, { "sqrt", 4 }, { "inversesqrt", 4 },
+		{ "normalize", 6 }, { "length", 5 }, { "distance", 6 }, { "dot", 3 }, { "cross", 6 }, { "reflect", 6 },
+		{ "refract", 12 }, { "faceforward", 6 }, { "mix", 3 }, { "smoothstep", 6 }, { "step", 1 }, { "clamp", 2 },
+		{ "min", 1 }, { "max", 1 }, { "abs", 1 }, { "sign", 1 }, { "floor", 1 }, { "ceil", 1 }, { "fract", 1 },
+		{ "mod", 3 }, { "round", 1 }, { "trunc", 1 }, { "matrixCompMult", 4 }, { "inverse", 40 },
+		{ "transpose", 4 }, { "determinant", 12 }, { "dFdx", 2 }, { "dFdy", 2 }, { "fwidth", 4 },
+		{ "textureSize", 1 }, { "floatBitsToUint", 1 }, { "uintBitsToFloat", 1 }, { "floatBitsToInt", 1 }
+	};
+	const char* MultiCharSymbols[] = {
+		"<<=", ">>=", "++", "--", "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=",
+		"==", "!=", "<=", ">=", "&&", "||", "^^", "<<", ">>"
+	};
+	const char* ArithmeticSymbols[] = {
+		"+", "-", "*", "/", "%", "+=", "-=", "*=", "/=", "%=", "<", ">", "<=", ">=", "==", "!=",
+		"&&", "||", "&", "|", "^", "<<", ">>", "++", "--", "?"
+	};
+
+	bool IsTextureFunction(const std::string& name)
+	{
+		for (const char* func : TextureFunctions)
+			if (name == func)
+				return true;
+		return false;
+	}
+	bool IsArithmeticSymbol(const std::string& sym)
+	{
+		for (const char* op : ArithmeticSymbols)
+			if (sym == op)
+				return true;
+		return false;
+	}
+
+	void TokenizeGLSL(const std::string& code, int source, std::vector<Token>& tokens, std::vector<Define>& defines)
+	{
+		size_t i = 0;
+		int line = 1, braceDepth = 0;
+		bool lineStart = true;
+
+		while (i < code.size()) {
+			char c = code[i];
+
+			if (c == '\n') {
+				line++;
+				lineStart = true;
+				i++;
+				continue;
+			}
+			if (isspace((unsigned char)c)) {
+				i++;
+				continue;
+			}
+
+			// comments
+			if (c == '/' && i + 1 < code.size() && code[i + 1] == '/') {
+				while (i < code.size() && code[i] != '\n')
+					i++;
+				continue;
+			}
+			if (c == '/' && i + 1 < code.size() && code[i + 1] == '*') {
+				i += 2;
+				while (i + 1 < code.size() && !(code[i] == '*' && code[i + 1] == '/')) {
+					if (code[i] == '\n')
+						line++;
+					i++;
+				}
+				i += 2;
+				continue;
+			}
+
+			// preprocessor directives
+			if (c == '#' && lineStart) {
+				int directiveLine = line;
+				std::string directive = "";
+				while (i < code.size() && code[i] != '\n') {
+					if (code[i] == '\\' && i + 1 < code.size() && code[i + 1] == '\n') {
+						directive += ' ';
+						line++;
+						i += 2;
+						continue;
+					}
+					if (code[i] == '/' && i + 1 < code.size() && code[i + 1] == '/') {
+						while (i < code.size() && code[i] != '\n')
+							i++;
+						break;
+					}
+					directive += code[i];
+					i++;
+				}
+
+				size_t nameStart = directive.find_first_not_of(" \t", 1);
+				if (nameStart != std::string::npos && directive.compare(nameStart, 6, "define") == 0) {
+					size_t macroStart = directive.find_first_not_of(" \t", nameStart + 6);
+					if (macroStart != std::string::npos) {
+						size_t macroEnd = macroStart;
+						while (macroEnd < directive.size() && (isalnum((unsigned char)directive[macroEnd]) || directive[macroEnd] == '_'))
+							macroEnd++;
+
+						Define def;
+						def.Name = directive.substr(macroStart, macroEnd - macroStart);
+						def.IsFunction = macroEnd < directive.size() && directive[macroEnd] == '(';
+						def.Line = directiveLine;
+						def.Source = source;
+						def.IsGlobal = braceDepth == 0;
+
+						size_t valueStart = directive.find_first_not_of(" \t", macroEnd);
+						size_t valueEnd = directive.find_last_not_of(" \t\r");
+						def.Value = (valueStart == std::string::npos || def.IsFunction) ? "" : directive.substr(valueStart, valueEnd - valueStart + 1);
+
+						if (!def.Name.empty())
+							defines.push_back(def);
+					}
+				}
+				continue;
+			}
+			lineStart = false;
+
+			Token tok;
+			tok.Line = line;
+			tok.Source = source;
+			tok.Offset = i;
+
+			if (isalpha((unsigned char)c) || c == '_') {
+				size_t start = i;
+				while (i < code.size() && (isalnum((unsigned char)code[i]) || code[i] == '_'))
+					i++;
+				tok.Type = TokenType::Identifier;
+				tok.Text = code.substr(start, i - start);
+			} else if (isdigit((unsigned char)c) || (c == '.' && i + 1 < code.size() && isdigit((unsigned char)code[i + 1]))) {
+				size_t start = i;
+				while (i < code.size() && (isalnum((unsigned char)code[i]) || code[i] == '.' ||
+					((code[i] == '-' || code[i] == '+') && (code[i - 1] == 'e' || code[i - 1] == 'E') && !(code[start] == '0' && start + 1 < code.size() && (code[start + 1] == 'x' || code[start + 1] == 'X')))))
+					i++;
+				tok.Type = TokenType::Number;
+				tok.Text = code.substr(start, i - start);
+			} else {
+				tok.Type = TokenType::Symbol;
+				tok.Text = std::string(1, c);
+				for (const char* sym : MultiCharSymbols) {
+					size_t len = strlen(sym);
+					if (code.compare(i, len, sym) == 0) {
+						tok.Text = sym;
+						break;
+					}
+				}
+				i += tok.Text.size();
+
+				if (tok.Text == "{")
+					braceDepth++;
+				else if (tok.Text == "}")
+					braceDepth--;
+			}
+
+			tokens.push_back(tok);
+		}
+	}
+	size_t FindMatchingToken(const std::vector<Token>& tokens, size_t open)
+	{
+		const std::string& openSym = tokens[open].Text;
+		std::string closeSym = openSym == "(" ? ")" : (openSym == "{" ? "}" : "]");
+
+		int depth = 0;
+		for (size_t i = open; i < tokens.size(); i++) {
+			if (tokens[i].Type != TokenType::Symbol)
+				continue;
+			if (tokens[i].Text == openSym)
+				depth++;
+			else if (tokens[i].Text == closeSym) {
+				depth--;
+				if (depth == 0)
+					return i;
+			}
+		}
+		return tokens.size();
+	}
+	bool MatchSequence(const std::vector<Token>& tokens, size_t& i, const std::vector<std::string>& seq)
+	{
+		size_t j = i;
+		for (const auto& text : seq) {
+			if (j >= tokens.size() || tokens[j].Text != text)
+				return false;
+			j++;
+		}
+		i = j;
+		return true;
+	}
+	bool MatchFragCoord(const std::vector<Token>& tokens, size_t& i, const std::string& fragCoord)
+	{
+		// fragCoord, fragCoord.xy
+		if (i >= tokens.size() || tokens[i].Text != fragCoord)
+			return false;
+		i++;
+		MatchSequence(tokens, i, { ".", "xy" });
+		return true;
+	}
+	bool IsModified(const std::vector<Token>& tokens, size_t begin, size_t end, const std::string& name, size_t declaration)
+	{
+		const char* assignOps[] = { "=", "+=", "-=", "*=", "/=", "%=", "++", "--" };
+
+		for (size_t i = begin; i < end; i++) {
+			if (tokens[i].Text != name || i == declaration)
+				continue;
+
+			// ++x, x = ..., x.y += ...
+			size_t next = i + 1;
+			if (next + 1 < end && tokens[next].Text == ".")
+				next += 2;
+			for (const char* op : assignOps)
+				if ((next < end && tokens[next].Text == op) || (i > begin && (tokens[i - 1].Text == "++" || tokens[i - 1].Text == "--")))
+					return true;
+		}
+		return false;
+	}
+	bool FindFunction(const std::vector<Token>& tokens, const char* name, size_t& argsOpen, size_t& bodyOpen, size_t& bodyClose)
+	{
+		for (size_t i = 0; i + 1 < tokens.size(); i++) {
+			if (tokens[i].Text != name || tokens[i + 1].Text != "(")
+				continue;
+
+			size_t argsClose = FindMatchingToken(tokens, i + 1);
+			if (argsClose + 1 >= tokens.size() || tokens[argsClose + 1].Text != "{")
+				continue; // declaration or a call
+
+			argsOpen = i + 1;
+			bodyOpen = argsClose + 1;
+			bodyClose = FindMatchingToken(tokens, bodyOpen);
+			return bodyClose < tokens.size();
+		}
+		return false;
+	}
+	bool DirectivesUse(const std::string& code, const std::string& name)
+	{
+		std::vector<Token> tokens;
+		std::vector<Define> defines;
+
+		std::istringstream stream(code);
+		std::string line;
+		bool continued = false;
+		while (std::getline(stream, line)) {
+			size_t first = line.find_first_not_of(" \t");
+			bool isDirective = continued || (first != std::string::npos && line[first] == '#');
+			continued = isDirective && !line.empty() && line.back() == '\\';
+			if (!isDirective)
+				continue;
+
+			// tokenize the directive's body as if it was code
+			if (first != std::string::npos && line[first] == '#')
+				line[first] = ' ';
+			tokens.clear();
+			TokenizeGLSL(line, 0, tokens, defines);
+			for (const auto& tok : tokens)
+				if (tok.Text == name)
+					return true;
+		}
+		return false;
+	}
+	bool GetNumericValue(const std::string& value, const std::vector<Define>& defines, double& out, int depth)
+	{
+		std::string val = value;
+
+		// strip the parentheses & casts: (64), int(64), float(64)
+		while (!val.empty() && val.back() == ')') {
+			size_t open = val.find('(');
+			if (open == std::string::npos)
+				break;
+			std::string prefix = val.substr(0, open);
+			if (prefix != "" && prefix != "int" && prefix != "float" && prefix != "uint")
+				break;
+			val = val.substr(open + 1, val.size() - open - 2);
+		}
+		size_t start = val.find_first_not_of(" \t");
+		if (start == std::string::npos)
+			return false;
+		size_t end = val.find_last_not_of(" \t");
+		val = val.substr(start, end - start + 1);
+
+		if (val.empty())
+			return false;
+
+		if (isdigit((unsigned char)val[0]) || val[0] == '.' || ((val[0] == '-' || val[0] == '+') && val.size() > 1)) {
+			const char* str = val.c_str();
+			char* strEnd = nullptr;
+			out = strtod(str, &strEnd);
+			if (strEnd == str)
+				return false;
+			while (*strEnd == 'f' || *strEnd == 'F' || *strEnd == 'u' || *strEnd == 'U')
+				strEnd++;
+			return *strEnd == 0;
+		}
+
+		if (depth < MAX_DEFINE_DEPTH) {
+			for (auto it = defines.rbegin(); it != defines.rend(); it++)
+				if (it->Name == val && !it->IsFunction)
+					return GetNumericValue(it->Value, defines, out, depth + 1);
+		}
+
+		return false;
+	}
+
+	struct Cost
+	{
+		double ALU;
+		double Fetches;
+
+		Cost() : ALU(0), Fetches(0) { }
+		Cost& operator+=(const Cost& c)
+		{
+			ALU += c.ALU;
+			Fetches += c.Fetches;
+			return *this;
+		}
+		Cost operator*(double n) const
+		{
+			Cost ret;
+			ret.ALU = ALU * n;
+			ret.Fetches = Fetches * n;
+			return ret;
+		}
+	};
+	class CostEvaluator
+	{
+	public:
+		CostEvaluator(const std::vector<Token>& tokens, const std::vector<Define>& defines)
+			: m_tokens(tokens)
+			, m_defines(defines)
+		{
+			m_findFunctions();
+		}
+
+		bool HasFunction(const std::string& name) { return m_funcs.count(name) > 0; }
+		Cost EvaluateFunction(const std::string& name)
+		{
+			auto memo = m_memo.find(name);
+			if (memo != m_memo.end())
+				return memo->second;
+
+			Cost ret;
+			if (m_stack.count(name) > 0) // recursion isn't allowed in GLSL anyway
+				return ret;
+			m_stack.insert(name);
+
+			// overloads: assume the most expensive one
+			for (const auto& range : m_funcs[name]) {
+				Cost overload = m_evaluateRange(range.first, range.second, name, 0);
+				if (overload.ALU + overload.Fetches > ret.ALU + ret.Fetches)
+					ret = overload;
+			}
+
+			m_stack.erase(name);
+			m_memo[name] = ret;
+
+			return ret;
+		}
+
+		inline const std::vector<LoopCost>& GetLoops() const { return m_loops; }
+
+	private:
+		const std::vector<Token>& m_tokens;
+		const std::vector<Define>& m_defines;
+
+		std::map<std::string, std::vector<std::pair<size_t, size_t>>> m_funcs; // function body ranges
+		std::map<std::string, Cost> m_memo;
+		std::set<std::string> m_stack;
+		std::vector<LoopCost> m_loops;
+
+		bool m_is(size_t i, const char* text) const { return i < m_tokens.size() && m_tokens[i].Text == text; }
+		bool m_isComparison(const std::string& op) const { return op == "<" || op == ">" || op == "<=" || op == ">=" || op == "!="; }
+
+		void m_findFunctions()
+		{
+			int depth = 0;
+			for (size_t i = 0; i < m_tokens.size(); i++) {
+				const Token& tok = m_tokens[i];
+				if (tok.Type == TokenType::Symbol) {
+					if (tok.Text == "{")
+						depth++;
+					else if (tok.Text == "}")
+						depth--;
+					continue;
+				}
+
+				// <type> <name> ( ... ) { ... }
+				if (depth != 0 || tok.Type != TokenType::Identifier || i == 0 || m_tokens[i - 1].Type != TokenType::Identifier || !m_is(i + 1, "("))
+					continue;
+
+				size_t paramsEnd = FindMatchingToken(m_tokens, i + 1);
+				if (!m_is(paramsEnd + 1, "{"))
+					continue;
+
+				size_t bodyEnd = FindMatchingToken(m_tokens, paramsEnd + 1);
+				m_funcs[tok.Text].push_back(std::make_pair(paramsEnd + 2, bodyEnd));
+				i = bodyEnd;
+			}
+		}
+		size_t m_findStatementEnd(size_t start, size_t end) const
+		{
+			int depth = 0;
+			for (size_t i = start; i < end; i++) {
+				const std::string& text = m_tokens[i].Text;
+				if (m_tokens[i].Type != TokenType::Symbol)
+					continue;
+				if (text == "(")
+					depth++;
+				else if (text == ")")
+					depth--;
+				else if (text == "{" && depth == 0)
+					return FindMatchingToken(m_tokens, i);
+				else if (text == ";" && depth == 0)
+					return i;
+			}
+			return end;
+		}
+		int m_estimateIterations(size_t begin, size_t end) const
+		{
+			// split the header into init; cond; inc
+			size_t sep[2] = { end, end };
+			int sepCount = 0, depth = 0;
+			for (size_t i = begin; i < end && sepCount < 2; i++) {
+				if (m_tokens[i].Text == "(")
+					depth++;
+				else if (m_tokens[i].Text == ")")
+					depth--;
+				else if (m_tokens[i].Text == ";" && depth == 0)
+					sep[sepCount++] = i;
+			}
+			if (sepCount != 2)
+				return -1;
+
+			// init: [type] var = value
+			std::string var = "";
+			double start = 0;
+			for (size_t i = begin; i < sep[0]; i++) {
+				if (m_tokens[i].Text == "=" && i > begin) {
+					var = m_tokens[i - 1].Text;
+					if (!m_getValue(i + 1, sep[0], start))
+						return -1;
+					break;
+				}
+			}
+			if (var.empty())
+				return -1;
+
+			// cond: var <op> value  or  value <op> var
+			std::string op = "";
+			double limit = 0;
+			for (size_t i = sep[0] + 1; i < sep[1]; i++) {
+				if (m_tokens[i].Text != var)
+					continue;
+
+				if (i + 1 < sep[1] && m_isComparison(m_tokens[i + 1].Text)) {
+					op = m_tokens[i + 1].Text;
+					size_t valEnd = i + 2;
+					while (valEnd < sep[1] && m_tokens[valEnd].Text != "&&" && m_tokens[valEnd].Text != "||")
+						valEnd++;
+					if (!m_getValue(i + 2, valEnd, limit))
+						return -1;
+				} else if (i >= sep[0] + 3 && m_isComparison(m_tokens[i - 1].Text)) {
+					// flip the comparison
+					op = m_tokens[i - 1].Text;
+					if (op == "<") op = ">";
+					else if (op == ">") op = "<";
+					else if (op == "<=") op = ">=";
+					else if (op == ">=") op = "<=";
+
+					size_t valBegin = i - 1;
+					while (valBegin > sep[0] + 1 && m_tokens[valBegin - 1].Text != "&&" && m_tokens[valBegin - 1].Text != "||")
+						valBegin--;
+					if (!m_getValue(valBegin, i - 1, limit))
+						return -1;
+				} else
+					continue;
+				break;
+			}
+			if (op.empty())
+				return -1;
+
+			// inc: var++, ++var, var += step, ...
+			double step = 0;
+			for (size_t i = sep[1] + 1; i < end; i++) {
+				const std::string& text = m_tokens[i].Text;
+				if (text == "++")
+					step = 1;
+				else if (text == "--")
+					step = -1;
+				else if ((text == "+=" || text == "-=" || text == "*=") && m_getValue(i + 1, end, step)) {
+					if (text == "-=")
+						step = -step;
+					else if (text == "*=") {
+						// geometric progression
+						if (step <= 1.0 || start <= 0.0 || limit <= start)
+							return -1;
+						return (int)std::ceil(std::log(limit / start) / std::log(step));
+					}
+				}
+				else
+					continue;
+				break;
+			}
+			if (step == 0)
+				return -1;
+
+			double count = -1;
+			if ((op == "<" || op == "<=") && step > 0)
+				count = (limit - start) / step;
+			else if ((op == ">" || op == ">=") && step < 0)
+				count = (start - limit) / -step;
+			else if (op == "!=")
+				count = std::abs((limit - start) / step);
+			else
+				return -1;
+
+			if (op == "<=" || op == ">=")
+				count = std::floor(count) + 1;
+			else
+				count = std::ceil(count);
+
+			return (int)std::max(0.0, std::min(count, 1e7));
+		}
+		bool m_getValue(size_t begin, size_t end, double& out) const
+		{
+			std::string expr = "";
+			for (size_t i = begin; i < end; i++)
+				expr += m_tokens[i].Text;
+			return GetNumericValue(expr, m_defines, out);
+		}
+		bool m_isRaymarchLoop(size_t begin, size_t end) const
+		{
+			// a loop that calls a distance function, accumulates something & exits early
+			bool hasBreak = false, hasCall = false, hasAccumulation = false;
+			for (size_t i = begin; i < end; i++) {
+				const Token& tok = m_tokens[i];
+				if (tok.Text == "break" || tok.Text == "return")
+					hasBreak = true;
+				else if (tok.Text == "+=")
+					hasAccumulation = true;
+				else if (tok.Type == TokenType::Identifier && m_is(i + 1, "(") && m_funcs.count(tok.Text) > 0)
+					hasCall = true;
+			}
+			return hasBreak && hasCall && hasAccumulation;
+		}
+
+		Cost m_evaluateLoop(size_t bodyStart, size_t end, size_t headerBegin, size_t headerEnd, int iterations, const std::string& func, int depth, int line, int source, size_t& next)
+		{
+			size_t bodyEnd = m_findStatementEnd(bodyStart, end);
+			next = bodyEnd;
+			if (m_is(bodyStart, "{"))
+				bodyStart++;
+
+			size_t loopIndex = m_loops.size();
+			m_loops.push_back({ func, line, source, depth + 1, iterations, false });
+
+			Cost ret = m_evaluateRange(headerBegin, headerEnd, func, depth);
+			ret += m_evaluateRange(bodyStart, std::min(bodyEnd + 1, end), func, depth + 1);
+
+			m_loops[loopIndex].Raymarch = m_isRaymarchLoop(bodyStart, std::min(bodyEnd + 1, end));
+
+			return ret * (iterations < 0 ? UNKNOWN_LOOP_ITERATIONS : iterations);
+		}
+		Cost m_evaluateRange(size_t begin, size_t end, const std::string& func, int depth)
+		{
+			Cost ret;
+			for (size_t i = begin; i < end; i++) {
+				const Token& tok = m_tokens[i];
+
+				if (tok.Type == TokenType::Symbol) {
+					if (IsArithmeticSymbol(tok.Text))
+						ret.ALU += 1;
+					continue;
+				}
+				if (tok.Type != TokenType::Identifier)
+					continue;
+
+				if ((tok.Text == "for" || tok.Text == "while") && m_is(i + 1, "(")) {
+					size_t headerEnd = FindMatchingToken(m_tokens, i + 1);
+					int iterations = tok.Text == "for" ? m_estimateIterations(i + 2, headerEnd) : -1;
+					size_t next = i;
+					ret += m_evaluateLoop(headerEnd + 1, end, i + 2, headerEnd, iterations, func, depth, tok.Line, tok.Source, next);
+					i = next;
+				} else if (tok.Text == "do" && m_is(i + 1, "{")) {
+					size_t bodyEnd = FindMatchingToken(m_tokens, i + 1);
+					size_t headerEnd = m_is(bodyEnd + 2, "(") ? FindMatchingToken(m_tokens, bodyEnd + 2) : bodyEnd;
+					size_t next = i;
+					ret += m_evaluateLoop(i + 1, end, bodyEnd + 3, headerEnd, -1, func, depth, tok.Line, tok.Source, next);
+					i = std::max(next, headerEnd);
+				} else if (m_is(i + 1, "(")) {
+					auto builtin = BuiltinCost.find(tok.Text);
+					if (IsTextureFunction(tok.Text)) {
+						ret.Fetches += 1;
+						ret.ALU += 1;
+					} else if (builtin != BuiltinCost.end())
+						ret.ALU += builtin->second;
+					else if (m_funcs.count(tok.Text) > 0)
+						ret += EvaluateFunction(tok.Text);
+				}
+			}
+			return ret;
+		}
+	};
+
+	PassCost AnalyzePassCost(const RenderPass& pass, const std::string& commonCode, const std::vector<QualityKnob>& knobs)
+	{
+		std::vector<Token> tokens;
+		std::vector<Define> defines;
+		TokenizeGLSL(commonCode, 1, tokens, defines);
+		TokenizeGLSL(pass.Code, 0, tokens, defines);
+
+		// the overriden values win since the defines are searched from the back
+		for (const auto& knob : knobs)
+			defines.push_back({ knob.Name, knob.Value, -1, 0, false, true });
+
+		std::string entry = "mainImage";
+		if (pass.Type == "sound")
+			entry = "mainSound";
+		else if (pass.Type == "cubemap")
+			entry = "mainCubemap";
+
+		CostEvaluator eval(tokens, defines);
+		Cost cost = eval.EvaluateFunction(entry);
+
+		PassCost ret;
+		ret.Name = pass.Name;
+		ret.TextureFetches = cost.Fetches;
+		ret.Instructions = cost.ALU + cost.Fetches;
+		ret.PixelScale = 1.0;
+		ret.Loops = eval.GetLoops();
+
+		return ret;
+	}
+	std::vector<PassCost> AnalyzePipelineCost(const std::vector<RenderPass>& passes, const std::vector<QualityKnob>& knobs)
+	{
+		std::string commonCode = "";
+		for (const auto& pass : passes)
+			if (pass.Type == "common")
+				commonCode = pass.Code;
+
+		std::vector<PassCost> ret;
+		for (const auto& pass : passes)
+			if (pass.Type != "common")
+				ret.push_back(AnalyzePassCost(pass, commonCode, knobs));
+
+		return ret;
+	}
+
+	const char* GetCostRating(const PassCost& cost)
+	{
+		if (cost.Instructions > 20000 || cost.TextureFetches > 256)
+			return "heavy";
+		if (cost.Instructions > 2000 || cost.TextureFetches > 32)
+			return "medium";
+		return "light";
+	}
+	std::string FormatCostReport(const std::vector<PassCost>& costs)
+	{
+		std::string ret = "";
+		char buffer[256];
+
+		double total = 0;
+		for (const auto& cost : costs) {
+			snprintf(buffer, sizeof(buffer), "%s: ~%.0f instructions & ~%.0f texture fetches per pixel (%s)\n",
+				cost.Name.c_str(), cost.Instructions, cost.TextureFetches, GetCostRating(cost));
+			ret += buffer;
+
+			for (const auto& loop : cost.Loops) {
+				std::string iterations = loop.Iterations < 0 ? "unknown bound (assumed " + std::to_string(UNKNOWN_LOOP_ITERATIONS) + ")" : std::to_string(loop.Iterations) + " iterations";
+				snprintf(buffer, sizeof(buffer), "%*s- loop in %s() at %sline %d: %s%s\n",
+					loop.Depth * 2, "", loop.Function.c_str(), loop.Source == 1 ? "common " : "", loop.Line,
+					iterations.c_str(), loop.Raymarch ? ", raymarch loop" : "");
+				ret += buffer;
+			}
+
+			total += cost.Instructions * cost.PixelScale;
+		}
+
+		snprintf(buffer, sizeof(buffer), "Total: ~%.2f G instructions per frame at 1080p, ~%.2f G at 4K\n",
+			total * 1920 * 1080 / 1e9, total * 3840 * 2160 / 1e9);
+		ret += buffer;
+
+		return ret;
+	}
+
+	const char* GetChannelSamplerType(const RenderPass& pass, int channel)
+	{
+		for (const auto& inp : pass.Inputs)
+			if (inp.Channel == channel && inp.Type == "cubemap")
+				return "samplerCube";
+			else if (inp.Channel == channel && inp.Type == "volume")
+				return "sampler3D";
+		return "sampler2D";
+	}
+	bool UsesIdentifier(const std::vector<Token>& tokens, const std::vector<Define>& defines, const char* name)
+	{
+		for (const auto& tok : tokens)
+			if (tok.Type == TokenType::Identifier && tok.Text == name)
+				return true;
+
+		// #define T iTime * 0.5
+		size_t nameLen = strlen(name);
+		for (const auto& def : defines) {
+			size_t pos = def.Value.find(name);
+			while (pos != std::string::npos) {
+				bool startOk = pos == 0 || !(isalnum((unsigned char)def.Value[pos - 1]) || def.Value[pos - 1] == '_');
+				bool endOk = pos + nameLen >= def.Value.size() || !(isalnum((unsigned char)def.Value[pos + nameLen]) || def.Value[pos + nameLen] == '_');
+				if (startOk && endOk)
+					return true;
+				pos = def.Value.find(name, pos + 1);
+			}
+		}
+
+		return false;
+	}
+	std::vector<std::string> FindCommonUsers(const std::string& commonCode, const char* name)
+	{
+		std::vector<Token> tokens;
+		std::vector<Define> defines;
+		TokenizeGLSL(commonCode, 1, tokens, defines);
+
+		// name -> tokens of the function body / macro value
+		std::vector<std::pair<std::string, std::vector<std::string>>> users;
+		for (size_t i = 0; i + 1 < tokens.size(); i++) {
+			if (tokens[i].Text == "{") {
+				i = FindMatchingToken(tokens, i);
+				continue;
+			}
+			if (tokens[i].Type != TokenType::Identifier || tokens[i + 1].Text != "(")
+				continue;
+
+			size_t argsClose = FindMatchingToken(tokens, i + 1);
+			if (argsClose + 1 >= tokens.size() || tokens[argsClose + 1].Text != "{")
+				continue; // declaration
+
+			size_t bodyClose = FindMatchingToken(tokens, argsClose + 1);
+			std::vector<std::string> body;
+			for (size_t j = argsClose + 2; j < bodyClose && j < tokens.size(); j++)
+				body.push_back(tokens[j].Text);
+			users.push_back(std::make_pair(tokens[i].Text, body));
+			i = bodyClose;
+		}
+
+		// #define T(x) (iTime * x) - the values of function-like macros aren't stored by the tokenizer
+		std::istringstream stream(commonCode);
+		std::string line, directive;
+		while (std::getline(stream, line)) {
+			size_t first = line.find_first_not_of(" \t");
+			if (directive.empty() && (first == std::string::npos || line[first] != '#'))
+				continue;
+
+			bool continued = !line.empty() && line.back() == '\\';
+			if (continued)
+				line.back() = ' ';
+			directive += line.substr(directive.empty() ? first + 1 : 0) + " ";
+			if (continued)
+				continue;
+
+			std::vector<Token> dirTokens;
+			std::vector<Define> dirDefines;
+			TokenizeGLSL(directive, 1, dirTokens, dirDefines);
+			directive.clear();
+			if (dirTokens.size() < 2 || dirTokens[0].Text != "define")
+				continue;
+
+			std::vector<std::string> body;
+			for (size_t j = 2; j < dirTokens.size(); j++)
+				body.push_back(dirTokens[j].Text);
+			users.push_back(std::make_pair(dirTokens[1].Text, body));
+		}
+
+		// functions that call a function which uses the variable use it too
+		std::vector<std::string> ret;
+		std::vector<bool> uses(users.size(), false);
+		bool changed = true;
+		while (changed) {
+			changed = false;
+			for (size_t i = 0; i < users.size(); i++) {
+				if (uses[i])
+					continue;
+
+				for (const auto& text : users[i].second)
+					if (text == name || std::find(ret.begin(), ret.end(), text) != ret.end()) {
+						uses[i] = changed = true;
+						ret.push_back(users[i].first);
+						break;
+					}
+			}
+		}
+
+		return ret;
+	}
+	std::string FindCubemapBuffer(const std::vector<RenderPass>& data, const ShaderInput& inp)
+	{
+		// Cube A is read through a cubemap input with the ID of the pass' output
+		if (inp.Type == "cubemap")
+			for (const auto& pass : data)
+				if (pass.Type == "cubemap" && !pass.Outputs.empty() && pass.Outputs[0].ID == inp.ID)
+					return pass.Name;
+		return "";
+	}
+	std::vector<PassDependencies> AnalyzeDependencies(const std::vector<RenderPass>& passes)
+	{
+		const char* timeVariables[] = { "iTime", "iTimeDelta", "iDate", "iFrameRate", "iChannelTime", "iGlobalTime" };
+
+		// Common's functions & macros count as the pass' own code
+		std::string commonCode = "";
+		for (const auto& pass : passes)
+			if (pass.Type == "common")
+				commonCode = pass.Code;
+		std::vector<std::string> commonTime, commonFrame = FindCommonUsers(commonCode, "iFrame"), commonMouse = FindCommonUsers(commonCode, "iMouse");
+		for (const char* var : timeVariables) {
+			std::vector<std::string> users = FindCommonUsers(commonCode, var);
+			commonTime.insert(commonTime.end(), users.begin(), users.end());
+		}
+
+		std::vector<PassDependencies> ret(passes.size());
+		for (size_t i = 0; i < passes.size(); i++) {
+			const RenderPass& pass = passes[i];
+			PassDependencies& deps = ret[i];
+
+			std::vector<Token> tokens;
+			std::vector<Define> defines;
+			TokenizeGLSL(pass.Code, 0, tokens, defines);
+
+			deps.Time = false;
+			for (const char* var : timeVariables)
+				deps.Time |= UsesIdentifier(tokens, defines, var);
+			deps.Frame = UsesIdentifier(tokens, defines, "iFrame");
+			deps.Mouse = UsesIdentifier(tokens, defines, "iMouse");
+			for (const auto& name : commonTime)
+				deps.Time |= UsesIdentifier(tokens, defines, name.c_str());
+			for (const auto& name : commonFrame)
+				deps.Frame |= UsesIdentifier(tokens, defines, name.c_str());
+			for (const auto& name : commonMouse)
+				deps.Mouse |= UsesIdentifier(tokens, defines, name.c_str());
+			deps.Feedback = false;
+			deps.DynamicInput = false;
+
+			for (const auto& inp : pass.Inputs) {
+				if (inp.Type == "buffer" || !FindCubemapBuffer(passes, inp).empty()) {
+					// passes are rendered from the last one to the first: own output or a buffer
+					// with a lower index -> previous frame's content
+					for (size_t j = 0; j <= i; j++)
+						for (const auto& out : passes[j].Outputs)
+							deps.Feedback |= out.ID == inp.ID;
+				} else if (inp.Type != "texture" && inp.Type != "cubemap" && inp.Type != "volume")
+					deps.DynamicInput = true; // keyboard, webcam, video, music, ...
+			}
+		}
+
+		// a buffer that reads a non-static buffer or Cube A isn't static either
+		bool changed = true;
+		while (changed) {
+			changed = false;
+			for (size_t i = 0; i < passes.size(); i++) {
+				if (!ret[i].IsStatic())
+					continue;
+
+				for (const auto& inp : passes[i].Inputs) {
+					if (inp.Type != "buffer" && FindCubemapBuffer(passes, inp).empty())
+						continue;
+
+					for (size_t j = 0; j < passes.size(); j++)
+						for (const auto& out : passes[j].Outputs)
+							if (out.ID == inp.ID && !ret[j].IsStatic() && !ret[i].DynamicInput) {
+								ret[i].DynamicInput = true;
+								changed = true;
+							}
+				}
+			}
+		}
+
+		return ret;
+	}
+	const BufferFormat BufferFormats[] = {
+		{ "R8", "R8_UNORM", 1, 1 }, { "RG8", "R8G8_UNORM", 2, 2 }, { "RGBA8", "R8G8B8A8_UNORM", 4, 4 },
+		{ "R16F", "R16_FLOAT", 1, 2 }, { "RG16F", "R16G16_FLOAT", 2, 4 }, { "RGBA16F", "R16G16B16A16_FLOAT", 4, 8 },
+		{ "R32F", "R32_FLOAT", 1, 4 }, { "RG32F", "R32G32_FLOAT", 2, 8 }, { "RGBA32F", "R32G32B32A32_FLOAT", 4, 16 }
+	};
+	BufferFormat GetBufferFormat(const std::string& name)
+	{
+		for (const auto& fmt : BufferFormats)
+			if (name == fmt.Name)
+				return fmt;
+		return { "RGBA8", "R8G8B8A8_UNORM", 4, 4 }; // host default
+	}
+	bool IsBoundedExpression(const std::vector<Token>& tokens, size_t begin, size_t end)
+	{
+		// numbers in [0, 1], clamp(x, 0, 1), smoothstep(...), vec4(bounded, bounded, ...), (bounded)
+		if (begin >= end)
+			return false;
+
+		if (end - begin == 1 && tokens[begin].Type == TokenType::Number) {
+			double val = atof(tokens[begin].Text.c_str());
+			return val >= 0.0 && val <= 1.0;
+		}
+
+		const std::string& first = tokens[begin].Text;
+		size_t open = first == "(" ? begin : begin + 1;
+		if (open >= end || tokens[open].Text != "(" || FindMatchingToken(tokens, open) != end - 1)
+			return false;
+
+		// split the arguments
+		std::vector<std::pair<size_t, size_t>> args;
+		size_t argStart = open + 1;
+		int depth = 0;
+		for (size_t i = open + 1; i < end - 1; i++) {
+			if (tokens[i].Text == "(" || tokens[i].Text == "[") depth++;
+			else if (tokens[i].Text == ")" || tokens[i].Text == "]") depth--;
+			else if (tokens[i].Text == "," && depth == 0) {
+				args.push_back(std::make_pair(argStart, i));
+				argStart = i + 1;
+			}
+		}
+		args.push_back(std::make_pair(argStart, end - 1));
+
+		if (first == "(")
+			return args.size() == 1 && IsBoundedExpression(tokens, args[0].first, args[0].second);
+		if (first == "smoothstep" || first == "step" || first == "fract" || first == "saturate")
+			return true;
+		if (first == "clamp")
+			return args.size() == 3 && IsBoundedExpression(tokens, args[1].first, args[1].second) && IsBoundedExpression(tokens, args[2].first, args[2].second);
+		if (first == "vec2" || first == "vec3" || first == "vec4") {
+			for (const auto& arg : args)
+				if (!IsBoundedExpression(tokens, arg.first, arg.second))
+					return false;
+			return true;
+		}
+
+		return false;
+	}
+	bool IsOutputBounded(const std::vector<Token>& tokens)
+	{
+		size_t argsOpen = 0, bodyOpen = 0, bodyClose = 0;
+		if (!FindFunction(tokens, "mainImage", argsOpen, bodyOpen, bodyClose))
+			return false;
+
+		// void mainImage(out vec4 fragColor, ...)
+		std::string output = "";
+		for (size_t i = argsOpen; i < bodyOpen; i++)
+			if (tokens[i].Text == "vec4" && tokens[i + 1].Type == TokenType::Identifier) {
+				output = tokens[i + 1].Text;
+				break;
+			}
+
+		int assignments = 0;
+		for (size_t i = bodyOpen; i < bodyClose; i++) {
+			if (tokens[i].Text != output)
+				continue;
+
+			size_t op = i + 1;
+			if (tokens[op].Text == ".")
+				op += 2;
+			if (op >= bodyClose)
+				continue;
+			if (tokens[op].Text == ";" || tokens[op].Text == ")" || tokens[op].Text == ",")
+				return false; // passed to a function as an out parameter
+			if (tokens[op].Text != "=") {
+				if (IsArithmeticSymbol(tokens[op].Text) && tokens[op].Text.back() == '=' && tokens[op].Text != "==" && tokens[op].Text != "<=" && tokens[op].Text != ">=" && tokens[op].Text != "!=")
+					return false; // +=, *=, ...
+				continue;
+			}
+
+			size_t end = op + 1;
+			while (end < bodyClose && tokens[end].Text != ";")
+				end++;
+			if (!IsBoundedExpression(tokens, op + 1, end))
+				return false;
+
+			assignments++;
+		}
+
+		return assignments > 0;
+	}
+	int GetSwizzleComponents(const std::string& swizzle)
+	{
+		int ret = 0;
+		for (char c : swizzle) {
+			const char* sets[] = { "xyzw", "rgba", "stpq" };
+			int index = -1;
+			for (const char* set : sets)
+				if (strchr(set, c) != nullptr)
+					index = strchr(set, c) - set;
+			if (index < 0)
+				return 4;
+			ret = std::max(ret, index + 1);
+		}
+		return ret;
+	}
+	int GetReadComponents(const RenderPass& reader, int channel)
+	{
+		std::string name = "iChannel" + std::to_string(channel);
+		if (DirectivesUse(reader.Code, name))
+			return 4;
+
+		std::vector<Token> tokens;
+		std::vector<Define> defines;
+		TokenizeGLSL(reader.Code, 0, tokens, defines);
+
+		int ret = 0;
+		for (size_t i = 0; i < tokens.size(); i++) {
+			if (tokens[i].Text != name)
+				continue;
+
+			// texture(iChannel0, uv).r
+			if (i < 2 || tokens[i - 1].Text != "(" || !IsTextureFunction(tokens[i - 2].Text))
+				return 4;
+			size_t close = FindMatchingToken(tokens, i - 1);
+			if (close + 2 >= tokens.size() || tokens[close + 1].Text != "." || tokens[close + 2].Type != TokenType::Identifier)
+				return 4;
+			ret = std::max(ret, GetSwizzleComponents(tokens[close + 2].Text));
+		}
+		return ret;
+	}
+	BufferFormat InferBufferFormat(const std::vector<RenderPass>& passes, int index)
+	{
+		const RenderPass& pass = passes[index];
+		int outputID = pass.Outputs.empty() ? -1 : pass.Outputs[0].ID;
+
+		// explicit hint: // @format RGBA16F
+		size_t hint = pass.Code.find("@format");
+		if (hint != std::string::npos) {
+			size_t start = pass.Code.find_first_not_of(" \t", hint + 7);
+			size_t end = start == std::string::npos ? std::string::npos : pass.Code.find_first_of(" \t\r\n", start);
+			std::string name = start == std::string::npos ? "" : pass.Code.substr(start, end - start);
+			for (const auto& fmt : BufferFormats)
+				if (name == fmt.Name) {
+					BufferFormat ret = fmt;
+					ret.Reason = "@format hint";
+					return ret;
+				}
+		}
+
+		std::vector<Token> tokens;
+		std::vector<Define> defines;
+		TokenizeGLSL(pass.Code, 0, tokens, defines);
+
+		// used components & data reads
+		int components = 0;
+		bool feedback = false, dataReads = false, hasReaders = false;
+		for (const auto& reader : passes) {
+			std::vector<Token> readerTokens;
+			std::vector<Define> readerDefines;
+			TokenizeGLSL(reader.Code, 0, readerTokens, readerDefines);
+
+			for (const auto& inp : reader.Inputs) {
+				if (inp.Type != "buffer" || inp.ID != outputID)
+					continue;
+
+				hasReaders = true;
+				feedback |= &reader == &pass;
+
+				std::string channel = "iChannel" + std::to_string(inp.Channel);
+				if (DirectivesUse(reader.Code, channel))
+					components = 4;
+
+				for (size_t i = 0; i < readerTokens.size(); i++) {
+					if (readerTokens[i].Text != channel)
+						continue;
+
+					// only sampler arguments of the texture functions are understood
+					if (i < 2 || readerTokens[i - 1].Text != "(" || !IsTextureFunction(readerTokens[i - 2].Text)) {
+						components = 4;
+						continue;
+					}
+
+					size_t close = FindMatchingToken(readerTokens, i - 1);
+					if (close + 2 < readerTokens.size() && readerTokens[close + 1].Text == "." && readerTokens[close + 2].Type == TokenType::Identifier)
+						components = std::max(components, GetSwizzleComponents(readerTokens[close + 2].Text));
+					else
+						components = 4;
+
+					// texelFetch(iChannel0, ivec2(0, 0), 0) -> the buffer stores data, not an image
+					if (readerTokens[i - 2].Text == "texelFetch") {
+						bool constant = true;
+						for (size_t j = i + 2; j < close && readerTokens[j].Text != ","; j++)
+							constant &= readerTokens[j].Type != TokenType::Identifier || readerTokens[j].Text == "ivec2";
+						dataReads |= constant;
+					}
+				}
+			}
+		}
+		if (!hasReaders || components == 3)
+			components = 4; // 3 channel render targets aren't renderable everywhere
+
+		std::string precision = "16F";
+		std::string reason = "";
+		if (dataReads || UsesIdentifier(tokens, defines, "floatBitsToUint") || UsesIdentifier(tokens, defines, "floatBitsToInt")) {
+			precision = "32F";
+			reason = "stores data";
+		} else if (feedback && UsesIdentifier(tokens, defines, "iFrame")) {
+			precision = "32F";
+			reason = "accumulates over frames";
+		} else if (feedback)
+			reason = "feedback";
+		else if (IsOutputBounded(tokens)) {
+			precision = "8";
+			reason = "color in [0, 1]";
+		} else
+			reason = "unbounded values";
+
+		std::string channels = components == 1 ? "R" : (components == 2 ? "RG" : "RGBA");
+		BufferFormat ret = GetBufferFormat(channels + precision);
+		ret.Reason = reason;
+		if (components < 4)
+			ret.Reason += ", only ." + std::string("xyzw").substr(0, components) + " is read";
+
+		return ret;
+	}
+	std::string FormatMemoryReport(const std::vector<TextureMemory>& textures)
+	{
+		std::string ret = "";
+		char buffer[256];
+
+		double total1080 = 0, total4K = 0;
+		for (const auto& tex : textures) {
+			double pixels1080 = tex.Width > 0 ? (double)tex.Width * tex.Height : 1920.0 * 1080.0 * tex.PixelScale;
+			double pixels4K = tex.Width > 0 ? (double)tex.Width * tex.Height : 3840.0 * 2160.0 * tex.PixelScale;
+			double mipFactor = tex.Mipmaps ? 4.0 / 3.0 : 1.0;
+
+			double size1080 = pixels1080 * tex.Format.BytesPerPixel * mipFactor / (1024.0 * 1024.0);
+			double size4K = pixels4K * tex.Format.BytesPerPixel * mipFactor / (1024.0 * 1024.0);
+			total1080 += size1080;
+			total4K += size4K;
+
+			snprintf(buffer, sizeof(buffer), "%s: %s, %.1f MB at 1080p, %.1f MB at 4K%s%s\n", tex.Name.c_str(), tex.Format.Name.c_str(),
+				size1080, size4K, tex.Format.Reason.empty() ? "" : " - ", tex.Format.Reason.c_str());
+			ret += buffer;
+		}
+
+		snprintf(buffer, sizeof(buffer), "Total: %.1f MB at 1080p, %.1f MB at 4K\n", total1080, total4K);
+		ret += buffer;
+
+		return ret;
+	}
+	std::vector<QualityKnob> FindQualityKnobs(const std::vector<RenderPass>& passes)
+	{
+		std::vector<QualityKnob> ret;
+
+		for (const auto& pass : passes) {
+			std::vector<Token> tokens;
+			std::vector<Define> defines;
+			TokenizeGLSL(pass.Code, 0, tokens, defines);
+
+			bool isCommon = pass.Type == "common";
+			for (const auto& def : defines) {
+				double value = 0;
+				if (!def.IsGlobal || def.IsFunction || !GetNumericValue(def.Value, std::vector<Define>(), value))
+					continue;
+
+				QualityKnob* knob = nullptr;
+				for (auto& k : ret)
+					if (k.Name == def.Name)
+						knob = &k;
+
+				if (knob == nullptr) {
+					ret.push_back(QualityKnob());
+					knob = &ret.back();
+					knob->Name = def.Name;
+					knob->Default = def.Value;
+					knob->InCommon = false;
+				}
+
+				knob->InCommon |= isCommon;
+				if (!isCommon && std::count(knob->Passes.begin(), knob->Passes.end(), pass.Name) == 0)
+					knob->Passes.push_back(pass.Name);
+			}
+		}
+
+		ResetQualityKnobs(ret);
+
+		return ret;
+	}
+	std::string GuardQualityKnobs(const std::string& code, const std::vector<QualityKnob>& knobs, int firstLine)
+	{
+		std::string ret = "";
+		size_t lineStart = 0;
+		int lineNumber = firstLine;
+
+		while (lineStart < code.size()) {
+			size_t lineEnd = code.find('\n', lineStart);
+			if (lineEnd == std::string::npos)
+				lineEnd = code.size();
+			std::string line = code.substr(lineStart, lineEnd - lineStart);
+			lineStart = lineEnd + 1;
+
+			// #define NAME value -> #ifndef NAME / #define NAME value / #endif
+			std::string name = "";
+			size_t hash = line.find_first_not_of(" \t");
+			if (hash != std::string::npos && line[hash] == '#' && line.back() != '\\') {
+				size_t directive = line.find_first_not_of(" \t", hash + 1);
+				if (directive != std::string::npos && line.compare(directive, 6, "define") == 0) {
+					size_t nameStart = line.find_first_not_of(" \t", directive + 6);
+					size_t nameEnd = nameStart;
+					while (nameEnd < line.size() && (isalnum((unsigned char)line[nameEnd]) || line[nameEnd] == '_'))
+						nameEnd++;
+					if (nameStart != std::string::npos && (nameEnd == line.size() || line[nameEnd] != '('))
+						name = line.substr(nameStart, nameEnd - nameStart);
+				}
+			}
+
+			bool isKnob = false;
+			for (const auto& knob : knobs)
+				isKnob |= !name.empty() && knob.Name == name;
+
+			if (isKnob) {
+				// the guard's lines don't count
+				ret += "#ifndef " + name + "\n";
+				if (firstLine > 0)
+					ret += "#line " + std::to_string(lineNumber) + "\n";
+				ret += line + "\n#endif";
+				if (firstLine > 0)
+					ret += "\n#line " + std::to_string(lineNumber + 1);
+			} else
+				ret += line;
+			lineNumber++;
+
+			if (lineEnd < code.size())
+				ret += "\n";
+		}
+
+		return ret;
+	}
+	void ApplyPerformancePreset(std::vector<QualityKnob>& knobs)
+	{
+		const char* antialiasing[] = { "AA", "ANTIALIAS", "ANTIALIASING", "SAMPLES", "SPP", "MSAA", "SUPERSAMPLING" };
+		const char* counts[] = { "STEPS", "ITERATIONS", "ITERS", "ITER", "OCTAVES", "BOUNCES", "SAMPLES", "RAYS" }; // MAX_STEPS, SHADOW_SAMPLES, ...
+
+		for (auto& knob : knobs) {
+			// only integer counts - halving a float (STEP_SIZE 2.0, MAX_DEPTH 20.0) changes the image or even the cost
+			double value = 0;
+			if (knob.Default.find_first_not_of("0123456789") != std::string::npos || !GetNumericValue(knob.Default, std::vector<Define>(), value) || value <= 1.0)
+				continue;
+
+			std::string upperName = knob.Name;
+			std::transform(upperName.begin(), upperName.end(), upperName.begin(), ::toupper);
+
+			bool isAA = false, isCount = false;
+			for (const char* name : antialiasing)
+				isAA |= upperName == name;
+
+			// whole words of the name
+			std::istringstream words(upperName);
+			std::string word;
+			while (std::getline(words, word, '_'))
+				for (const char* name : counts)
+					isCount |= word == name;
+
+			if (isAA)
+				snprintf(knob.Value, sizeof(knob.Value), "1");
+			else if (isCount)
+				snprintf(knob.Value, sizeof(knob.Value), "%d", std::max(1, (int)value / 2));
+		}
+	}
+	void ResetQualityKnobs(std::vector<QualityKnob>& knobs)
+	{
+		for (auto& knob : knobs) {
+			strncpy(knob.Value, knob.Default.c_str(), sizeof(knob.Value) - 1);
+			knob.Value[sizeof(knob.Value) - 1] = 0;
+		}
+	}
+}
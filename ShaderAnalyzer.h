@@ -0,0 +1,123 @@
+#pragma once
+#include "RenderPass.h"
+#include <vector>
+#include <string>
+
+#define UNKNOWN_LOOP_ITERATIONS 32 // assumed iteration count of loops without a constant bound
+
+namespace st
+{
+	enum class TokenType
+	{
+		Identifier,
+		Number,
+		Symbol
+	};
+	struct Token
+	{
+		TokenType Type;
+		std::string Text;
+		int Line;
+		int Source; // 0 = pass code, 1 = common code
+		size_t Offset; // position in the code
+	};
+	struct Define
+	{
+		std::string Name;
+		std::string Value;
+		int Line;
+		int Source;
+		bool IsFunction; // #define NAME(x) ...
+		bool IsGlobal; // not inside of a function body
+	};
+
+	/* splits GLSL code into tokens (comments are removed) and collects the #define directives */
+	void TokenizeGLSL(const std::string& code, int source, std::vector<Token>& tokens, std::vector<Define>& defines);
+	size_t FindMatchingToken(const std::vector<Token>& tokens, size_t open);
+	bool IsTextureFunction(const std::string& name); // texture, textureLod, texelFetch, ...
+	bool GetNumericValue(const std::string& value, const std::vector<Define>& defines, double& out, int depth = 0);
+
+	/* token pattern helpers - i is moved past the matched tokens */
+	bool MatchSequence(const std::vector<Token>& tokens, size_t& i, const std::vector<std::string>& seq);
+	bool MatchFragCoord(const std::vector<Token>& tokens, size_t& i, const std::string& fragCoord);
+	bool IsModified(const std::vector<Token>& tokens, size_t begin, size_t end, const std::string& name, size_t declaration);
+	bool FindFunction(const std::vector<Token>& tokens, const char* name, size_t& argsOpen, size_t& bodyOpen, size_t& bodyClose);
+	bool DirectivesUse(const std::string& code, const std::string& name); // name appears in a preprocessor directive
+
+	struct LoopCost
+	{
+		std::string Function;
+		int Line;
+		int Source;
+		int Depth; // nesting level inside of the function
+		int Iterations; // -1 if the bound isn't a constant
+		bool Raymarch;
+	};
+	struct PassCost
+	{
+		std::string Name;
+		double TextureFetches; // per pixel
+		double Instructions; // approximate ALU + fetch instructions per pixel
+		double PixelScale; // rendered pixels relative to the screen
+		std::vector<LoopCost> Loops;
+	};
+
+	struct PassDependencies
+	{
+		bool Time; // iTime, iTimeDelta, iDate, ...
+		bool Frame; // iFrame
+		bool Mouse; // iMouse
+		bool Feedback; // reads its own (or a later rendered, lower index buffer's) output from the previous frame
+		bool DynamicInput; // keyboard, video, sound or a non-static buffer/Cube A
+
+		inline bool IsStatic() const { return !Time && !Frame && !Mouse && !Feedback && !DynamicInput; }
+	};
+	std::vector<PassDependencies> AnalyzeDependencies(const std::vector<RenderPass>& passes); // buffers & Cube A
+	std::string FindCubemapBuffer(const std::vector<RenderPass>& data, const ShaderInput& inp); // name of the Cube A pass that inp reads, if any
+	std::vector<std::string> FindCommonUsers(const std::string& commonCode, const char* name); // Common functions & macros that use name
+	const char* GetChannelSamplerType(const RenderPass& pass, int channel); // sampler2D unless a cubemap or a volume is bound
+	bool UsesIdentifier(const std::vector<Token>& tokens, const std::vector<Define>& defines, const char* name);
+
+	struct BufferFormat
+	{
+		std::string Name; // RGBA8, RGBA16F, RG32F, ...
+		std::string HostName; // the name in SHADERed's project files: R8G8B8A8_UNORM, R16G16B16A16_FLOAT, ...
+		int Channels;
+		int BytesPerPixel;
+		std::string Reason;
+	};
+	struct TextureMemory
+	{
+		std::string Name;
+		BufferFormat Format;
+		double PixelScale; // relative to the window
+		int Width, Height; // fixed size (0 = window size)
+		bool Mipmaps;
+	};
+	BufferFormat GetBufferFormat(const std::string& name);
+	BufferFormat InferBufferFormat(const std::vector<RenderPass>& passes, int index);
+	int GetReadComponents(const RenderPass& reader, int channel); // highest component read from iChannelN, 4 if unknown
+	std::string FormatMemoryReport(const std::vector<TextureMemory>& textures);
+
+	/* global numeric #define-s (AA, MAX_STEPS, ...) that can be overriden through pass macros */
+	struct QualityKnob
+	{
+		std::string Name;
+		std::string Default;
+		char Value[64];
+		bool InCommon;
+		std::vector<std::string> Passes;
+	};
+
+	PassCost AnalyzePassCost(const RenderPass& pass, const std::string& commonCode, const std::vector<QualityKnob>& knobs);
+	std::vector<PassCost> AnalyzePipelineCost(const std::vector<RenderPass>& passes, const std::vector<QualityKnob>& knobs);
+
+	const char* GetCostRating(const PassCost& cost);
+	std::string FormatCostReport(const std::vector<PassCost>& costs);
+
+	std::vector<QualityKnob> FindQualityKnobs(const std::vector<RenderPass>& passes);
+	/* wraps the knobs' #define-s in #ifndef, the following lines are renumbered with #line starting from firstLine (if > 0) */
+	std::string GuardQualityKnobs(const std::string& code, const std::vector<QualityKnob>& knobs, int firstLine = 0);
+	void ApplyPerformancePreset(std::vector<QualityKnob>& knobs);
+	void ResetQualityKnobs(std::vector<QualityKnob>& knobs);
+}
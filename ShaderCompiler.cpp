@@ -0,0 +1,352 @@
+#include "ShaderCompiler.h"
+#include <ghc/filesystem.hpp>
+#include <glslang/Public/ShaderLang.h>
+#include <glslang/Public/ResourceLimits.h>
+#include <glslang/SPIRV/GlslangToSpv.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdio>
+
+#define MAX_INCLUDE_DEPTH 16
+
+namespace st
+{
+	unsigned long long HashFNV1a(const void* data, size_t len, unsigned long long hash = 14695981039346656037ULL)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < len; i++) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+	unsigned long long HashFNV1a(const std::string& str, unsigned long long hash = 14695981039346656037ULL)
+	{
+		// also hash the length so that "ab"+"c" and "a"+"bc" differ
+		unsigned long long len = str.size();
+		hash = HashFNV1a(&len, sizeof(len), hash);
+		return HashFNV1a(str.c_str(), str.size(), hash);
+	}
+
+	EShLanguage GetGlslangStage(ed::plugin::ShaderStage stage)
+	{
+		switch (stage) {
+		case ed::plugin::ShaderStage::Vertex: return EShLangVertex;
+		case ed::plugin::ShaderStage::Geometry: return EShLangGeometry;
+		case ed::plugin::ShaderStage::Compute: return EShLangCompute;
+		default: return EShLangFragment;
+		}
+	}
+
+	ShaderCompiler::ShaderCompiler()
+	{
+		m_cached = false;
+		glslang::InitializeProcess();
+	}
+	ShaderCompiler::~ShaderCompiler()
+	{
+		glslang::FinalizeProcess();
+	}
+
+	void ShaderCompiler::SetCacheDirectory(const std::string& dir)
+	{
+		m_cacheDir = dir;
+
+		std::error_code ec;
+		if (!m_cacheDir.empty() && !ghc::filesystem::exists(m_cacheDir, ec))
+			ghc::filesystem::create_directories(m_cacheDir, ec);
+	}
+	void ShaderCompiler::ClearCache()
+	{
+		m_files.clear();
+		m_memCache.clear();
+		m_memCacheOrder.clear();
+
+		std::error_code ec;
+		if (!m_cacheDir.empty())
+			for (const auto& entry : ghc::filesystem::directory_iterator(m_cacheDir, ec))
+				if (entry.path().extension() == ".spv")
+					ghc::filesystem::remove(entry.path(), ec);
+	}
+
+	bool ShaderCompiler::Compile(const char* src, size_t srcLen, ed::plugin::ShaderStage stage, const char* entry, const ed::plugin::ShaderMacro* macros, size_t macroCount, std::vector<unsigned int>& spv)
+	{
+		m_msgs.clear();
+		m_cached = false;
+		m_includedFiles.clear();
+
+		// expand the #include-s first - their content is part of the cache key
+		std::string code = m_expand(std::string(src, srcLen), 0, 0);
+		std::string source = m_buildSource(code, stage);
+
+		std::string preamble = "";
+		for (size_t i = 0; i < macroCount; i++) {
+			if (!macros[i].Active)
+				continue;
+			preamble += "#define " + std::string(macros[i].Name) + " " + std::string(macros[i].Value) + "\n";
+		}
+
+		std::string entryName = (entry == nullptr || stage == ed::plugin::ShaderStage::Pixel) ? "main" : entry;
+
+		unsigned long long hash = HashFNV1a(source);
+		hash = HashFNV1a(preamble, hash);
+		hash = HashFNV1a(entryName, hash);
+		int stageID = (int)stage;
+		hash = HashFNV1a(&stageID, sizeof(stageID), hash);
+
+		// memory cache
+		auto memIt = m_memCache.find(hash);
+		if (memIt != m_memCache.end()) {
+			spv = memIt->second;
+			m_cached = true;
+			return true;
+		}
+
+		// disk cache
+		if (m_loadFromDisk(hash, spv)) {
+			m_storeInMemory(hash, spv);
+			m_cached = true;
+			return true;
+		}
+
+		// actually compile the shader
+		EShLanguage lang = GetGlslangStage(stage);
+		const char* sourcePtr = source.c_str();
+		EShMessages messages = (EShMessages)(EShMsgSpvRules);
+
+		glslang::TShader shader(lang);
+		shader.setStrings(&sourcePtr, 1);
+		shader.setPreamble(preamble.c_str());
+		shader.setEntryPoint(entryName.c_str());
+		shader.setEnvInput(glslang::EShSourceGlsl, lang, glslang::EShClientOpenGL, 100);
+		shader.setEnvClient(glslang::EShClientOpenGL, glslang::EShTargetOpenGL_450);
+		shader.setEnvTarget(glslang::EShTargetSpv, glslang::EShTargetSpv_1_0);
+		shader.setAutoMapLocations(true);
+		shader.setAutoMapBindings(true);
+
+		if (!shader.parse(GetDefaultResources(), 100, false, messages)) {
+			m_parseLog(shader.getInfoLog());
+			return false;
+		}
+
+		glslang::TProgram prog;
+		prog.addShader(&shader);
+		if (!prog.link(messages) || !prog.mapIO()) {
+			m_parseLog(prog.getInfoLog());
+			return false;
+		}
+
+		spv.clear();
+		glslang::SpvOptions spvOptions;
+		spvOptions.generateDebugInfo = false;
+		glslang::GlslangToSpv(*prog.getIntermediate(lang), spv, &spvOptions);
+
+		m_parseLog(shader.getInfoLog()); // warnings
+
+		m_storeInMemory(hash, spv);
+		m_saveToDisk(hash, spv);
+
+		return true;
+	}
+
+	const ShaderCompiler::CachedFile* ShaderCompiler::m_loadFile(const std::string& path)
+	{
+		std::error_code ec;
+		auto ftime = ghc::filesystem::last_write_time(path, ec);
+		if (ec)
+			return nullptr;
+		long long time = ftime.time_since_epoch().count();
+
+		auto it = m_files.find(path);
+		if (it != m_files.end() && it->second.Time == time)
+			return &it->second;
+
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open())
+			return nullptr;
+
+		std::stringstream ss;
+		ss << file.rdbuf();
+
+		CachedFile& data = m_files[path];
+		data.Time = time;
+		data.Content = ss.str();
+
+		return &data;
+	}
+	std::string ShaderCompiler::m_resolveInclude(const std::string& name)
+	{
+		std::error_code ec;
+		for (const auto& dir : m_includeDirs) {
+			ghc::filesystem::path path = ghc::filesystem::path(dir) / name;
+			if (ghc::filesystem::exists(path, ec))
+				return path.string();
+		}
+		return "";
+	}
+	std::string ShaderCompiler::m_expand(const std::string& src, int fileID, int depth)
+	{
+		std::string ret = "";
+		std::istringstream stream(src);
+		std::string line;
+		int lineNumber = 0;
+
+		while (std::getline(stream, line)) {
+			lineNumber++;
+
+			size_t first = line.find_first_not_of(" \t");
+			if (first == std::string::npos || line.compare(first, 8, "#include") != 0 || depth >= MAX_INCLUDE_DEPTH) {
+				ret += line + "\n";
+				continue;
+			}
+
+			size_t nameStart = line.find_first_of("<\"", first + 8);
+			size_t nameEnd = nameStart == std::string::npos ? std::string::npos : line.find_first_of(">\"", nameStart + 1);
+			if (nameEnd == std::string::npos) {
+				ret += line + "\n";
+				continue;
+			}
+
+			std::string name = line.substr(nameStart + 1, nameEnd - nameStart - 1);
+			std::string path = m_resolveInclude(name);
+			const CachedFile* file = path.empty() ? nullptr : m_loadFile(path);
+			if (file == nullptr) {
+				m_msgs.push_back({ false, "", lineNumber, "Failed to find include file " + name });
+				ret += "\n";
+				continue;
+			}
+
+			// include every file only once
+			if (std::count(m_includedFiles.begin(), m_includedFiles.end(), path) > 0) {
+				ret += "\n";
+				continue;
+			}
+			m_includedFiles.push_back(path);
+			int includeID = m_includedFiles.size();
+
+			ret += "#line 1 " + std::to_string(includeID) + "\n";
+			ret += m_expand(file->Content, includeID, depth + 1);
+			ret += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(fileID) + "\n";
+		}
+
+		return ret;
+	}
+	std::string ShaderCompiler::m_buildSource(const std::string& code, ed::plugin::ShaderStage stage)
+	{
+		// only pixel shaders are written in the "Shadertoy style"
+		if (stage != ed::plugin::ShaderStage::Pixel)
+			return code;
+
+		// the importer marks the channels that aren't 2D textures: #define SHADERTOY_CHANNEL0_TYPE samplerCube
+		std::string channels = "";
+		for (int i = 0; i < 4; i++) {
+			std::string marker = "#define SHADERTOY_CHANNEL" + std::to_string(i) + "_TYPE ";
+			size_t pos = code.find(marker);
+			std::string type = "sampler2D";
+			if (pos != std::string::npos) {
+				pos += marker.size();
+				type = code.substr(pos, code.find_first_of(" \t\r\n", pos) - pos);
+			}
+			channels += "uniform " + type + " iChannel" + std::to_string(i) + ";\n";
+		}
+
+		return "#version 330\n\n"
+			"uniform vec2 iResolution;\n"
+			"uniform float iTime;\n"
+			"uniform float iTimeDelta;\n"
+			"uniform int iFrame;\n"
+			"uniform vec4 iMouse;\n" + channels +
+			"out vec4 shadertoy_outcolor;\n"
+			"#line 1 0\n" + code + "\n"
+			"#ifdef SHADERTOY_RENDER_ONCE\n"
+			"uniform vec2 iResolutionLast;\n"
+			"#endif\n"
+			"void main()\n{\n"
+			"#ifdef SHADERTOY_RENDER_ONCE\n"
+			"\tif (iFrame > 0 && iResolution == iResolutionLast)\n"
+			"\t\tdiscard;\n"
+			"#endif\n"
+			"\tmainImage(shadertoy_outcolor, gl_FragCoord.xy);\n"
+			"}\n";
+	}
+	void ShaderCompiler::m_parseLog(const std::string& log)
+	{
+		// ERROR: <string>:<line>: <message>
+		std::istringstream stream(log);
+		std::string line;
+		while (std::getline(stream, line)) {
+			bool isError = line.compare(0, 6, "ERROR:") == 0;
+			bool isWarning = line.compare(0, 8, "WARNING:") == 0;
+			if (!isError && !isWarning)
+				continue;
+
+			int fileID = 0, lineNumber = -1, consumed = 0;
+			size_t msgStart = isError ? 6 : 8;
+			if (sscanf(line.c_str() + msgStart, " %d:%d:%n", &fileID, &lineNumber, &consumed) == 2 && consumed > 0)
+				msgStart += consumed;
+			else {
+				fileID = 0;
+				lineNumber = -1;
+			}
+
+			std::string text = line.substr(std::min(msgStart, line.size()));
+			size_t textStart = text.find_first_not_of(' ');
+			text = textStart == std::string::npos ? "" : text.substr(textStart);
+			if (text.empty() || text.find("compilation errors.") != std::string::npos)
+				continue;
+
+			std::string file = "";
+			if (fileID > 0 && fileID <= m_includedFiles.size())
+				file = ghc::filesystem::path(m_includedFiles[fileID - 1]).filename().string();
+
+			m_msgs.push_back({ isError, file, lineNumber, text });
+		}
+	}
+
+	bool ShaderCompiler::m_loadFromDisk(unsigned long long hash, std::vector<unsigned int>& spv)
+	{
+		if (m_cacheDir.empty())
+			return false;
+
+		char filename[32];
+		snprintf(filename, sizeof(filename), "%016llx.spv", hash);
+
+		std::ifstream file((ghc::filesystem::path(m_cacheDir) / filename).string(), std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+			return false;
+
+		size_t size = file.tellg();
+		if (size < 5 * sizeof(unsigned int) || size % sizeof(unsigned int) != 0)
+			return false;
+
+		spv.resize(size / sizeof(unsigned int));
+		file.seekg(0);
+		file.read((char*)spv.data(), size);
+
+		return file.good() && spv[0] == 0x07230203; // SPIR-V magic number
+	}
+	void ShaderCompiler::m_saveToDisk(unsigned long long hash, const std::vector<unsigned int>& spv)
+	{
+		if (m_cacheDir.empty())
+			return;
+
+		char filename[32];
+		snprintf(filename, sizeof(filename), "%016llx.spv", hash);
+
+		std::ofstream file((ghc::filesystem::path(m_cacheDir) / filename).string(), std::ios::binary);
+		file.write((const char*)spv.data(), spv.size() * sizeof(unsigned int));
+		file.close();
+	}
+	void ShaderCompiler::m_storeInMemory(unsigned long long hash, const std::vector<unsigned int>& spv)
+	{
+		if (m_memCacheOrder.size() >= SPIRV_MEMORY_CACHE_SIZE) {
+			m_memCache.erase(m_memCacheOrder.front());
+			m_memCacheOrder.pop_front();
+		}
+
+		m_memCache[hash] = spv;
+		m_memCacheOrder.push_back(hash);
+	}
+}
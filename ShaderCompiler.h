@@ -0,0 +1,66 @@
+#pragma once
+#include <PluginAPI/PluginData.h>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <deque>
+
+#define SPIRV_MEMORY_CACHE_SIZE 256 // number of SPIR-V binaries kept in memory
+
+namespace st
+{
+	struct CompileMessage
+	{
+		bool Error;
+		std::string File; // empty when the message belongs to the shader itself
+		int Line;
+		std::string Text;
+	};
+
+	/* compiles Shadertoy-style GLSL (raw mainImage code) to SPIR-V - results are cached
+	   in memory and on disk, keyed by the hash of the expanded source, stage, entry & macros */
+	class ShaderCompiler
+	{
+	public:
+		ShaderCompiler();
+		~ShaderCompiler();
+
+		void SetCacheDirectory(const std::string& dir);
+		void SetIncludeDirectories(const std::vector<std::string>& dirs) { m_includeDirs = dirs; }
+
+		bool Compile(const char* src, size_t srcLen, ed::plugin::ShaderStage stage, const char* entry, const ed::plugin::ShaderMacro* macros, size_t macroCount, std::vector<unsigned int>& spv);
+
+		inline const std::vector<CompileMessage>& GetMessages() const { return m_msgs; }
+		inline bool WasCached() const { return m_cached; }
+
+		void ClearCache();
+
+	private:
+		struct CachedFile
+		{
+			long long Time;
+			std::string Content;
+		};
+
+		const CachedFile* m_loadFile(const std::string& path);
+		std::string m_resolveInclude(const std::string& name);
+		std::string m_expand(const std::string& src, int fileID, int depth);
+		std::string m_buildSource(const std::string& code, ed::plugin::ShaderStage stage);
+		void m_parseLog(const std::string& log);
+
+		bool m_loadFromDisk(unsigned long long hash, std::vector<unsigned int>& spv);
+		void m_saveToDisk(unsigned long long hash, const std::vector<unsigned int>& spv);
+		void m_storeInMemory(unsigned long long hash, const std::vector<unsigned int>& spv);
+
+		std::string m_cacheDir;
+		std::vector<std::string> m_includeDirs;
+		std::vector<std::string> m_includedFiles; // index + 1 == source string number
+
+		std::unordered_map<std::string, CachedFile> m_files;
+		std::unordered_map<unsigned long long, std::vector<unsigned int>> m_memCache;
+		std::deque<unsigned long long> m_memCacheOrder;
+
+		std::vector<CompileMessage> m_msgs;
+		bool m_cached;
+	};
+}
@@ -0,0 +1,315 @@
+#include "ShaderIndex.h"
+#include <json11/json11.hpp>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace st
+{
+	/////// FILTER ///////
+	struct FilterTerm
+	{
+		const char* Name;
+		unsigned short Passes, Inputs, Flags;
+	};
+	const FilterTerm FilterTerms[] = {
+		{ "image", SHADER_PASS_IMAGE, 0, 0 },
+		{ "buffera", SHADER_PASS_BUFFER_A, 0, 0 },
+		{ "bufferb", SHADER_PASS_BUFFER_A << 1, 0, 0 },
+		{ "bufferc", SHADER_PASS_BUFFER_A << 2, 0, 0 },
+		{ "bufferd", SHADER_PASS_BUFFER_A << 3, 0, 0 },
+		{ "cubea", SHADER_PASS_CUBE_A, 0, 0 },
+		{ "sound", SHADER_PASS_SOUND, 0, 0 },
+		{ "common", SHADER_PASS_COMMON, 0, 0 },
+		{ "texture", 0, SHADER_INPUT_TEXTURE, 0 },
+		{ "cubemap", 0, SHADER_INPUT_CUBEMAP, 0 },
+		{ "volume", 0, SHADER_INPUT_VOLUME, 0 },
+		{ "buffer", 0, SHADER_INPUT_BUFFER, 0 },
+		{ "keyboard", 0, SHADER_INPUT_KEYBOARD, 0 },
+		{ "music", 0, SHADER_INPUT_MUSIC, 0 },
+		{ "musicstream", 0, SHADER_INPUT_MUSICSTREAM, 0 },
+		{ "mic", 0, SHADER_INPUT_MIC, 0 },
+		{ "webcam", 0, SHADER_INPUT_WEBCAM, 0 },
+		{ "video", 0, SHADER_INPUT_VIDEO, 0 },
+		{ "mouse", 0, 0, SHADER_FLAG_MOUSE },
+		{ "vr", 0, 0, SHADER_FLAG_VR },
+		{ "feedback", 0, 0, SHADER_FLAG_FEEDBACK },
+	};
+
+	bool AddFilterTerm(ShaderIndexFilter& filter, const std::string& term)
+	{
+		if (term.compare(0, 8, "passes>=") == 0) {
+			filter.MinPasses = atoi(term.c_str() + 8);
+			return true;
+		}
+
+		for (const auto& known : FilterTerms)
+			if (term == known.Name) {
+				filter.Passes |= known.Passes;
+				filter.Inputs |= known.Inputs;
+				filter.Flags |= known.Flags;
+				return true;
+			}
+		return false;
+	}
+
+	/////// WRITER ///////
+	unsigned int AddString(std::vector<char>& table, const std::string& str)
+	{
+		unsigned int offset = table.size();
+		table.insert(table.end(), str.begin(), str.end());
+		table.push_back(0);
+		return offset;
+	}
+	bool ParseIndexRecord(const std::string& id, const std::string& response, ShaderIndexRecord& record, std::vector<char>& strings)
+	{
+		std::string err;
+		json11::Json jdata = json11::Json::parse(response, err);
+		const json11::Json& shader = jdata["Shader"];
+		if (!err.empty() || !shader.is_object())
+			return false;
+
+		const json11::Json& info = shader["info"];
+		std::string tags = "";
+		for (const auto& tag : info["tags"].array_items())
+			tags += (tags.empty() ? "" : " ") + tag.string_value();
+
+		record.Date = strtoul(info["date"].string_value().c_str(), nullptr, 10);
+		record.Views = info["viewed"].int_value();
+		record.Likes = info["likes"].int_value();
+		record.Name = AddString(strings, info["name"].string_value());
+		record.Author = AddString(strings, info["username"].string_value());
+		record.Tags = AddString(strings, tags);
+
+		const auto& passes = shader["renderpass"].array_items();
+		record.PassCount = passes.size();
+		for (const auto& pass : passes) {
+			const std::string& type = pass["type"].string_value();
+			const std::string& name = pass["name"].string_value();
+			const std::string& code = pass["code"].string_value();
+			record.CodeSize += code.size();
+
+			if (type == "image")
+				record.Passes |= SHADER_PASS_IMAGE;
+			else if (type == "buffer" && !name.empty() && name.back() >= 'A' && name.back() <= 'D')
+				record.Passes |= SHADER_PASS_BUFFER_A << (name.back() - 'A');
+			else if (type == "cubemap")
+				record.Passes |= SHADER_PASS_CUBE_A;
+			else if (type == "sound")
+				record.Passes |= SHADER_PASS_SOUND;
+			else if (type == "common")
+				record.Passes |= SHADER_PASS_COMMON;
+
+			if (code.find("iMouse") != std::string::npos)
+				record.Flags |= SHADER_FLAG_MOUSE;
+			if (code.find("mainVR") != std::string::npos)
+				record.Flags |= SHADER_FLAG_VR;
+
+			int outputID = pass["outputs"].array_items().empty() ? -1 : pass["outputs"][0]["id"].int_value();
+			for (const auto& inp : pass["inputs"].array_items()) {
+				const std::string& ctype = inp["ctype"].string_value();
+				if (ctype == "texture") record.Inputs |= SHADER_INPUT_TEXTURE;
+				else if (ctype == "cubemap") record.Inputs |= SHADER_INPUT_CUBEMAP;
+				else if (ctype == "volume") record.Inputs |= SHADER_INPUT_VOLUME;
+				else if (ctype == "buffer") record.Inputs |= SHADER_INPUT_BUFFER;
+				else if (ctype == "keyboard") record.Inputs |= SHADER_INPUT_KEYBOARD;
+				else if (ctype == "music") record.Inputs |= SHADER_INPUT_MUSIC;
+				else if (ctype == "musicstream") record.Inputs |= SHADER_INPUT_MUSICSTREAM;
+				else if (ctype == "mic") record.Inputs |= SHADER_INPUT_MIC;
+				else if (ctype == "webcam") record.Inputs |= SHADER_INPUT_WEBCAM;
+				else if (ctype == "video") record.Inputs |= SHADER_INPUT_VIDEO;
+
+				if (type == "buffer" && ctype == "buffer" && inp["id"].int_value() == outputID)
+					record.Flags |= SHADER_FLAG_FEEDBACK;
+			}
+		}
+
+		return true;
+	}
+
+	bool WriteShaderIndex(const ShaderStore& store, const std::string& path, int* parsed)
+	{
+		// the old index supplies the records of the responses that didn't change
+		ShaderIndex oldIndex;
+		oldIndex.Open(path);
+
+		std::vector<std::string> ids = store.GetIDs(); // sorted
+		std::vector<ShaderIndexRecord> records;
+		std::vector<char> strings;
+		records.reserve(ids.size());
+
+		int parseCount = 0;
+		for (const auto& id : ids) {
+			ShaderRecord stored;
+			if (id.size() >= sizeof(ShaderIndexRecord::ID) || !store.GetRecord(id, stored))
+				continue;
+
+			ShaderIndexRecord record;
+			const ShaderIndexRecord* old = oldIndex.Find(id);
+			if (old != nullptr && old->CRC == stored.CRC) {
+				record = *old;
+				record.Name = AddString(strings, oldIndex.GetString(old->Name));
+				record.Author = AddString(strings, oldIndex.GetString(old->Author));
+				record.Tags = AddString(strings, oldIndex.GetString(old->Tags));
+			} else {
+				memset(&record, 0, sizeof(record));
+				std::string response;
+				if (!store.Get(id, response) || !ParseIndexRecord(id, response, record, strings))
+					continue;
+				record.CRC = stored.CRC;
+				parseCount++;
+			}
+
+			memset(record.ID, 0, sizeof(record.ID));
+			memcpy(record.ID, id.data(), id.size());
+			records.push_back(record);
+		}
+		oldIndex.Close();
+
+		if (parsed != nullptr)
+			*parsed = parseCount;
+
+		ShaderIndexHeader header;
+		memcpy(header.Magic, "STIX", 4);
+		header.Version = SHADER_INDEX_VERSION;
+		header.RecordCount = records.size();
+		header.StringTableSize = strings.size();
+
+		// written to a temporary file first since the old index might still be mapped somewhere else
+		std::string tempPath = path + ".tmp";
+		FILE* file = fopen(tempPath.c_str(), "wb");
+		if (file == nullptr)
+			return false;
+
+		bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+		if (!records.empty())
+			ok &= fwrite(records.data(), sizeof(ShaderIndexRecord), records.size(), file) == records.size();
+		if (!strings.empty())
+			ok &= fwrite(strings.data(), 1, strings.size(), file) == strings.size();
+		ok &= fclose(file) == 0;
+
+		if (ok) {
+			remove(path.c_str());
+			ok = rename(tempPath.c_str(), path.c_str()) == 0;
+		}
+		return ok;
+	}
+
+	/////// READER ///////
+#ifdef _WIN32
+	ShaderIndex::ShaderIndex() : m_header(nullptr), m_records(nullptr), m_strings(nullptr), m_size(0), m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr) { }
+#else
+	ShaderIndex::ShaderIndex() : m_header(nullptr), m_records(nullptr), m_strings(nullptr), m_size(0), m_file(-1) { }
+#endif
+	ShaderIndex::~ShaderIndex()
+	{
+		Close();
+	}
+	bool ShaderIndex::Open(const std::string& path)
+	{
+		Close();
+
+		const void* view = nullptr;
+#ifdef _WIN32
+		m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER size;
+		GetFileSizeEx(m_file, &size);
+		m_size = (size_t)size.QuadPart;
+		m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_mapping != nullptr)
+			view = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+		m_file = open(path.c_str(), O_RDONLY);
+		if (m_file < 0)
+			return false;
+
+		struct stat info;
+		if (fstat(m_file, &info) == 0 && info.st_size > 0) {
+			m_size = info.st_size;
+			view = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+			if (view == MAP_FAILED)
+				view = nullptr;
+		}
+#endif
+
+		m_header = (const ShaderIndexHeader*)view;
+		if (m_header == nullptr || m_size < sizeof(ShaderIndexHeader) || memcmp(m_header->Magic, "STIX", 4) != 0 ||
+			m_header->Version != SHADER_INDEX_VERSION ||
+			m_size != sizeof(ShaderIndexHeader) + (size_t)m_header->RecordCount * sizeof(ShaderIndexRecord) + m_header->StringTableSize) {
+			Close();
+			return false;
+		}
+
+		m_records = (const ShaderIndexRecord*)((const char*)view + sizeof(ShaderIndexHeader));
+		m_strings = (const char*)(m_records + m_header->RecordCount);
+		return true;
+	}
+	void ShaderIndex::Close()
+	{
+#ifdef _WIN32
+		if (m_header != nullptr)
+			UnmapViewOfFile(m_header);
+		if (m_mapping != nullptr)
+			CloseHandle(m_mapping);
+		if (m_file != INVALID_HANDLE_VALUE)
+			CloseHandle(m_file);
+		m_mapping = nullptr;
+		m_file = INVALID_HANDLE_VALUE;
+#else
+		if (m_header != nullptr)
+			munmap((void*)m_header, m_size);
+		if (m_file >= 0)
+			close(m_file);
+		m_file = -1;
+#endif
+		m_header = nullptr;
+		m_records = nullptr;
+		m_strings = nullptr;
+		m_size = 0;
+	}
+	const char* ShaderIndex::GetString(unsigned int offset) const
+	{
+		if (m_header == nullptr || offset >= m_header->StringTableSize)
+			return "";
+		return m_strings + offset;
+	}
+	const ShaderIndexRecord* ShaderIndex::Find(const std::string& id) const
+	{
+		if (m_header == nullptr || id.size() >= sizeof(ShaderIndexRecord::ID))
+			return nullptr;
+
+		char key[sizeof(ShaderIndexRecord::ID)] = { 0 };
+		memcpy(key, id.data(), id.size());
+
+		const ShaderIndexRecord* end = m_records + m_header->RecordCount;
+		const ShaderIndexRecord* it = std::lower_bound(m_records, end, key, [](const ShaderIndexRecord& record, const char* key) {
+			return memcmp(record.ID, key, sizeof(record.ID)) < 0;
+		});
+		if (it == end || memcmp(it->ID, key, sizeof(key)) != 0)
+			return nullptr;
+		return it;
+	}
+	void ShaderIndex::Filter(const ShaderIndexFilter& filter, std::vector<int>& indices) const
+	{
+		indices.clear();
+		for (int i = 0; i < GetCount(); i++) {
+			const ShaderIndexRecord& record = m_records[i];
+			if ((record.Passes & filter.Passes) == filter.Passes && (record.Inputs & filter.Inputs) == filter.Inputs &&
+				(record.Flags & filter.Flags) == filter.Flags && record.PassCount >= filter.MinPasses)
+				indices.push_back(i);
+		}
+	}
+}
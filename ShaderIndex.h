@@ -0,0 +1,105 @@
+#pragma once
+#include "ShaderStore.h"
+#include <string>
+#include <vector>
+
+#define SHADER_INDEX_FILE "shaders.idx"
+#define SHADER_INDEX_VERSION 1
+
+// passes
+#define SHADER_PASS_IMAGE (1 << 0)
+#define SHADER_PASS_BUFFER_A (1 << 1) // B, C & D follow
+#define SHADER_PASS_CUBE_A (1 << 5)
+#define SHADER_PASS_SOUND (1 << 6)
+#define SHADER_PASS_COMMON (1 << 7)
+
+// input types (ctype)
+#define SHADER_INPUT_TEXTURE (1 << 0)
+#define SHADER_INPUT_CUBEMAP (1 << 1)
+#define SHADER_INPUT_VOLUME (1 << 2)
+#define SHADER_INPUT_BUFFER (1 << 3)
+#define SHADER_INPUT_KEYBOARD (1 << 4)
+#define SHADER_INPUT_MUSIC (1 << 5)
+#define SHADER_INPUT_MUSICSTREAM (1 << 6)
+#define SHADER_INPUT_MIC (1 << 7)
+#define SHADER_INPUT_WEBCAM (1 << 8)
+#define SHADER_INPUT_VIDEO (1 << 9)
+
+// flags
+#define SHADER_FLAG_MOUSE (1 << 0) // iMouse is used
+#define SHADER_FLAG_VR (1 << 1) // has mainVR
+#define SHADER_FLAG_FEEDBACK (1 << 2) // a buffer reads its own output
+
+namespace st
+{
+	/* shaders.idx: the header, RecordCount records sorted by ID and then the string table (null terminated
+	   strings). Written next to shaders.dat so that the collection can be filtered without parsing the JSON. */
+	struct ShaderIndexHeader
+	{
+		char Magic[4]; // STIX
+		unsigned int Version;
+		unsigned int RecordCount;
+		unsigned int StringTableSize;
+	};
+	struct ShaderIndexRecord
+	{
+		char ID[8]; // null padded
+		unsigned int CRC; // of the stored response, unchanged records are reused when the index is rebuilt
+		unsigned int Date; // unix time of the publication
+		unsigned int Views;
+		unsigned int Likes;
+		unsigned int Name; // offsets into the string table
+		unsigned int Author;
+		unsigned int Tags; // space separated
+		unsigned int CodeSize; // of all passes together
+		unsigned short PassCount;
+		unsigned short Passes; // SHADER_PASS_*
+		unsigned short Inputs; // SHADER_INPUT_*
+		unsigned short Flags; // SHADER_FLAG_*
+	};
+
+	/* a shader matches when it has every pass, input type & flag in the filter */
+	struct ShaderIndexFilter
+	{
+		unsigned short Passes;
+		unsigned short Inputs;
+		unsigned short Flags;
+		int MinPasses;
+	};
+	/* "bufferd", "cubea", "cubemap", "keyboard", "mouse", "passes>=3", ... - false for unknown terms */
+	bool AddFilterTerm(ShaderIndexFilter& filter, const std::string& term);
+
+	/* rebuilds the index of every shader in the store - only the new & changed responses are parsed */
+	bool WriteShaderIndex(const ShaderStore& store, const std::string& path, int* parsed = nullptr);
+
+	/* memory-mapped shaders.idx */
+	class ShaderIndex
+	{
+	public:
+		ShaderIndex();
+		~ShaderIndex();
+
+		bool Open(const std::string& path);
+		void Close();
+
+		inline int GetCount() const { return m_header == nullptr ? 0 : m_header->RecordCount; }
+		inline const ShaderIndexRecord& GetRecord(int index) const { return m_records[index]; }
+		const char* GetString(unsigned int offset) const;
+		const ShaderIndexRecord* Find(const std::string& id) const;
+
+		void Filter(const ShaderIndexFilter& filter, std::vector<int>& indices) const;
+
+	private:
+		const ShaderIndexHeader* m_header;
+		const ShaderIndexRecord* m_records;
+		const char* m_strings;
+		size_t m_size;
+
+#ifdef _WIN32
+		void* m_file;
+		void* m_mapping;
+#else
+		int m_file;
+#endif
+	};
+}
@@ -0,0 +1,152 @@
+#include "ShaderMirror.h"
+#include "APIKey.h"
+#include <json11/json11.hpp>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <set>
+
+#define CPPHTTPLIB_OPENSSL_SUPPORT
+#include <httplib/httplib.h>
+
+#define MIRROR_MAX_RETRIES 3
+
+namespace st
+{
+	RateLimiter::RateLimiter(float requestsPerSecond)
+	{
+		m_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(requestsPerSecond > 0.0f ? 1.0 / requestsPerSecond : 0.0));
+		m_next = std::chrono::steady_clock::now();
+	}
+	void RateLimiter::Wait()
+	{
+		std::chrono::steady_clock::time_point slot;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			slot = std::max(m_next, std::chrono::steady_clock::now());
+			m_next = slot + m_interval;
+		}
+		std::this_thread::sleep_until(slot);
+	}
+
+	std::string EncodeURL(const std::string& str)
+	{
+		std::string ret = "";
+		char hex[4];
+		for (unsigned char c : str) {
+			if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~')
+				ret += c;
+			else {
+				snprintf(hex, sizeof(hex), "%%%02X", c);
+				ret += hex;
+			}
+		}
+		return ret;
+	}
+	/* retries with a growing delay when the server is busy (429 & 5xx) */
+	bool FetchAPI(httplib::SSLClient& cli, const std::string& path, RateLimiter& limiter, json11::Json& jdata)
+	{
+		for (int i = 0; i < MIRROR_MAX_RETRIES; i++) {
+			limiter.Wait();
+			auto res = cli.Get(path.c_str());
+			if (res && res->status == 200) {
+				std::string err;
+				jdata = json11::Json::parse(res->body, err);
+				return err.empty() && jdata.is_object() && !jdata["Error"].is_string();
+			}
+			if (res && res->status != 429 && res->status < 500)
+				return false;
+
+			std::this_thread::sleep_for(std::chrono::seconds(1 << i));
+		}
+		return false;
+	}
+
+	bool ListShaders(const CrawlOptions& opts, RateLimiter& limiter, std::vector<std::string>& ids)
+	{
+		httplib::SSLClient cli("www.shadertoy.com");
+
+		std::string endpoint = opts.Query.empty() ? "/api/v1/shaders" : "/api/v1/shaders/query/" + EncodeURL(opts.Query);
+		std::set<std::string> known(ids.begin(), ids.end());
+		for (int from = 0; opts.MaxShaders <= 0 || (int)ids.size() < opts.MaxShaders; from += MIRROR_PAGE_SIZE) {
+			std::string path = endpoint + "?key=" SHADERTOY_APIKEY "&from=" + std::to_string(from) + "&num=" + std::to_string(MIRROR_PAGE_SIZE);
+			if (!opts.Sort.empty())
+				path += "&sort=" + EncodeURL(opts.Sort);
+
+			json11::Json page;
+			if (!FetchAPI(cli, path, limiter, page))
+				return from > 0;
+
+			// an endpoint that ignores from/num returns everything at once - the next page has nothing new
+			int added = 0;
+			for (const auto& id : page["Results"].array_items()) {
+				if (!known.insert(id.string_value()).second)
+					continue;
+				ids.push_back(id.string_value());
+				added++;
+			}
+
+			if (added == 0 || (int)ids.size() >= page["Shaders"].int_value())
+				break;
+		}
+
+		if (opts.MaxShaders > 0 && (int)ids.size() > opts.MaxShaders)
+			ids.resize(opts.MaxShaders);
+		return true;
+	}
+
+	void CrawlShaders(ShaderStore& store, const std::vector<std::string>& ids, const CrawlOptions& opts, RateLimiter& limiter, CrawlStats& stats,
+		const std::function<void(const std::string& id, const char* status)>& progress)
+	{
+		std::atomic<int> next(0), added(0), updated(0), unchanged(0), skipped(0), failed(0);
+
+		// every thread keeps its own connection alive
+		auto worker = [&]() {
+			httplib::SSLClient cli("www.shadertoy.com");
+			cli.set_keep_alive_max_count(100);
+
+			for (int i = next++; i < (int)ids.size(); i = next++) {
+				const std::string& id = ids[i];
+				if (!opts.Refresh && store.Has(id)) {
+					skipped++;
+					continue;
+				}
+
+				bool existed = store.Has(id), changed = false;
+				json11::Json jdata;
+				if (!FetchAPI(cli, "/api/v1/shaders/" + id + "?key=" SHADERTOY_APIKEY, limiter, jdata) || !jdata["Shader"].is_object() ||
+					!store.Put(id, jdata.dump(), &changed)) {
+					failed++;
+					progress(id, "failed");
+					continue;
+				}
+
+				if (!changed) {
+					unchanged++;
+					progress(id, "unchanged");
+				} else if (existed) {
+					updated++;
+					progress(id, "updated");
+				} else {
+					added++;
+					progress(id, "added");
+				}
+			}
+		};
+
+		int threadCount = std::max(1, opts.Threads);
+		std::vector<std::thread> threads;
+		for (int i = 1; i < threadCount; i++)
+			threads.push_back(std::thread(worker));
+		worker();
+		for (auto& thread : threads)
+			thread.join();
+
+		stats.Listed = ids.size();
+		stats.Added = added;
+		stats.Updated = updated;
+		stats.Unchanged = unchanged;
+		stats.Skipped = skipped;
+		stats.Failed = failed;
+	}
+}
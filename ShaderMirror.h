@@ -0,0 +1,47 @@
+#pragma once
+#include "ShaderStore.h"
+#include <functional>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <mutex>
+
+#define MIRROR_PAGE_SIZE 100 // shader IDs per listing request
+
+namespace st
+{
+	struct CrawlOptions
+	{
+		std::string Query; // search string, empty = every public shader
+		std::string Sort; // name, love, popular, newest or hot
+		int MaxShaders; // 0 = no limit
+		int Threads; // concurrent shader requests
+		float RequestsPerSecond; // shared by all threads
+		bool Refresh; // fetch the shaders that are already stored again
+	};
+	struct CrawlStats
+	{
+		int Listed, Added, Updated, Unchanged, Skipped, Failed;
+	};
+
+	/* spaces the requests of all threads evenly */
+	class RateLimiter
+	{
+	public:
+		RateLimiter(float requestsPerSecond);
+		void Wait();
+
+	private:
+		std::mutex m_mutex;
+		std::chrono::steady_clock::duration m_interval;
+		std::chrono::steady_clock::time_point m_next;
+	};
+
+	/* pages through the listing (or query) API until it runs out of new IDs */
+	bool ListShaders(const CrawlOptions& opts, RateLimiter& limiter, std::vector<std::string>& ids);
+
+	/* fetches the listed shaders into the store on opts.Threads threads - status is "added", "updated",
+	   "unchanged" or "failed" and is reported from the worker threads */
+	void CrawlShaders(ShaderStore& store, const std::vector<std::string>& ids, const CrawlOptions& opts, RateLimiter& limiter, CrawlStats& stats,
+		const std::function<void(const std::string& id, const char* status)>& progress);
+}
@@ -0,0 +1,154 @@
+#include "ShaderMirror.h"
+#include "ShaderIndex.h"
+#include "CodeIndex.h"
+#include <algorithm>
+#include <sstream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/* mirrors the metadata of public shaders into a local store & refreshes it incrementally:
+	shadermirror <store directory> [--query <search>] [--sort <name|love|popular|newest|hot>] [--max <count>]
+		[--threads <count>] [--rate <requests per second>] [--refresh]
+	shadermirror <store directory> --filter "<terms>"  (lists the stored shaders that match, e.g. "bufferd cubemap")
+	shadermirror <store directory> --search "<code>" [--hits <count>]  (ranked code search, e.g. "sdRoundBox") */
+int main(int argc, char* argv[])
+{
+	if (argc < 2) {
+		printf("usage: %s <store directory> [--query <search>] [--sort <order>] [--max <count>] [--threads <count>] [--rate <requests/s>] [--refresh]\n", argv[0]);
+		printf("       %s <store directory> --filter \"<terms>\"\n", argv[0]);
+		printf("       %s <store directory> --search \"<code>\" [--hits <count>]\n", argv[0]);
+		return 1;
+	}
+
+	st::CrawlOptions opts;
+	opts.Sort = "newest";
+	opts.MaxShaders = 0;
+	opts.Threads = 4;
+	opts.RequestsPerSecond = 8.0f;
+	opts.Refresh = false;
+	const char* filterTerms = nullptr;
+	const char* searchQuery = nullptr;
+	int maxHits = 20;
+	for (int i = 2; i < argc; i++) {
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--refresh") == 0)
+			opts.Refresh = true;
+		else if (strcmp(argv[i], "--filter") == 0 && hasValue)
+			filterTerms = argv[++i];
+		else if (strcmp(argv[i], "--search") == 0 && hasValue)
+			searchQuery = argv[++i];
+		else if (strcmp(argv[i], "--hits") == 0 && hasValue)
+			maxHits = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--query") == 0 && hasValue)
+			opts.Query = argv[++i];
+		else if (strcmp(argv[i], "--sort") == 0 && hasValue)
+			opts.Sort = argv[++i];
+		else if (strcmp(argv[i], "--max") == 0 && hasValue)
+			opts.MaxShaders = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--threads") == 0 && hasValue)
+			opts.Threads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--rate") == 0 && hasValue)
+			opts.RequestsPerSecond = (float)atof(argv[++i]);
+		else {
+			printf("unknown argument: %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	std::string indexPath = std::string(argv[1]) + "/" SHADER_INDEX_FILE;
+	if (filterTerms != nullptr) {
+		st::ShaderIndexFilter filter = { 0, 0, 0, 0 };
+		std::stringstream terms(filterTerms);
+		std::string term;
+		while (terms >> term)
+			if (!st::AddFilterTerm(filter, term)) {
+				printf("unknown filter term: %s\n", term.c_str());
+				return 1;
+			}
+
+		auto start = std::chrono::steady_clock::now();
+		st::ShaderIndex index;
+		if (!index.Open(indexPath)) {
+			printf("failed to open %s\n", indexPath.c_str());
+			return 1;
+		}
+		std::vector<int> matches;
+		index.Filter(filter, matches);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		for (int match : matches) {
+			const st::ShaderIndexRecord& record = index.GetRecord(match);
+			printf("%s  %s (%s)\n", record.ID, index.GetString(record.Name), index.GetString(record.Author));
+		}
+		printf("%d of %d shaders match (%.2f ms)\n", (int)matches.size(), index.GetCount(), ms);
+		return 0;
+	}
+
+	st::ShaderStore store;
+	if (!store.Open(argv[1])) {
+		printf("failed to open %s/" SHADER_STORE_FILE "\n", argv[1]);
+		return 1;
+	}
+
+	st::CodeIndex codeIndex;
+	if (!codeIndex.Open(argv[1])) {
+		printf("failed to open the code index in %s\n", argv[1]);
+		return 1;
+	}
+
+	if (searchQuery != nullptr) {
+		auto start = std::chrono::steady_clock::now();
+		std::vector<st::CodeSearchHit> hits;
+		codeIndex.Search(store, searchQuery, maxHits, hits);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		for (const auto& hit : hits)
+			printf("%s %4d  %s  [%s:%d] %s\n", hit.ID.c_str(), hit.Score, hit.Name.c_str(), hit.Pass.c_str(), hit.Line, hit.Snippet.c_str());
+		printf("%d hits in %d shaders (%.2f ms)\n", (int)hits.size(), codeIndex.GetCount(), ms);
+		return 0;
+	}
+
+	st::RateLimiter limiter(opts.RequestsPerSecond);
+	std::vector<std::string> ids;
+	if (!st::ListShaders(opts, limiter, ids)) {
+		printf("failed to list the shaders - is SHADERTOY_APIKEY set?\n");
+		return 1;
+	}
+	printf("%d shaders listed, %d already stored\n", (int)ids.size(), (int)store.GetCount());
+
+	std::mutex printMutex;
+	std::vector<std::string> changed;
+	st::CrawlStats stats;
+	st::CrawlShaders(store, ids, opts, limiter, stats, [&](const std::string& id, const char* status) {
+		std::lock_guard<std::mutex> lock(printMutex);
+		printf("%s: %s\n", status, id.c_str());
+		if (strcmp(status, "added") == 0 || strcmp(status, "updated") == 0)
+			changed.push_back(id);
+	});
+
+	// the code index also picks up the shaders that were stored before it existed
+	for (const auto& id : store.GetIDs())
+		if (!codeIndex.Has(id))
+			changed.push_back(id);
+	std::sort(changed.begin(), changed.end());
+	changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+	int indexed = 0;
+	for (const auto& id : changed) {
+		std::string response;
+		indexed += store.Get(id, response) && codeIndex.Add(id, response);
+	}
+	printf("code index updated (%d of %d shaders indexed)\n", indexed, (int)changed.size());
+
+	int parsed = 0;
+	if (!st::WriteShaderIndex(store, indexPath, &parsed))
+		printf("failed to write %s\n", indexPath.c_str());
+	else
+		printf("index updated (%d responses parsed)\n", parsed);
+
+	printf("%d shaders stored (%d added, %d updated, %d unchanged, %d skipped, %d failed)\n", (int)store.GetCount(),
+		stats.Added, stats.Updated, stats.Unchanged, stats.Skipped, stats.Failed);
+	return stats.Failed > 0 ? 1 : 0;
+}
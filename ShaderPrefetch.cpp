@@ -0,0 +1,146 @@
+#include "ShaderPrefetch.h"
+#include "MediaPack.h"
+#include "APIKey.h"
+#include <algorithm>
+
+#define CPPHTTPLIB_OPENSSL_SUPPORT
+#include <httplib/httplib.h>
+
+namespace st
+{
+	ShaderPrefetch::~ShaderPrefetch()
+	{
+		Cancel();
+		m_joinRetired(true);
+	}
+	void ShaderPrefetch::Start(const std::string& id, const std::string& mediaPackPath, const AssetLister& listAssets)
+	{
+		Cancel();
+
+		m_id = id;
+		m_state = std::make_shared<State>();
+		m_thread = std::thread(&ShaderPrefetch::m_run, m_state, id, mediaPackPath, listAssets);
+	}
+	void ShaderPrefetch::Cancel()
+	{
+		if (m_state != nullptr) {
+			m_state->Cancelled = true;
+			m_retired.push_back(std::make_pair(m_state, std::move(m_thread)));
+		}
+		m_state = nullptr;
+		m_id = "";
+		m_joinRetired(false);
+	}
+	bool ShaderPrefetch::IsFinished() const
+	{
+		if (m_state == nullptr)
+			return true;
+		std::lock_guard<std::mutex> lock(m_state->Mutex);
+		return m_state->Finished;
+	}
+	void ShaderPrefetch::GetProgress(int& done, int& total) const
+	{
+		done = m_state == nullptr ? 0 : m_state->FilesDone.load();
+		total = m_state == nullptr ? -1 : m_state->FilesTotal.load();
+	}
+	bool ShaderPrefetch::WaitForShader(json11::Json& jdata)
+	{
+		if (m_state == nullptr)
+			return false;
+
+		std::unique_lock<std::mutex> lock(m_state->Mutex);
+		m_state->Cond.wait(lock, [&]() { return m_state->ShaderDone; });
+		if (m_state->ShaderOk)
+			jdata = m_state->Shader;
+		return m_state->ShaderOk;
+	}
+	std::map<std::string, std::string> ShaderPrefetch::TakeFiles()
+	{
+		std::map<std::string, std::string> ret;
+		if (m_state == nullptr)
+			return ret;
+
+		m_state->Cancelled = true;
+		std::lock_guard<std::mutex> lock(m_state->Mutex);
+		ret.swap(m_state->Files);
+		return ret;
+	}
+
+	void ShaderPrefetch::m_run(std::shared_ptr<State> state, std::string id, std::string mediaPackPath, AssetLister listAssets)
+	{
+		httplib::SSLClient cli("www.shadertoy.com");
+		cli.set_keep_alive_max_count(100);
+
+		// abandoned downloads are stopped at the next chunk
+		std::string body;
+		auto receiver = [&](const char* data, size_t size) {
+			body.append(data, size);
+			return !state->Cancelled;
+		};
+
+		json11::Json jdata;
+		bool ok = false;
+		auto res = cli.Get(("/api/v1/shaders/" + id + "?key=" SHADERTOY_APIKEY).c_str(), receiver);
+		if (res && res->status == 200) {
+			std::string err;
+			jdata = json11::Json::parse(body, err);
+			ok = err.empty() && jdata.is_object() && !jdata["Error"].is_string() && jdata["Shader"].is_object();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(state->Mutex);
+			state->ShaderDone = true;
+			state->ShaderOk = ok;
+			state->Shader = jdata;
+		}
+		state->Cond.notify_all();
+
+		if (ok && !state->Cancelled) {
+			MediaPack media;
+			bool hasMedia = !mediaPackPath.empty() && media.Load(mediaPackPath);
+
+			std::vector<std::string> sources = listAssets(jdata);
+			std::sort(sources.begin(), sources.end());
+			sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+			if (hasMedia)
+				sources.erase(std::remove_if(sources.begin(), sources.end(), [&](const std::string& src) { return media.GetAssets().count(src) > 0; }), sources.end());
+
+			state->FilesTotal = sources.size();
+			for (const auto& source : sources) {
+				if (state->Cancelled)
+					break;
+
+				body.clear();
+				res = cli.Get(source.c_str(), receiver);
+				if (res && res->status == 200 && !state->Cancelled) {
+					std::lock_guard<std::mutex> lock(state->Mutex);
+					state->Files[source] = std::move(body);
+				}
+				state->FilesDone++;
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(state->Mutex);
+			state->Finished = true;
+		}
+		state->Cond.notify_all();
+	}
+	void ShaderPrefetch::m_joinRetired(bool all)
+	{
+		for (auto it = m_retired.begin(); it != m_retired.end();) {
+			bool finished = all;
+			if (!finished) {
+				std::lock_guard<std::mutex> lock(it->first->Mutex);
+				finished = it->first->Finished;
+			}
+
+			if (finished) {
+				if (it->second.joinable())
+					it->second.join();
+				it = m_retired.erase(it);
+			} else
+				++it;
+		}
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <json11/json11.hpp>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <map>
+
+namespace st
+{
+	/* speculative download of a shader's JSON & assets while the import dialog is still open - the TLS
+	   connection is opened right away and reused for every request. Starting another prefetch or cancelling
+	   abandons the running one without waiting for its request to finish; assets that are in the media pack
+	   are skipped. */
+	class ShaderPrefetch
+	{
+	public:
+		typedef std::function<std::vector<std::string>(const json11::Json&)> AssetLister;
+
+		ShaderPrefetch() { }
+		~ShaderPrefetch();
+
+		void Start(const std::string& id, const std::string& mediaPackPath, const AssetLister& listAssets);
+		void Cancel();
+
+		inline const std::string& GetID() const { return m_id; }
+		bool IsFinished() const;
+		void GetProgress(int& done, int& total) const; // assets, total is -1 until the JSON arrives
+
+		/* block until the JSON is downloaded - false if it failed or nothing is prefetched */
+		bool WaitForShader(json11::Json& jdata);
+
+		/* stops the downloads and returns the assets that have already arrived, without waiting for the rest */
+		std::map<std::string, std::string> TakeFiles();
+
+	private:
+		struct State
+		{
+			State() : Cancelled(false), Finished(false), ShaderDone(false), ShaderOk(false), FilesDone(0), FilesTotal(-1) { }
+
+			std::atomic<bool> Cancelled;
+			std::mutex Mutex;
+			std::condition_variable Cond;
+			bool Finished, ShaderDone, ShaderOk;
+			json11::Json Shader;
+			std::map<std::string, std::string> Files; // source -> data, added as the downloads finish
+			std::atomic<int> FilesDone, FilesTotal;
+		};
+		static void m_run(std::shared_ptr<State> state, std::string id, std::string mediaPackPath, AssetLister listAssets);
+		void m_joinRetired(bool all);
+
+		std::string m_id;
+		std::shared_ptr<State> m_state;
+		std::thread m_thread;
+		std::vector<std::pair<std::shared_ptr<State>, std::thread>> m_retired; // cancelled, joined once they finish
+	};
+}
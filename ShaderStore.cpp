@@ -0,0 +1,208 @@
+#include "ShaderStore.h"
+#include <ghc/filesystem.hpp>
+#include <zlib.h>
+#include <cstring>
+#include <ctime>
+
+#define SHADER_STORE_MAGIC "STSR"
+#define SHADER_STORE_HEADER_SIZE 28 // magic, ID length, compressed size, size, CRC, time (8 bytes)
+
+namespace st
+{
+	bool SeekFile(FILE* file, unsigned long long offset)
+	{
+#ifdef _WIN32
+		return _fseeki64(file, (long long)offset, SEEK_SET) == 0;
+#else
+		return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+	}
+	unsigned long long GetStoreFileSize(FILE* file)
+	{
+#ifdef _WIN32
+		_fseeki64(file, 0, SEEK_END);
+		return (unsigned long long)_ftelli64(file);
+#else
+		fseeko(file, 0, SEEK_END);
+		return (unsigned long long)ftello(file);
+#endif
+	}
+	unsigned int ReadU32(const unsigned char* data)
+	{
+		return data[0] | (data[1] << 8) | (data[2] << 16) | ((unsigned int)data[3] << 24);
+	}
+	void WriteU32(unsigned char* data, unsigned int value)
+	{
+		for (int i = 0; i < 4; i++)
+			data[i] = (unsigned char)(value >> (i * 8));
+	}
+
+	ShaderStore::ShaderStore() : m_file(nullptr), m_size(0) { }
+	ShaderStore::~ShaderStore()
+	{
+		Close();
+	}
+	bool ShaderStore::Open(const std::string& dir)
+	{
+		Close();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_dir = dir;
+
+		std::error_code ec;
+		ghc::filesystem::create_directories(dir, ec);
+
+		std::string path = dir + "/" SHADER_STORE_FILE;
+		m_file = fopen(path.c_str(), "r+b");
+		if (m_file == nullptr)
+			m_file = fopen(path.c_str(), "w+b");
+		if (m_file == nullptr)
+			return false;
+
+		// little endian headers: "STSR", u32 ID length, u32 compressed size, u32 size, u32 CRC, u64 time, then the ID & the data
+		unsigned long long fileSize = GetStoreFileSize(m_file);
+		unsigned char header[SHADER_STORE_HEADER_SIZE];
+		unsigned long long offset = 0;
+		SeekFile(m_file, 0);
+		while (fread(header, 1, SHADER_STORE_HEADER_SIZE, m_file) == SHADER_STORE_HEADER_SIZE && memcmp(header, SHADER_STORE_MAGIC, 4) == 0) {
+			ShaderRecord record;
+			unsigned int idLength = ReadU32(header + 4);
+			record.CompressedSize = ReadU32(header + 8);
+			record.Size = ReadU32(header + 12);
+			record.CRC = ReadU32(header + 16);
+			record.Time = (long long)(ReadU32(header + 20) | ((unsigned long long)ReadU32(header + 24) << 32));
+
+			if (idLength == 0 || idLength > 64)
+				break;
+			record.ID.resize(idLength);
+			if (fread(&record.ID[0], 1, idLength, m_file) != idLength)
+				break;
+
+			record.Offset = offset + SHADER_STORE_HEADER_SIZE + idLength;
+			unsigned long long end = record.Offset + record.CompressedSize;
+			if (end > fileSize || !SeekFile(m_file, end))
+				break;
+
+			m_records[record.ID] = record;
+			offset = end;
+		}
+
+		// drop the partially written record at the end
+		m_size = offset;
+		if (m_size < fileSize) {
+			fclose(m_file);
+			ghc::filesystem::resize_file(path, m_size, ec);
+			m_file = fopen(path.c_str(), "r+b");
+		}
+
+		return m_file != nullptr;
+	}
+	void ShaderStore::Close()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_file != nullptr)
+			fclose(m_file);
+		m_file = nullptr;
+		m_size = 0;
+		m_records.clear();
+	}
+	bool ShaderStore::Has(const std::string& id) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_records.count(id) > 0;
+	}
+	bool ShaderStore::Get(const std::string& id, std::string& json) const
+	{
+		std::vector<unsigned char> compressed;
+		ShaderRecord record;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto it = m_records.find(id);
+			if (m_file == nullptr || it == m_records.end())
+				return false;
+
+			record = it->second;
+			compressed.resize(record.CompressedSize);
+			if (!SeekFile(m_file, record.Offset) || fread(compressed.data(), 1, compressed.size(), m_file) != compressed.size())
+				return false;
+		}
+
+		json.resize(record.Size);
+		uLongf size = record.Size;
+		if (uncompress((Bytef*)&json[0], &size, compressed.data(), compressed.size()) != Z_OK || size != record.Size)
+			return false;
+
+		return crc32(0, (const Bytef*)json.data(), json.size()) == record.CRC;
+	}
+	bool ShaderStore::Put(const std::string& id, const std::string& json, bool* changed)
+	{
+		unsigned int crc = crc32(0, (const Bytef*)json.data(), json.size());
+		if (changed != nullptr)
+			*changed = true;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto it = m_records.find(id);
+			if (it != m_records.end() && it->second.CRC == crc && it->second.Size == json.size()) {
+				if (changed != nullptr)
+					*changed = false;
+				return true;
+			}
+		}
+
+		// compressed outside of the lock so that the crawler threads don't wait for each other
+		uLongf compressedSize = compressBound(json.size());
+		std::vector<unsigned char> data(SHADER_STORE_HEADER_SIZE + id.size() + compressedSize);
+		if (id.empty() || id.size() > 64 || compress2(data.data() + SHADER_STORE_HEADER_SIZE + id.size(), &compressedSize, (const Bytef*)json.data(), json.size(), Z_BEST_COMPRESSION) != Z_OK)
+			return false;
+		data.resize(SHADER_STORE_HEADER_SIZE + id.size() + compressedSize);
+
+		ShaderRecord record;
+		record.ID = id;
+		record.CompressedSize = compressedSize;
+		record.Size = json.size();
+		record.CRC = crc;
+		record.Time = (long long)time(nullptr);
+
+		memcpy(data.data(), SHADER_STORE_MAGIC, 4);
+		WriteU32(data.data() + 4, id.size());
+		WriteU32(data.data() + 8, record.CompressedSize);
+		WriteU32(data.data() + 12, record.Size);
+		WriteU32(data.data() + 16, record.CRC);
+		WriteU32(data.data() + 20, (unsigned int)(record.Time & 0xFFFFFFFF));
+		WriteU32(data.data() + 24, (unsigned int)((unsigned long long)record.Time >> 32));
+		memcpy(data.data() + SHADER_STORE_HEADER_SIZE, id.data(), id.size());
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_file == nullptr || !SeekFile(m_file, m_size) || fwrite(data.data(), 1, data.size(), m_file) != data.size() || fflush(m_file) != 0)
+			return false;
+
+		record.Offset = m_size + SHADER_STORE_HEADER_SIZE + id.size();
+		m_size += data.size();
+		m_records[id] = record;
+		return true;
+	}
+	std::vector<std::string> ShaderStore::GetIDs() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::vector<std::string> ret;
+		ret.reserve(m_records.size());
+		for (const auto& pair : m_records)
+			ret.push_back(pair.first);
+		return ret;
+	}
+	size_t ShaderStore::GetCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_records.size();
+	}
+	bool ShaderStore::GetRecord(const std::string& id, ShaderRecord& record) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_records.find(id);
+		if (it == m_records.end())
+			return false;
+		record = it->second;
+		return true;
+	}
+}
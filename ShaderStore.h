@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cstdio>
+
+#define SHADER_STORE_FILE "shaders.dat"
+
+namespace st
+{
+	/* 64 bit offsets - fseek/ftell take a long, which is 32 bit on Windows */
+	bool SeekFile(FILE* file, unsigned long long offset);
+	unsigned long long GetStoreFileSize(FILE* file); // moves to the end of the file
+
+	struct ShaderRecord
+	{
+		std::string ID;
+		unsigned long long Offset; // of the compressed data in the store file
+		unsigned int CompressedSize;
+		unsigned int Size;
+		unsigned int CRC; // of the uncompressed response
+		long long Time; // unix time of the fetch
+	};
+
+	/* local copies of Shadertoy API responses - an append-only file of zlib compressed records; storing a
+	   shader again appends a record that supersedes the old one. The ID index is rebuilt from the record
+	   headers when the store is opened, a record that was only partially written is cut off. Thread safe. */
+	class ShaderStore
+	{
+	public:
+		ShaderStore();
+		~ShaderStore();
+
+		bool Open(const std::string& dir); // creates the directory & the file if needed
+		void Close();
+
+		bool Has(const std::string& id) const;
+		bool Get(const std::string& id, std::string& json) const;
+		bool Put(const std::string& id, const std::string& json, bool* changed = nullptr); // unchanged responses aren't appended
+
+		std::vector<std::string> GetIDs() const;
+		size_t GetCount() const;
+		bool GetRecord(const std::string& id, ShaderRecord& record) const;
+		inline const std::string& GetDirectory() const { return m_dir; }
+
+	private:
+		std::string m_dir;
+		FILE* m_file;
+		unsigned long long m_size;
+		std::map<std::string, ShaderRecord> m_records;
+		mutable std::mutex m_mutex;
+	};
+}
@@ -1,4 +1,12 @@
 #include "Shadertoy.h"
+#include "RenderPass.h"
+#include "ShaderAnalyzer.h"
+#include "PassFusion.h"
+#include "ComputePass.h"
+#include "ImageIO.h"
+#include "MediaPack.h"
+#include "AudioSpectrum.h"
+#include "CubemapPass.h"
 #include "APIKey.h"
 #include <imgui/imgui.h>
 #include <imgui/imgui_internal.h>
@@ -8,44 +16,19 @@
 #include <json11/json11.hpp>
 #include <pugixml/src/pugixml.hpp>
 #include <ghc/filesystem.hpp>
+#include <GL/glew.h>
+#include <sstream>
 
 #define BUTTON_SPACE_LEFT -40 * GetDPI()
 #define KEYBOARD_TEXTURE_NAME "KeyboardTexture"
+#define SCALED_IMAGE_NAME "ImageScaled"
+#define BROWSER_THUMBNAIL_WIDTH 144
+#define BROWSER_THUMBNAIL_HEIGHT 81
+#define UPSCALE_PASS_NAME "Upscale"
 
 namespace st
 {
-	struct ShaderOutput
-	{
-		int ID;
-		int Channel;
-	};
-	struct ShaderInputSampler
-	{
-		std::string Filter;
-		std::string Wrap;
-		bool FlipVertical;
-		bool SRGB;
-	};
-	struct ShaderInput
-	{
-		int ID;
-		int Channel;
-		std::string Type;
-		std::string Source;
-
-		ShaderInputSampler Sampler;
-	};
-	struct RenderPass
-	{
-		std::vector<ShaderOutput> Outputs;
-		std::vector<ShaderInput> Inputs;
-
-		std::string Name;
-		std::string Type;
-		std::string Code;
-	};
-
-	std::string GenerateReadMe(const json11::Json& info)
+	std::string GenerateReadMe(const json11::Json& info, const std::string& costReport)
 	{
 		std::string ret = "";
 
@@ -53,6 +36,8 @@ namespace st
 		ret += "Shader made by: " + info["username"].string_value() + "\n";
 		ret += "Link: www.shadertoy.com/view/" + info["id"].string_value() + "\n";
 
+		ret += "\nEstimated cost (static analysis):\n" + costReport;
+
 		return ret;
 	}
 
@@ -127,7 +112,211 @@ namespace st
 			"</items>";
 		return ret;
 	}
-	std::string GenerateVariables()
+	std::vector<bool> FindStaticBuffers(const std::vector<RenderPass>& data, const ImportOptions& opts)
+	{
+		std::vector<bool> ret(data.size(), false);
+		if (!opts.RenderStaticOnce)
+			return ret;
+
+		std::vector<PassDependencies> deps = AnalyzeDependencies(data);
+		for (int i = 0; i < data.size(); i++)
+			ret[i] = data[i].Type == "buffer" && deps[i].IsStatic();
+
+		return ret;
+	}
+	std::vector<bool> FindComputePasses(const std::vector<RenderPass>& data, const ImportOptions& opts)
+	{
+		std::vector<bool> ret(data.size(), false);
+		if (!opts.UseComputePasses)
+			return ret;
+
+		for (int i = 0; i < data.size(); i++)
+			ret[i] = IsComputeCompatible(data, i);
+
+		return ret;
+	}
+	std::vector<BufferFormat> FindBufferFormats(const std::vector<RenderPass>& data, const std::vector<bool>& isCompute, const ImportOptions& opts)
+	{
+		std::vector<BufferFormat> ret(data.size());
+		for (int i = 0; i < data.size(); i++) {
+			if (data[i].Type != "buffer")
+				continue;
+
+			if (opts.InferFormats)
+				ret[i] = InferBufferFormat(data, i);
+			else if (isCompute[i])
+				ret[i] = GetBufferFormat("RGBA32F");
+			else {
+				ret[i] = GetBufferFormat("RGBA8");
+				ret[i].Reason = "host default";
+			}
+		}
+		return ret;
+	}
+	int GetFilterPriority(const std::string& filter)
+	{
+		if (filter == "mipmap") return 2;
+		if (filter == "linear") return 1;
+		return 0;
+	}
+	bool ReadsItself(const std::vector<RenderPass>& data, const RenderPass& pass)
+	{
+		for (const auto& inp : pass.Inputs)
+			if (FindCubemapBuffer(data, inp) == pass.Name)
+				return true;
+		return false;
+	}
+	ShaderInputSampler FindBufferSampler(const std::vector<RenderPass>& data, int id, const std::string& type = "buffer")
+	{
+		// the sampler state belongs to the object - if the readers disagree, the one that needs the most wins
+		ShaderInputSampler ret = { "linear", "clamp", false, false };
+		bool found = false;
+		for (const auto& pass : data)
+			for (const auto& inp : pass.Inputs)
+				if (inp.Type == type && inp.ID == id && (!found || GetFilterPriority(inp.Sampler.Filter) > GetFilterPriority(ret.Filter))) {
+					ret = inp.Sampler;
+					found = true;
+				}
+		return ret;
+	}
+	void ApplySampler(pugi::xml_node& node, const ShaderInputSampler& samplerInfo)
+	{
+		// filter - mipmaps are only needed (and generated) for the mipmap filter
+		if (samplerInfo.Filter == "linear") {
+			node.append_attribute("min_filter").set_value("Linear");
+			node.append_attribute("mag_filter").set_value("Linear");
+		} else if (samplerInfo.Filter == "nearest") {
+			node.append_attribute("min_filter").set_value("Nearest");
+			node.append_attribute("mag_filter").set_value("Nearest");
+		} else if (samplerInfo.Filter == "mipmap") {
+			node.append_attribute("min_filter").set_value("Linear_MipmapLinear");
+			node.append_attribute("mag_filter").set_value("Linear");
+		}
+
+		// wrap
+		if (samplerInfo.Wrap == "clamp") {
+			node.append_attribute("wrap_s").set_value("ClampToEdge");
+			node.append_attribute("wrap_t").set_value("ClampToEdge");
+		} else if (samplerInfo.Wrap == "repeat") {
+			node.append_attribute("wrap_s").set_value("Repeat");
+			node.append_attribute("wrap_t").set_value("Repeat");
+		}
+	}
+	int GetMaxTextureSize(const ShaderInput& inp, const ImportOptions& opts)
+	{
+		auto it = opts.TextureSizes.find(inp.Source);
+		if (it != opts.TextureSizes.end() && it->second >= 0)
+			return it->second;
+		return opts.MaxTextureSize;
+	}
+	std::string GetTexturePath(const ShaderInput& inp, const ImportOptions& opts)
+	{
+		if (opts.RawTextures.count(inp.Source) > 0)
+			return inp.Source;
+
+		// downscaled, flipped, linearized and/or mipmapped copies are stored next to the original file
+		int maxSize = GetMaxTextureSize(inp, opts);
+		bool flip = opts.ProcessTextures && inp.Sampler.FlipVertical;
+		bool linear = opts.ProcessTextures && inp.Sampler.SRGB;
+		bool dds = opts.PrecomputeMipmaps || opts.TextureCompression != CompressionQuality::None;
+		if (maxSize <= 0 && !flip && !linear && !dds)
+			return inp.Source;
+
+		std::string path = inp.Source.substr(0, inp.Source.find_last_of('.'));
+		if (maxSize > 0)
+			path += "_" + std::to_string(maxSize);
+		if (flip)
+			path += "_flip";
+		if (linear)
+			path += "_linear";
+		return path + (dds ? ".dds" : ".png");
+	}
+	std::string GetVolumePath(const ShaderInput& inp)
+	{
+		// .bin -> DDS volume texture
+		return inp.Source.substr(0, inp.Source.find_last_of('.')) + ".dds";
+	}
+	std::vector<std::string> GetCubemapFaces(const std::string& source)
+	{
+		// the source is the +X face, the others have a _1 ... _5 suffix (-X, +Y, -Y, +Z, -Z)
+		size_t dot = source.find_last_of('.');
+		std::vector<std::string> ret(1, source);
+		for (int i = 1; i < 6; i++)
+			ret.push_back(source.substr(0, dot) + "_" + std::to_string(i) + source.substr(dot));
+		return ret;
+	}
+	std::string GetCubemapName(const ShaderInput& inp)
+	{
+		std::string file = inp.Source.substr(inp.Source.find_last_of('/') + 1);
+		return "Cubemap_" + file.substr(0, file.find_last_of('.'));
+	}
+	std::string GetCubemapPath(const ShaderInput& inp, int face, const ImportOptions& opts)
+	{
+		// SHADERed only loads cubemaps from six face images, so the faces are never saved as DDS
+		ImportOptions faceOpts = opts;
+		faceOpts.PrecomputeMipmaps = false;
+		faceOpts.TextureCompression = CompressionQuality::None;
+
+		ShaderInput faceInp = inp;
+		faceInp.Source = GetCubemapFaces(inp.Source)[face];
+
+		// the size limit is set for the whole cubemap
+		faceOpts.TextureSizes[faceInp.Source] = GetMaxTextureSize(inp, opts);
+		return GetTexturePath(faceInp, faceOpts);
+	}
+	std::string GetCubemapDDSPath(const ShaderInput& inp, const ImportOptions& opts)
+	{
+		// all faces packed into one DDS file (an extra output next to the faces), cubemaps aren't block compressed
+		ImportOptions cubeOpts = opts;
+		cubeOpts.TextureCompression = CompressionQuality::None;
+
+		ShaderInput cubeInp = inp;
+		size_t dot = inp.Source.find_last_of('.');
+		cubeInp.Source = inp.Source.substr(0, dot) + "_cube" + inp.Source.substr(dot);
+
+		cubeOpts.TextureSizes[cubeInp.Source] = GetMaxTextureSize(inp, opts);
+		return GetTexturePath(cubeInp, cubeOpts);
+	}
+	std::string GetMusicPath(const ShaderInput& inp)
+	{
+		// audio file -> precomputed spectrogram
+		return inp.Source.substr(0, inp.Source.find_last_of('.')) + SPECTRUM_EXTENSION;
+	}
+	std::string GetMusicName(const ShaderInput& inp)
+	{
+		std::string file = inp.Source.substr(inp.Source.find_last_of('/') + 1);
+		return "Music_" + file.substr(0, file.find_last_of('.'));
+	}
+	std::string GenerateCubemapPassArgs(const std::vector<RenderPass>& data, const RenderPass& pass, const ImportOptions& opts)
+	{
+		// the pass binds its channels itself, by object name
+		std::string ret = "shaders/" + pass.Name + ".glsl\n";
+		for (const auto& inp : pass.Inputs) {
+			std::string type = "2d", name = "";
+			if (inp.Type == "buffer") {
+				for (const auto& other : data)
+					if (other.Type == "buffer" && !other.Outputs.empty() && other.Outputs[0].ID == inp.ID)
+						name = other.Name;
+			} else if (inp.Type == "texture")
+				name = "." + GetTexturePath(inp, opts);
+			else if (inp.Type == "keyboard")
+				name = KEYBOARD_TEXTURE_NAME;
+			else if (inp.Type == "cubemap") {
+				type = "cube";
+				name = FindCubemapBuffer(data, inp);
+				if (name.empty())
+					name = GetCubemapName(inp);
+			} else if (inp.Type == "volume") {
+				type = "3d";
+				name = "." + GetVolumePath(inp);
+			}
+
+			if (!name.empty())
+				ret += std::to_string(inp.Channel) + " " + type + " " + name + "\n";
+		}
+		return ret;
+	}
+	std::string GenerateVariables(bool windowMouse = false, bool renderOnce = false)
 	{
 		std::string ret =
 			"<variables>"
@@ -135,7 +324,9 @@ namespace st
 			"<variable type=\"float\" name=\"iTime\" system=\"Time\" />"
 			"<variable type=\"float\" name=\"iTimeDelta\" system=\"TimeDelta\" />"
 			"<variable type=\"int\" name=\"iFrame\" system=\"FrameIndex\" />"
-			"<variable type=\"float4\" name=\"iMouse\" system=\"MouseButton\" />"
+			"<variable type=\"float4\" name=\"iMouse\" system=\"MouseButton\" />" +
+			std::string(windowMouse ? "<variable type=\"float4\" name=\"iMouseWindow\" system=\"MouseButton\" />" : "") +
+			std::string(renderOnce ? "<variable type=\"float2\" name=\"iResolutionLast\" system=\"ViewportSize\" lastframe=\"true\" />" : "") +
 			"</variables>";
 		return ret;
 	}
@@ -169,26 +360,94 @@ void main() {
 )";
 		return std::string(vs);
 	}
-	std::string GenerateGLSL(const std::string& code, bool usesCommon = false)
+	std::string GenerateUpscaleShader(bool sharpen)
 	{
-		std::string ret = "#version 330\n\n" +
-			std::string(usesCommon ? "#include <common.glsl>\n" : "") +
+		std::string ret = R"(#version 330
+
+uniform vec2 iResolution;
+uniform sampler2D scaledImage;
+
+out vec4 outColor;
+
+void main()
+{
+	vec2 uv = gl_FragCoord.xy / iResolution;
+)";
+		if (sharpen) {
+			// sharpen with the neighbouring texels of the low resolution image & clamp to their range to avoid ringing
+			ret += R"(	vec2 texel = 1.0 / vec2(textureSize(scaledImage, 0));
+	vec4 c = texture(scaledImage, uv);
+	vec4 n = texture(scaledImage, uv + vec2(0.0, texel.y));
+	vec4 s = texture(scaledImage, uv - vec2(0.0, texel.y));
+	vec4 e = texture(scaledImage, uv + vec2(texel.x, 0.0));
+	vec4 w = texture(scaledImage, uv - vec2(texel.x, 0.0));
+
+	vec4 minColor = min(c, min(min(n, s), min(e, w)));
+	vec4 maxColor = max(c, max(max(n, s), max(e, w)));
+
+	outColor = clamp(c + (4.0 * c - n - s - e - w) * 0.25, minColor, maxColor);
+}
+)";
+		} else
+			ret += "\toutColor = texture(scaledImage, uv);\n}\n";
+
+		return ret;
+	}
+	std::string GenerateScaledMouse(float scale)
+	{
+		// iMouse is in window pixels while the pass is rendered at a lower resolution
+		return "uniform vec4 iMouseWindow;\n"
+			"#define iMouse (iMouseWindow * " + std::to_string(scale) + ")\n";
+	}
+	std::string InlineCommonCode(const std::string& common, int firstLine)
+	{
+		// common code is reported as source string 1 while the pass code keeps its line numbers in the generated file
+		int commonLines = std::count(common.begin(), common.end(), '\n') + 1;
+		return "#line 1 1\n" + common + "\n#line " + std::to_string(firstLine + commonLines + 2) + " 0\n";
+	}
+	std::string GenerateGLSL(const RenderPass& pass, const std::string& code, bool usesCommon = false, bool inlineCommon = false, const std::string& commonCode = "", bool renderOnce = false)
+	{
+		std::string common = "";
+		if (usesCommon)
+			common = inlineCommon ? InlineCommonCode(commonCode, 3) : "#include <common.glsl>\n";
+
+		// keep the render texture's content (it isn't cleared) after the first frame until the window is resized
+		std::string renderOnceUniform = "", renderOnceCheck = "";
+		if (renderOnce) {
+			renderOnceUniform = "uniform vec2 iResolutionLast;\n";
+			renderOnceCheck = "\tif (iFrame > 0 && iResolution == iResolutionLast)\n\t\tdiscard;\n";
+		}
+
+		std::string channels = "";
+		for (int i = 0; i < 4; i++)
+			channels += "uniform " + std::string(GetChannelSamplerType(pass, i)) + " iChannel" + std::to_string(i) + ";\n";
+
+		std::string ret = "#version 330\n\n" + common +
 			"uniform vec2 iResolution;\n"
 			"uniform float iTime;\n"
 			"uniform float iTimeDelta;\n"
 			"uniform int iFrame;\n"
-			"uniform vec4 iMouse;\n"
-			"uniform sampler2D iChannel0;\n"
-			"uniform sampler2D iChannel1;\n"
-			"uniform sampler2D iChannel2;\n"
-			"uniform sampler2D iChannel3;\n"
+			"uniform vec4 iMouse;\n" + channels + renderOnceUniform +
 			"out vec4 shadertoy_outcolor;\n\n" + code + "\n"
-			"void main()\n{\n"
+			"void main()\n{\n" + renderOnceCheck +
 			"\tmainImage(shadertoy_outcolor, gl_FragCoord.xy);\n"
 			"}";
 		return ret;
 	}
-	pugi::xml_document GenerateProject(const std::vector<RenderPass>& data)
+	std::string GenerateCustomLanguageCode(const RenderPass& pass, const std::string& code, bool usesCommon = false, bool renderOnce = false)
+	{
+		// the prelude & main() are injected by ShaderCompiler, which also declares the marked channel types
+		std::string channels = "";
+		for (int i = 0; i < 4; i++) {
+			std::string type = GetChannelSamplerType(pass, i);
+			if (type != "sampler2D")
+				channels += "#define SHADERTOY_CHANNEL" + std::to_string(i) + "_TYPE " + type + "\n";
+		}
+
+		return channels + std::string(renderOnce ? "#define SHADERTOY_RENDER_ONCE\n" : "") +
+			std::string(usesCommon ? "#include <common.glsl>\n" : "") + code;
+	}
+	pugi::xml_document GenerateProject(const std::vector<RenderPass>& data, const ImportOptions& opts)
 	{
 		pugi::xml_document doc;
 		pugi::xml_node project = doc.append_child("project");
@@ -198,21 +457,32 @@ void main() {
 		pugi::xml_node objectsNode = project.append_child("objects");
 		pugi::xml_node settingsNode = project.append_child("settings");
 
+		std::vector<bool> isStatic = FindStaticBuffers(data, opts);
+		std::vector<bool> isCompute = FindComputePasses(data, opts);
+		std::vector<BufferFormat> formats = FindBufferFormats(data, isCompute, opts);
+
 		/////// BUILD RESOURCE LIST ///////
 		int index = 0;
 		std::vector<std::string> rts;
 		std::vector<int> rtIds;
+		std::vector<bool> rtStatic, rtCompute;
+		std::vector<std::string> rtFormats;
 		std::map<int, std::vector<std::pair<std::string, int>>> rtBind;
 		std::vector<std::string> textures, textureTypes;
 		std::map<std::string, std::vector<std::pair<std::string, int>>> texBinds;
+		std::vector<ShaderInput> cubemaps, volumes, music;
+		std::map<std::string, std::vector<std::pair<std::string, int>>> cubeBinds;
 		for (const auto& rpass : data) {
 			if (rpass.Type == "buffer") {
 				rts.push_back(rpass.Name);
 				rtIds.push_back(rpass.Outputs[0].ID);
+				rtStatic.push_back(isStatic[index]);
+				rtCompute.push_back(isCompute[index]);
+				rtFormats.push_back(formats[index].HostName);
 			}
 			for (const auto& inp : rpass.Inputs) {
 				if (inp.Type == "texture" || inp.Type == "keyboard") {
-					std::string name = inp.Source;
+					std::string name = GetTexturePath(inp, opts);
 					if (inp.Type == "keyboard")
 						name = KEYBOARD_TEXTURE_NAME;
 
@@ -221,6 +491,29 @@ void main() {
 
 					texBinds[name].push_back(std::make_pair(rpass.Name, inp.Channel));
 				}
+				else if (inp.Type == "cubemap" && !FindCubemapBuffer(data, inp).empty())
+					cubeBinds[FindCubemapBuffer(data, inp)].push_back(std::make_pair(rpass.Name, inp.Channel));
+				else if (inp.Type == "cubemap") {
+					std::string name = GetCubemapName(inp);
+					if (texBinds.count(name) == 0)
+						cubemaps.push_back(inp);
+
+					texBinds[name].push_back(std::make_pair(rpass.Name, inp.Channel));
+				}
+				else if (inp.Type == "volume") {
+					std::string name = GetVolumePath(inp);
+					if (texBinds.count(name) == 0)
+						volumes.push_back(inp);
+
+					texBinds[name].push_back(std::make_pair(rpass.Name, inp.Channel));
+				}
+				else if (inp.Type == "music") {
+					std::string name = GetMusicName(inp);
+					if (texBinds.count(name) == 0)
+						music.push_back(inp);
+
+					texBinds[name].push_back(std::make_pair(rpass.Name, inp.Channel));
+				}
 				else if (inp.Type == "buffer")
 					rtBind[inp.ID].push_back(std::make_pair(rpass.Name, inp.Channel));
 			}
@@ -228,15 +521,103 @@ void main() {
 			index++;
 		}
 
+		// cube passes look their channels up by name, nothing can be bound to them
+		for (const auto& rpass : data) {
+			if (rpass.Type != "cubemap")
+				continue;
+
+			auto isCubePass = [&rpass](const std::pair<std::string, int>& bind) { return bind.first == rpass.Name; };
+			for (auto& binds : rtBind)
+				binds.second.erase(std::remove_if(binds.second.begin(), binds.second.end(), isCubePass), binds.second.end());
+			for (auto& binds : texBinds)
+				binds.second.erase(std::remove_if(binds.second.begin(), binds.second.end(), isCubePass), binds.second.end());
+			for (auto& binds : cubeBinds)
+				binds.second.erase(std::remove_if(binds.second.begin(), binds.second.end(), isCubePass), binds.second.end());
+		}
+
 		/////// PIPELINE ///////
 		for (int i = data.size() - 1; i >= 0; i--) {
 			const RenderPass& pass = data[i];
 
-			if (pass.Type == "common")
+			// the sound pass is rendered to a WAV file during the import
+			if (pass.Type == "common" || pass.Type == "sound")
 				continue;
 
+			// all six faces are rendered by the plugin with one layered draw
+			if (pass.Type == "cubemap") {
+				pugi::xml_node node = pipelineNode.append_child("pass");
+				node.append_attribute("name").set_value(pass.Name.c_str());
+				node.append_attribute("type").set_value("plugin");
+				node.append_attribute("plugin").set_value("Shadertoy");
+				node.append_attribute("ptype").set_value(SHADERTOY_CUBEMAP_PASS);
+				node.append_child("data").text().set(GenerateCubemapPassArgs(data, pass, opts).c_str());
+				continue;
+			}
+
 			pugi::xml_node node = pipelineNode.append_child("pass");
 			node.append_attribute("name").set_value(pass.Name.c_str());
+			node.append_attribute("type").set_value(isCompute[i] ? "compute" : "shader");
+			node.append_attribute("active").set_value("true");
+
+			bool isScaled = pass.Type == "image" && opts.ImageScale < 1.0f;
+
+			if (isCompute[i]) {
+				// one invocation per pixel of the image, the shader returns early outside of it
+				pugi::xml_node csNode = node.append_child("shader");
+				csNode.append_attribute("type").set_value("cs");
+				csNode.append_attribute("path").set_value(("shaders/" + pass.Name + ".glsl").c_str());
+				csNode.append_attribute("entry").set_value("main");
+
+				pugi::xml_node groupNode = node.append_child("groupsize");
+				groupNode.append_attribute("x").set_value((COMPUTE_IMAGE_WIDTH + COMPUTE_TILE_SIZE - 1) / COMPUTE_TILE_SIZE);
+				groupNode.append_attribute("y").set_value((COMPUTE_IMAGE_HEIGHT + COMPUTE_TILE_SIZE - 1) / COMPUTE_TILE_SIZE);
+				groupNode.append_attribute("z").set_value(1);
+
+				std::string varNode = GenerateVariables();
+				node.append_buffer(varNode.c_str(), varNode.size());
+			} else {
+				pugi::xml_node vsNode = node.append_child("shader");
+				vsNode.append_attribute("type").set_value("vs");
+				vsNode.append_attribute("path").set_value("shaders/shadertoyVS.glsl");
+
+				pugi::xml_node psNode = node.append_child("shader");
+				psNode.append_attribute("type").set_value("ps");
+				psNode.append_attribute("path").set_value(("shaders/" + pass.Name + (opts.UseCustomLanguage ? "." SHADERTOY_LANGUAGE_EXT : ".glsl")).c_str());
+
+				if (pass.Type == "buffer")
+					node.append_child("rendertexture").append_attribute("name").set_value(pass.Name.c_str());
+				else if (isScaled)
+					node.append_child("rendertexture").append_attribute("name").set_value(SCALED_IMAGE_NAME);
+				else
+					node.append_child("rendertexture");
+
+				std::string itemsNode = GenerateItems(data.size() - i);
+				node.append_buffer(itemsNode.c_str(), itemsNode.size());
+
+				std::string varNode = GenerateVariables(isScaled, isStatic[i]);
+				node.append_buffer(varNode.c_str(), varNode.size());
+			}
+
+			// quality knobs -> overridable macros, only the modified ones are active
+			pugi::xml_node macrosNode;
+			for (const auto& knob : opts.Knobs) {
+				if (!knob.InCommon && std::count(knob.Passes.begin(), knob.Passes.end(), pass.Name) == 0)
+					continue;
+
+				if (!macrosNode)
+					macrosNode = node.append_child("macros");
+
+				pugi::xml_node defNode = macrosNode.append_child("define");
+				defNode.append_attribute("name").set_value(knob.Name.c_str());
+				defNode.append_attribute("active").set_value(knob.Default != knob.Value);
+				defNode.text().set(knob.Value);
+			}
+		}
+
+		// the Image pass is rendered to a smaller render texture which is then upscaled to the screen
+		if (opts.ImageScale < 1.0f) {
+			pugi::xml_node node = pipelineNode.append_child("pass");
+			node.append_attribute("name").set_value(UPSCALE_PASS_NAME);
 			node.append_attribute("type").set_value("shader");
 			node.append_attribute("active").set_value("true");
 
@@ -246,28 +627,72 @@ void main() {
 
 			pugi::xml_node psNode = node.append_child("shader");
 			psNode.append_attribute("type").set_value("ps");
-			psNode.append_attribute("path").set_value(("shaders/" + pass.Name + ".glsl").c_str());
+			psNode.append_attribute("path").set_value("shaders/" UPSCALE_PASS_NAME ".glsl");
 
-			if (pass.Type == "buffer")
-				node.append_child("rendertexture").append_attribute("name").set_value(pass.Name.c_str());
-			else
-				node.append_child("rendertexture");
+			node.append_child("rendertexture");
 
-			std::string itemsNode = GenerateItems(data.size() - i);
+			std::string itemsNode = GenerateItems(data.size() + 1);
 			node.append_buffer(itemsNode.c_str(), itemsNode.size());
 
-			std::string varNode = GenerateVariables();
+			std::string varNode =
+				"<variables>"
+				"<variable type=\"float2\" name=\"iResolution\" system=\"ViewportSize\" />"
+				"</variables>";
 			node.append_buffer(varNode.c_str(), varNode.size());
+
+			char rsize[32];
+			snprintf(rsize, sizeof(rsize), "%.2f,%.2f", opts.ImageScale, opts.ImageScale);
+
+			pugi::xml_node rtNode = objectsNode.append_child("object");
+			rtNode.append_attribute("type").set_value("rendertexture");
+			rtNode.append_attribute("name").set_value(SCALED_IMAGE_NAME);
+			rtNode.append_attribute("rsize").set_value(rsize);
+			rtNode.append_attribute("clear").set_value("true");
+			rtNode.append_attribute("r").set_value("0");
+			rtNode.append_attribute("g").set_value("0");
+			rtNode.append_attribute("b").set_value("0");
+			rtNode.append_attribute("a").set_value("1");
+			ApplySampler(rtNode, { "linear", "clamp", false, false });
+
+			pugi::xml_node bindNode = rtNode.append_child("bind");
+			bindNode.append_attribute("slot").set_value(0);
+			bindNode.append_attribute("name").set_value(UPSCALE_PASS_NAME);
 		}
 
 
 		/////// OBJECTS ///////
 		for (int i = 0; i < rts.size(); i++) {
 			pugi::xml_node node = objectsNode.append_child("object");
+
+			// compute passes write to a fixed size image which the other passes sample
+			if (rtCompute[i]) {
+				node.append_attribute("type").set_value("image");
+				node.append_attribute("name").set_value(rts[i].c_str());
+				node.append_attribute("width").set_value(COMPUTE_IMAGE_WIDTH);
+				node.append_attribute("height").set_value(COMPUTE_IMAGE_HEIGHT);
+				node.append_attribute("format").set_value(rtFormats[i].c_str());
+
+				pugi::xml_node outNode = node.append_child("bind");
+				outNode.append_attribute("slot").set_value(0);
+				outNode.append_attribute("name").set_value(rts[i].c_str());
+				outNode.append_attribute("uav").set_value(1);
+
+				for (const auto& pair : rtBind[rtIds[i]]) {
+					pugi::xml_node bindNode = node.append_child("bind");
+					bindNode.append_attribute("slot").set_value(pair.second);
+					bindNode.append_attribute("name").set_value(pair.first.c_str());
+					bindNode.append_attribute("uav").set_value(0);
+				}
+				continue;
+			}
+
 			node.append_attribute("type").set_value("rendertexture");
 			node.append_attribute("name").set_value(rts[i].c_str());
 			node.append_attribute("rsize").set_value("1.00,1.00");
-			node.append_attribute("clear").set_value("true");
+			node.append_attribute("clear").set_value(rtStatic[i] ? "false" : "true");
+			if (opts.InferFormats)
+				node.append_attribute("format").set_value(rtFormats[i].c_str());
+			ApplySampler(node, FindBufferSampler(data, rtIds[i]));
 			node.append_attribute("r").set_value("0");
 			node.append_attribute("g").set_value("0");
 			node.append_attribute("b").set_value("0");
@@ -294,34 +719,15 @@ void main() {
 				ShaderInputSampler samplerInfo;
 				for (int j = 0; j < data.size(); j++)
 					for (int k = 0; k < data[j].Inputs.size(); k++) {
-						if (data[j].Inputs[k].Source == textures[i])
+						if (data[j].Inputs[k].Type == "texture" && GetTexturePath(data[j].Inputs[k], opts) == textures[i])
 							samplerInfo = data[j].Inputs[k].Sampler;
 					}
 
-				// vertical flip
-				node.append_attribute("vflip").set_value(samplerInfo.FlipVertical);
-
-				// filter
-				if (samplerInfo.Filter == "linear") {
-					node.append_attribute("min_filter").set_value("Nearest");
-					node.append_attribute("mag_filter").set_value("Nearest");
-				} else if (samplerInfo.Filter == "nearest") {
-					node.append_attribute("min_filter").set_value("Linear");
-					node.append_attribute("mag_filter").set_value("Linear");
-				} else if (samplerInfo.Filter == "mipmap") {
-					/* TODO: not sure what this is supposed to be */
-					node.append_attribute("min_filter").set_value("Linear_MipmapLinear");
-					node.append_attribute("mag_filter").set_value("Linear");
-				}
+				// vertical flip - already applied to the file when the textures are processed
+				if (!opts.ProcessTextures || opts.RawTextures.count(textures[i]) > 0)
+					node.append_attribute("vflip").set_value(samplerInfo.FlipVertical);
 
-				// wrap
-				if (samplerInfo.Wrap == "clamp") {
-					node.append_attribute("wrap_s").set_value("ClampToEdge");
-					node.append_attribute("wrap_t").set_value("ClampToEdge");
-				} else if (samplerInfo.Wrap == "repeat") {
-					node.append_attribute("wrap_s").set_value("Repeat");
-					node.append_attribute("wrap_t").set_value("Repeat");
-				}
+				ApplySampler(node, samplerInfo);
 			}
 
 			const std::vector<std::pair<std::string, int>>& myBind = texBinds[textures[i]];
@@ -333,6 +739,90 @@ void main() {
 			}
 		}
 
+		for (const auto& cubemap : cubemaps) {
+			std::string name = GetCubemapName(cubemap);
+
+			pugi::xml_node node = objectsNode.append_child("object");
+			node.append_attribute("type").set_value("texture");
+			node.append_attribute("name").set_value(name.c_str());
+			node.append_attribute("cube").set_value(true);
+
+			const char* faceNames[] = { "right", "left", "top", "bottom", "front", "back" };
+			for (int i = 0; i < 6; i++)
+				node.append_attribute(faceNames[i]).set_value(("." + GetCubemapPath(cubemap, i, opts)).c_str());
+			ApplySampler(node, cubemap.Sampler);
+
+			for (const auto& pair : texBinds[name]) {
+				pugi::xml_node bindNode = node.append_child("bind");
+				bindNode.append_attribute("slot").set_value(pair.second);
+				bindNode.append_attribute("name").set_value(pair.first.c_str());
+			}
+		}
+
+		for (const auto& volume : volumes) {
+			std::string path = GetVolumePath(volume);
+
+			pugi::xml_node node = objectsNode.append_child("object");
+			node.append_attribute("type").set_value("texture3d");
+			node.append_attribute("path").set_value(("." + path).c_str());
+			ApplySampler(node, volume.Sampler);
+
+			for (const auto& pair : texBinds[path]) {
+				pugi::xml_node bindNode = node.append_child("bind");
+				bindNode.append_attribute("slot").set_value(pair.second);
+				bindNode.append_attribute("name").set_value(pair.first.c_str());
+			}
+		}
+
+		// cube buffers - the pass & the object share the name
+		for (const auto& pass : data) {
+			if (pass.Type != "cubemap" || pass.Outputs.empty())
+				continue;
+
+			std::string args = std::to_string(opts.CubemapSize) + " " + FindBufferSampler(data, pass.Outputs[0].ID, "cubemap").Filter + " " + (ReadsItself(data, pass) ? "1" : "0");
+
+			pugi::xml_node node = objectsNode.append_child("object");
+			node.append_attribute("type").set_value("plugin");
+			node.append_attribute("plugin").set_value("Shadertoy");
+			node.append_attribute("name").set_value(pass.Name.c_str());
+			node.append_attribute("ptype").set_value(SHADERTOY_CUBEMAP_OBJECT);
+			node.append_child("data").text().set(args.c_str());
+
+			for (const auto& pair : cubeBinds[pass.Name]) {
+				pugi::xml_node bindNode = node.append_child("bind");
+				bindNode.append_attribute("slot").set_value(pair.second);
+				bindNode.append_attribute("name").set_value(pair.first.c_str());
+			}
+		}
+
+		// the prerendered sound is played by an audio object
+		for (const auto& pass : data) {
+			if (pass.Type != "sound")
+				continue;
+
+			pugi::xml_node node = objectsNode.append_child("object");
+			node.append_attribute("type").set_value("audio");
+			node.append_attribute("path").set_value(("./" + pass.Name + ".wav").c_str());
+		}
+
+		// music channels are plugin objects that serve the spectrogram frame of the current time
+		for (const auto& track : music) {
+			std::string name = GetMusicName(track);
+
+			pugi::xml_node node = objectsNode.append_child("object");
+			node.append_attribute("type").set_value("plugin");
+			node.append_attribute("plugin").set_value("Shadertoy");
+			node.append_attribute("name").set_value(name.c_str());
+			node.append_attribute("ptype").set_value(SHADERTOY_MUSIC_OBJECT);
+			node.append_child("data").text().set(("." + GetMusicPath(track)).c_str());
+
+			for (const auto& pair : texBinds[name]) {
+				pugi::xml_node bindNode = node.append_child("bind");
+				bindNode.append_attribute("slot").set_value(pair.second);
+				bindNode.append_attribute("name").set_value(pair.first.c_str());
+			}
+		}
+
 		/////// SETTINGS ///////
 		std::string settings = GenerateSettings();
 		settingsNode.append_buffer(settings.c_str(), settings.size());
@@ -347,122 +837,606 @@ void main() {
 		file << filedata;
 		file.close();
 	}
-	bool Generate(const std::string& shadertoyID, const std::string& outPath)
+	bool ParseShadertoyID(const std::string& link, std::string& id)
+	{
+		if (link.find("www.shadertoy.com/view/") == std::string::npos)
+			return false;
+
+		size_t lastSlash = link.find_last_of('/');
+		id = link.substr(lastSlash + 1);
+
+		return id.size() != 0;
+	}
+	bool FetchShader(const std::string& shadertoyID, json11::Json& jdata)
 	{
 		// https://www.shadertoy.com/api/v1/shaders/shaderID?key=appkey
 		httplib::SSLClient cli("www.shadertoy.com");
 
 		auto res = cli.Get(("/api/v1/shaders/" + shadertoyID + "?key=" SHADERTOY_APIKEY).c_str());
 
-		std::vector<RenderPass> pipeline;
-
 		if (res && res->status == 200) {
 			std::string err;
-			json11::Json jdata = json11::Json::parse(res->body, err);
+			jdata = json11::Json::parse(res->body, err);
 
-			if (jdata["Error"].is_string()) {
+			if (jdata["Error"].is_string())
 				return false;
+
+			return err.size() == 0 && jdata.is_object();
+		}
+
+		return false;
+	}
+	std::vector<std::string> ListAssetSources(const json11::Json& jdata)
+	{
+		// the files that Generate downloads in one piece - volumes are streamed to disk instead
+		std::vector<RenderPass> pipeline = ParseRenderPasses(jdata["Shader"]["renderpass"]);
+		std::vector<std::string> ret;
+		for (const auto& pass : pipeline)
+			for (const auto& inp : pass.Inputs) {
+				if (inp.Type == "texture" || inp.Type == "music")
+					ret.push_back(inp.Source);
+				else if (inp.Type == "cubemap" && FindCubemapBuffer(pipeline, inp).empty()) {
+					std::vector<std::string> faces = GetCubemapFaces(inp.Source);
+					ret.insert(ret.end(), faces.begin(), faces.end());
+				}
+			}
+		return ret;
+	}
+	void DownloadFiles(const std::vector<std::string>& sources, const MediaPack* media, const std::map<std::string, std::string>* prefetched, std::vector<std::string>& data, int& packedCount, int& downloadedCount)
+	{
+		// every file that isn't in the media pack or prefetched gets its own connection
+		data.resize(sources.size());
+		std::vector<std::thread> threads;
+		for (int i = 0; i < sources.size(); i++) {
+			if (media != nullptr && media->Get(sources[i], data[i])) {
+				packedCount++;
+				continue;
 			}
 
-			if (jdata.is_object()) {
-				pipeline = ParseRenderPasses(jdata["Shader"]["renderpass"]);
+			downloadedCount++;
+			if (prefetched != nullptr && prefetched->count(sources[i]) > 0) {
+				data[i] = prefetched->at(sources[i]);
+				continue;
 			}
 
-			if (!ghc::filesystem::exists(outPath))
-				ghc::filesystem::create_directories(outPath);
+			threads.push_back(std::thread([&sources, &data, i]() {
+				httplib::SSLClient cli("www.shadertoy.com");
+				auto res = cli.Get(sources[i].c_str());
+				data[i] = (res && res->status == 200) ? res->body : "";
+			}));
+		}
+		for (auto& thread : threads)
+			thread.join();
+	}
+	bool PrepareImage(const std::string& fileData, const ShaderInput& inp, const ImportOptions& opts, Image& img, std::string& resizeInfo)
+	{
+		if (!DecodeImage(fileData, img))
+			return false;
+
+		// keep the aspect ratio, sRGB color is filtered in linear space
+		int maxSize = GetMaxTextureSize(inp, opts);
+		if (maxSize > 0 && std::max(img.Width, img.Height) > maxSize) {
+			double scale = (double)maxSize / std::max(img.Width, img.Height);
+			Image resized;
+			ResizeImage(img, std::max(1, (int)(img.Width * scale + 0.5)), std::max(1, (int)(img.Height * scale + 0.5)), inp.Sampler.SRGB, resized);
+			resizeInfo = std::to_string(img.Width) + "x" + std::to_string(img.Height) + " -> " + std::to_string(resized.Width) + "x" + std::to_string(resized.Height);
+			img = std::move(resized);
+		}
 
-			std::string shadersDir = outPath + "/shaders";
-			if (!ghc::filesystem::exists(shadersDir))
-				ghc::filesystem::create_directories(shadersDir);
+		if (opts.ProcessTextures && inp.Sampler.FlipVertical)
+			FlipVertical(img);
+		if (opts.ProcessTextures && inp.Sampler.SRGB)
+			ConvertSRGBToLinear(img);
 
-			// README.txt
-			WriteFile(outPath + "/README.txt", GenerateReadMe(jdata["Shader"]["info"]));
+		return true;
+	}
+	bool Generate(const json11::Json& jdata, const std::string& outPath, const ImportOptions& inOpts, SoundJob& soundJob, std::string& summary)
+	{
+		httplib::SSLClient cli("www.shadertoy.com");
 
-			// project.sprj
-			pugi::xml_document doc = GenerateProject(pipeline);
-			std::ofstream sprjFile(outPath + "/project.sprj");
-			doc.print(sprjFile);
-			sprjFile.close();
+		std::vector<RenderPass> pipeline = ParseRenderPasses(jdata["Shader"]["renderpass"]);
+
+		// the quality knobs of a fused buffer now belong to the pass that contains its code
+		ImportOptions opts = inOpts;
+		std::vector<FusedPass> fused;
+		if (opts.FusePasses) {
+			pipeline = FusePointwisePasses(pipeline, opts.RenderStaticOnce, fused);
+			for (const auto& fusion : fused)
+				for (auto& knob : opts.Knobs)
+					if (std::count(knob.Passes.begin(), knob.Passes.end(), fusion.Producer) > 0)
+						knob.Passes.push_back(fusion.Consumer);
+		}
 
-			// shaders
-			bool usesCommon = false;
-			for (const auto& item : pipeline) {
-				if (item.Type == "common") {
-					usesCommon = true;
-					WriteFile(outPath + "/common.glsl", item.Code);
-					break;
-				}
+		std::vector<PassCost> costs = AnalyzePipelineCost(pipeline, opts.Knobs);
+		for (auto& cost : costs)
+			if (cost.Name == "Image")
+				cost.PixelScale = opts.ImageScale * opts.ImageScale;
+		summary = FormatCostReport(costs);
+
+		std::vector<bool> isStatic = FindStaticBuffers(pipeline, opts);
+		std::vector<bool> isCompute = FindComputePasses(pipeline, opts);
+		std::string staticList = "", computeList = "";
+		for (int i = 0; i < pipeline.size(); i++)
+			if (isCompute[i])
+				computeList += "  " + pipeline[i].Name + "\n";
+		if (!computeList.empty())
+			summary += "\nCompute passes (" + std::to_string(COMPUTE_IMAGE_WIDTH) + "x" + std::to_string(COMPUTE_IMAGE_HEIGHT) + " images, the output is clamped to 1080p "
+				"whatever the window size is):\n" + computeList;
+
+		for (int i = 0; i < pipeline.size(); i++)
+			if (isStatic[i])
+				staticList += "  " + pipeline[i].Name + "\n";
+		if (!staticList.empty())
+			summary += "\nRendered once (no time, input or feedback dependencies):\n" + staticList;
+
+		if (!fused.empty()) {
+			summary += "\nFused passes (read at the same pixel only):\n";
+			for (const auto& fusion : fused)
+				summary += "  " + fusion.Producer + " -> " + fusion.Consumer + "\n";
+		}
+
+		// render texture memory
+		std::vector<BufferFormat> formats = FindBufferFormats(pipeline, isCompute, opts);
+		std::vector<TextureMemory> memory;
+		for (int i = 0; i < pipeline.size(); i++) {
+			if (pipeline[i].Type != "buffer")
+				continue;
+			int width = isCompute[i] ? COMPUTE_IMAGE_WIDTH : 0;
+			int height = isCompute[i] ? COMPUTE_IMAGE_HEIGHT : 0;
+			bool mipmaps = !isCompute[i] && FindBufferSampler(pipeline, pipeline[i].Outputs[0].ID).Filter == "mipmap";
+			memory.push_back({ pipeline[i].Name, formats[i], 1.0, width, height, mipmaps });
+		}
+		if (opts.ImageScale < 1.0f)
+			memory.push_back({ SCALED_IMAGE_NAME, GetBufferFormat("RGBA8"), (double)opts.ImageScale * opts.ImageScale, 0, 0, false });
+		for (const auto& pass : pipeline) {
+			if (pass.Type != "cubemap" || pass.Outputs.empty())
+				continue;
+			// six faces, twice with feedback
+			bool mipmaps = FindBufferSampler(pipeline, pass.Outputs[0].ID, "cubemap").Filter == "mipmap";
+			int faces = ReadsItself(pipeline, pass) ? 12 : 6;
+			memory.push_back({ pass.Name + " (" + std::to_string(opts.CubemapSize) + " per face)", GetBufferFormat("RGBA16F"), 1.0, opts.CubemapSize, opts.CubemapSize * faces, mipmaps });
+		}
+		if (!memory.empty())
+			summary += "\nRender texture memory:\n" + FormatMemoryReport(memory);
+
+		if (!ghc::filesystem::exists(outPath))
+			ghc::filesystem::create_directories(outPath);
+
+		std::string shadersDir = outPath + "/shaders";
+		if (!ghc::filesystem::exists(shadersDir))
+			ghc::filesystem::create_directories(shadersDir);
+
+		// shaders
+		bool usesCommon = false;
+		std::string commonCode = "";
+		for (const auto& item : pipeline) {
+			if (item.Type == "common") {
+				usesCommon = true;
+				commonCode = GuardQualityKnobs(item.Code, opts.Knobs, 1); // keeps the original line numbers
+				break;
 			}
+		}
 
-			for (const auto& item : pipeline) {
-				if (item.Type == "common")
-					continue;
+		// ShaderCompiler always builds a single pre-expanded translation unit so the
+		// Shadertoy GLSL language keeps using common.glsl
+		bool inlineCommon = opts.InlineCommon && !opts.UseCustomLanguage;
+		if (usesCommon && !inlineCommon)
+			WriteFile(outPath + "/common.glsl", commonCode);
+
+		for (int i = 0; i < pipeline.size(); i++) {
+			const RenderPass& item = pipeline[i];
+			if (item.Type == "common" || item.Type == "sound")
+				continue;
+			std::string code = GuardQualityKnobs(item.Code, opts.Knobs);
+			if (item.Type == "image" && opts.ImageScale < 1.0f)
+				code = GenerateScaledMouse(opts.ImageScale) + code;
+			if (isCompute[i]) {
+				std::string common = usesCommon ? (inlineCommon ? InlineCommonCode(commonCode, 3) : "#include <common.glsl>\n") : "";
+				RenderPass computePass = item;
+				computePass.Code = code;
+				WriteFile(outPath + "/shaders/" + item.Name + ".glsl", GenerateComputeShader(computePass, common, isStatic[i], formats[i].Name));
+			} else if (item.Type == "cubemap") {
+				// compiled by the plugin itself, so the common code is always inlined
+				WriteFile(outPath + "/shaders/" + item.Name + ".glsl", GenerateCubemapShader(item, code, usesCommon ? InlineCommonCode(commonCode, 3) : ""));
+			} else if (opts.UseCustomLanguage) {
+				std::string shaderPath = outPath + "/shaders/" + item.Name + "." SHADERTOY_LANGUAGE_EXT;
+				WriteFile(shaderPath, GenerateCustomLanguageCode(item, code, usesCommon, isStatic[i]));
+			} else {
 				std::string shaderPath = outPath + "/shaders/" + item.Name + ".glsl";
-				WriteFile(shaderPath, GenerateGLSL(item.Code, usesCommon));
+				WriteFile(shaderPath, GenerateGLSL(item, code, usesCommon, inlineCommon, commonCode, isStatic[i]));
+			}
+		}
+		WriteFile(outPath + "/shaders/shadertoyVS.glsl", GenerateVertexShader());
+
+		// sound - mainSound() is compiled to SPIR-V & evaluated for every sample on the CPU, on a background thread
+		for (const auto& item : pipeline) {
+			if (item.Type != "sound")
+				continue;
+
+			if (!item.Inputs.empty()) {
+				summary += "\nThe sound pass reads channels which isn't supported when it's rendered on the CPU, " + item.Name + ".wav wasn't generated\n";
+				continue;
 			}
-			WriteFile(outPath + "/shaders/shadertoyVS.glsl", GenerateVertexShader());
 
-			// textures
-			std::vector<std::string> exportedTexs;
-			for (const auto& rpass : pipeline) {
-				for (const auto& inp : rpass.Inputs) {
-					if (inp.Type == "texture") {
+			std::string soundCode = GenerateSoundShader(GuardQualityKnobs(item.Code, opts.Knobs), usesCommon ? commonCode : "");
+			ShaderCompiler compiler;
+			std::vector<unsigned int> spv;
+			if (!compiler.Compile(soundCode.c_str(), soundCode.size(), ed::plugin::ShaderStage::Vertex, "main", nullptr, 0, spv)) {
+				summary += "\nFailed to compile the sound pass:\n";
+				for (const auto& msg : compiler.GetMessages())
+					summary += "  " + std::to_string(msg.Line) + ": " + msg.Text + "\n";
+			} else
+				soundJob.Start(spv, opts.SoundDuration * SOUND_SAMPLE_RATE, outPath + "/" + item.Name + ".wav");
+		}
+		if (opts.ImageScale < 1.0f)
+			WriteFile(outPath + "/shaders/" UPSCALE_PASS_NAME ".glsl", GenerateUpscaleShader(opts.SharpenUpscale));
+
+		// textures
+		std::vector<std::string> exportedTexs;
+		std::map<std::string, std::string> downloads;
+		std::string compressedList = "", downscaledList = "", volumeList = "", musicList = "";
+
+		MediaPack media;
+		bool hasMedia = !opts.MediaPackPath.empty() && media.Load(opts.MediaPackPath);
+		int packedCount = 0, downloadedCount = 0;
+
+		// every texture that isn't packed or prefetched is downloaded in parallel
+		std::vector<std::string> texSources, texData;
+		for (const auto& rpass : pipeline)
+			for (const auto& inp : rpass.Inputs)
+				if (inp.Type == "texture")
+					texSources.push_back(inp.Source);
+		std::sort(texSources.begin(), texSources.end());
+		texSources.erase(std::unique(texSources.begin(), texSources.end()), texSources.end());
+		DownloadFiles(texSources, hasMedia ? &media : nullptr, opts.Prefetched, texData, packedCount, downloadedCount);
+		for (int i = 0; i < texSources.size(); i++)
+			downloads[texSources[i]] = texData[i];
+
+		for (const auto& rpass : pipeline) {
+			for (const auto& inp : rpass.Inputs) {
+				if (inp.Type == "texture") {
+					std::string texName = GetTexturePath(inp, opts);
+					if (std::count(exportedTexs.begin(), exportedTexs.end(), texName) > 0)
+						continue;
+
+					exportedTexs.push_back(texName);
+
+					// the same file might be used with different vflip/sRGB settings
+					const std::string& fileData = downloads[inp.Source];
+
+					std::string texPath = outPath + texName;
+					if (!ghc::filesystem::exists(texPath))
+						ghc::filesystem::create_directories(ghc::filesystem::path(texPath).parent_path());
+
+					if (texName != inp.Source) {
+						Image img;
+						std::string resizeInfo = "";
+						if (PrepareImage(fileData, inp, opts, img, resizeInfo)) {
+							if (!resizeInfo.empty())
+								downscaledList += "  " + inp.Source + ": " + resizeInfo + " (" + texName + ")\n";
+
+							if (!opts.PrecomputeMipmaps && opts.TextureCompression == CompressionQuality::None) {
+								if (WritePNG(texPath, img))
+									continue;
+							} else {
+								// the mip chain is only needed if some channel uses the mipmap filter
+								bool needsMips = false;
+								for (const auto& pass : pipeline)
+									for (const auto& other : pass.Inputs)
+										needsMips |= other.Type == "texture" && other.Sampler.Filter == "mipmap" && GetTexturePath(other, opts) == texName;
+
+								// color that's still sRGB encoded is averaged in linear space
+								std::vector<Image> mips;
+								if (needsMips && opts.PrecomputeMipmaps)
+									GenerateMipmaps(img, inp.Sampler.SRGB && !opts.ProcessTextures, mips);
+								else
+									mips.push_back(img);
+
+								if (opts.TextureCompression == CompressionQuality::None) {
+									if (WriteDDS(texPath, mips))
+										continue;
+								} else {
+									// BC4 leaves green & blue at 0, every reader has to use the red channel only
+									bool redOnly = true;
+									for (const auto& pass : pipeline)
+										for (const auto& other : pass.Inputs)
+											if (other.Type == "texture" && GetTexturePath(other, opts) == texName)
+												redOnly &= GetReadComponents(pass, other.Channel) <= 1;
+
+									BlockFormat format = ChooseBlockFormat(img, redOnly, opts.TextureCompression);
+									std::vector<CompressedImage> blocks(mips.size());
+									CompressionStats stats = { 0.0, 0 };
+									size_t size = 0;
+									for (int i = 0; i < mips.size(); i++) {
+										CompressImage(mips[i], format, opts.TextureCompression, blocks[i], stats);
+										size += blocks[i].Data.size();
+									}
+
+									if (WriteDDS(texPath, format, blocks)) {
+										char buffer[256];
+										snprintf(buffer, sizeof(buffer), "  %s: %s, %dx%d, %.2f MB, %.1f dB PSNR\n", texName.c_str(), GetBlockFormatName(format),
+											img.Width, img.Height, size / (1024.0 * 1024.0), stats.GetPSNR());
+										compressedList += buffer;
+										continue;
+									}
+								}
+							}
+						}
+
+						// never store PNG/JPEG bytes under a _flip/_linear/.dds name, the project references the downloaded file instead
+						summary += "\nFailed to process " + inp.Source + ", the downloaded file is used as it is\n";
+						opts.RawTextures.insert(inp.Source);
 						if (std::count(exportedTexs.begin(), exportedTexs.end(), inp.Source) > 0)
 							continue;
-
 						exportedTexs.push_back(inp.Source);
+						texPath = outPath + inp.Source;
+					}
+
+					std::ofstream texFile(texPath, std::ofstream::binary);
+					texFile.write(fileData.c_str(), fileData.size());
+					texFile.close();
+					if (!texFile) {
+						summary += "\nFailed to write " + texPath + "\n";
+						return false;
+					}
+				} else if (inp.Type == "cubemap" && FindCubemapBuffer(pipeline, inp).empty()) {
+					std::string cubeName = GetCubemapName(inp);
+					if (std::count(exportedTexs.begin(), exportedTexs.end(), cubeName) > 0)
+						continue;
+
+					exportedTexs.push_back(cubeName);
+
+					std::vector<std::string> faces = GetCubemapFaces(inp.Source), faceData;
+					DownloadFiles(faces, hasMedia ? &media : nullptr, opts.Prefetched, faceData, packedCount, downloadedCount);
+
+					bool ok = true;
+					std::vector<Image> mips[6];
+					for (int i = 0; i < 6 && ok; i++) {
+						std::string faceName = GetCubemapPath(inp, i, opts);
+						std::string facePath = outPath + faceName;
+						if (!ghc::filesystem::exists(facePath))
+							ghc::filesystem::create_directories(ghc::filesystem::path(facePath).parent_path());
+
+						if (faceName == faces[i]) {
+							std::ofstream faceFile(facePath, std::ofstream::binary);
+							faceFile.write(faceData[i].c_str(), faceData[i].size());
+							if (!opts.PrecomputeMipmaps)
+								continue;
+						}
+
+						Image img;
+						std::string resizeInfo = "";
+						ok = PrepareImage(faceData[i], inp, opts, img, resizeInfo);
+						if (!ok)
+							break;
+
+						if (i == 0 && !resizeInfo.empty())
+							downscaledList += "  " + inp.Source + ": " + resizeInfo + " (" + cubeName + ", per face)\n";
+
+						if (faceName != faces[i])
+							ok = WritePNG(facePath, img);
+
+						if (!opts.PrecomputeMipmaps)
+							continue;
+						if (inp.Sampler.Filter == "mipmap")
+							GenerateMipmaps(img, inp.Sampler.SRGB && !opts.ProcessTextures, mips[i]);
+						else
+							mips[i].push_back(img);
+					}
 
-						std::string texPath = outPath + inp.Source;
-						if (!ghc::filesystem::exists(texPath))
-							ghc::filesystem::create_directories(ghc::filesystem::path(texPath).parent_path());
+					// the packed DDS isn't referenced by the project, the faces must all have the same size
+					if (ok && opts.PrecomputeMipmaps) {
+						bool sameSize = true;
+						for (int i = 1; i < 6; i++)
+							sameSize &= mips[i][0].Width == mips[0][0].Width && mips[i][0].Height == mips[0][0].Height;
+						if (!sameSize || !WriteCubeDDS(outPath + GetCubemapDDSPath(inp, opts), mips))
+							summary += "\nFailed to save the DDS cubemap of " + inp.Source + "\n";
+					}
+
+					// the faces have to match, so all of them fall back to the downloaded files
+					if (!ok) {
+						summary += "\nFailed to process the cubemap " + inp.Source + ", the downloaded faces are used as they are\n";
+						for (int i = 0; i < 6; i++) {
+							opts.RawTextures.insert(faces[i]);
+
+							std::string facePath = outPath + faces[i];
+							std::ofstream faceFile(facePath, std::ofstream::binary);
+							faceFile.write(faceData[i].c_str(), faceData[i].size());
+							faceFile.close();
+							if (!faceFile) {
+								summary += "\nFailed to write " + facePath + "\n";
+								return false;
+							}
+						}
+					}
+				} else if (inp.Type == "volume") {
+					std::string volumeName = GetVolumePath(inp);
+					if (std::count(exportedTexs.begin(), exportedTexs.end(), volumeName) > 0)
+						continue;
 
-						std::ofstream texFile(texPath, std::ofstream::binary);
+					exportedTexs.push_back(volumeName);
 
-						auto res = cli.Get(inp.Source.c_str());
+					std::string volumePath = outPath + volumeName;
+					if (!ghc::filesystem::exists(volumePath))
+						ghc::filesystem::create_directories(ghc::filesystem::path(volumePath).parent_path());
 
-						if (res && res->status == 200)
-							texFile.write(res->body.c_str(), res->body.size());
+					// the volume is converted chunk by chunk while it's read from the media pack or downloaded
+					VolumeConverter converter;
+					auto receiver = [&converter](const char* data, size_t size) { return converter.Write(data, size); };
 
-						texFile.close();
+					converter.Open(volumePath);
+					bool ok = hasMedia && media.Read(inp.Source, receiver) && converter.Close();
+					if (ok)
+						packedCount++;
+					else {
+						converter.Open(volumePath);
+						auto res = cli.Get(inp.Source.c_str(), receiver);
+						ok = res && res->status == 200 && converter.Close();
+						downloadedCount++;
 					}
-				}
+
+					const VolumeHeader& header = converter.GetHeader();
+					if (ok)
+						volumeList += "  " + volumeName + ": " + std::to_string(header.Width) + "x" + std::to_string(header.Height) + "x" + std::to_string(header.Depth) + ", " +
+							std::to_string(header.Channels) + (header.Format == 10 ? " x 32 bit float\n" : " x 8 bit\n");
+					else
+						summary += "\nFailed to import the volume " + inp.Source + "\n";
+				} else if (inp.Type == "music") {
+					std::string musicName = GetMusicPath(inp);
+					if (std::count(exportedTexs.begin(), exportedTexs.end(), musicName) > 0)
+						continue;
+
+					exportedTexs.push_back(musicName);
+
+					std::string musicPath = outPath + musicName;
+					if (!ghc::filesystem::exists(musicPath))
+						ghc::filesystem::create_directories(ghc::filesystem::path(musicPath).parent_path());
+
+					// the track is decoded once & all FFT/waveform rows are computed here, the plugin only uploads them while rendering
+					std::vector<std::string> musicData;
+					DownloadFiles(std::vector<std::string>(1, inp.Source), hasMedia ? &media : nullptr, opts.Prefetched, musicData, packedCount, downloadedCount);
+
+					std::vector<float> samples;
+					std::vector<unsigned char> frames;
+					int sampleRate = 0;
+					if (DecodeAudio(musicData[0], samples, sampleRate)) {
+						ComputeSpectrogram(samples, sampleRate, frames);
+						if (WriteSpectrogram(musicPath, sampleRate, frames)) {
+							char buffer[256];
+							snprintf(buffer, sizeof(buffer), "  %s: %.1f s, %d frames, %.2f MB\n", musicName.c_str(), (double)samples.size() / sampleRate,
+								(int)(frames.size() / (SPECTRUM_WIDTH * 2)), frames.size() / (1024.0 * 1024.0));
+							musicList += buffer;
+							continue;
+						}
+					}
+					summary += "\nFailed to import the music " + inp.Source + "\n";
+				} else if (inp.Type == "musicstream")
+					summary += "\nSoundCloud channels aren't supported (" + rpass.Name + ", iChannel" + std::to_string(inp.Channel) + ")\n";
 			}
-			
-			return err.size() == 0;
 		}
+		if (hasMedia)
+			summary += "\nMedia pack (revision " + std::to_string(media.GetRevision()) + "): " + std::to_string(packedCount) + " textures read locally, " +
+				std::to_string(downloadedCount) + " downloaded\n";
+		else if (!opts.MediaPackPath.empty())
+			summary += "\nNo media pack found in " + opts.MediaPackPath + ", all textures were downloaded\n";
+		if (!musicList.empty())
+			summary += "\nMusic spectrograms (" + std::to_string(SPECTRUM_FRAME_RATE) + " frames per second):\n" + musicList;
+		if (!volumeList.empty())
+			summary += "\nVolume textures (DDS):\n" + volumeList;
+		if (!downscaledList.empty())
+			summary += "\nDownscaled textures (original size -> imported size):\n" + downscaledList;
+		if (!compressedList.empty())
+			summary += "\nCompressed textures:\n" + compressedList;
+
+		// project.sprj - written after the textures since the ones that failed to process are referenced as downloaded
+		pugi::xml_document doc = GenerateProject(pipeline, opts);
+		std::ofstream sprjFile(outPath + "/project.sprj");
+		doc.print(sprjFile);
+		sprjFile.close();
+
+		// README.txt - written last so that it contains the texture stats
+		WriteFile(outPath + "/README.txt", GenerateReadMe(jdata["Shader"]["info"], summary));
 
-		return false;
+		return true;
 	}
 
 
 	bool Shadertoy::Init(bool isWeb, int sedVersion) {
 		m_isPopupOpened = false;
+		m_isSummaryOpened = false;
+		m_isSoundPopupOpened = false;
+		m_options.UseCustomLanguage = false;
+		m_options.InlineCommon = false;
+		m_options.ImageScale = 1.0f;
+		m_options.SharpenUpscale = false;
+		m_options.RenderStaticOnce = false;
+		m_options.FusePasses = false;
+		m_options.UseComputePasses = false;
+		m_options.InferFormats = false;
+		m_options.ProcessTextures = false; // linear color in 8 bits bands in the dark areas
+		m_options.PrecomputeMipmaps = false;
+		m_options.TextureCompression = CompressionQuality::None;
+		m_options.MaxTextureSize = 0;
+		m_options.SoundDuration = SOUND_DEFAULT_DURATION;
+		m_options.CubemapSize = CUBEMAP_BUFFER_SIZE;
+		m_options.Prefetched = nullptr;
+		m_mediaPackPath[0] = 0;
+		m_storePath[0] = 0;
+		m_codeQuery[0] = 0;
+		m_isBrowserOpened = false;
+		m_isBrowserDirty = false;
+		m_browserFilter[0] = 0;
+
+		std::error_code ec;
+		ghc::filesystem::path tempDir = ghc::filesystem::temp_directory_path(ec);
+		if (!ec)
+			m_compiler.SetCacheDirectory((tempDir / "shadertoy_spirv").string());
 
 		if (sedVersion == 1003005)
 			m_hostVersion = 1;
 		else
 			m_hostVersion = GetHostIPluginMaxVersion();
 
+		// cube & music textures are created by the plugin, the rest of it works without them
+		glewExperimental = true;
+		m_hasGL = glewInit() == GLEW_OK;
+		if (!m_hasGL)
+			Log("Shadertoy: failed to initialize GLEW, cube buffers & music textures are disabled", true, __FILE__, __LINE__);
+
 		return true;
 	}
 	void Shadertoy::InitUI(void* ctx)
 	{
 		ImGui::SetCurrentContext((ImGuiContext*)ctx);
 	}
+	void Shadertoy::Destroy()
+	{
+		m_thumbnails.Stop();
+		m_shaderIndex.Close();
+	}
 	void Shadertoy::Update(float delta)
 	{
+		// ##### SHADER BROWSER #####
+		if (m_isBrowserOpened)
+			m_renderBrowser();
+
 		// ##### UNIFORM MANAGER POPUP #####
 		if (m_isPopupOpened) {
 			ImGui::OpenPopup("Import Shadertoy project##st_import");
 			m_error = "";
 			m_isPopupOpened = false;
+			m_startPrefetch();
 		}
-		ImGui::SetNextWindowSize(ImVec2(530, 160), ImGuiCond_Once);
+		ImGui::SetNextWindowSize(ImVec2(530, 360), ImGuiCond_Once);
 		if (ImGui::BeginPopupModal("Import Shadertoy project##st_import")) {
 			ImGui::Text("Shadertoy link:"); ImGui::SameLine();
-			ImGui::PushItemWidth(-1);
-			ImGui::InputText("##st_link_insert", m_link, 256);
+			ImGui::PushItemWidth(BUTTON_SPACE_LEFT);
+			if (ImGui::InputText("##st_link_insert", m_link, 256))
+				m_startPrefetch();
 			ImGui::PopItemWidth();
+			ImGui::SameLine();
+			if (ImGui::Button("Load##st_load", ImVec2(-1, 0))) {
+				std::string id;
+				if (!ParseShadertoyID(m_link, id))
+					m_error = "Please insert correct Shadertoy link.";
+				else if (!m_loadShader(id))
+					m_error = "Shader either doesn't exist or doesn't have the PublicAPI flag set";
+				else
+					m_error = "";
+				m_errorOccured = (m_error.size() != 0);
+			}
+
+			// the shader & its assets are downloaded while the rest of the dialog is filled in
+			if (!m_prefetch.GetID().empty()) {
+				int done = 0, total = 0;
+				m_prefetch.GetProgress(done, total);
+				if (m_prefetch.IsFinished())
+					ImGui::TextDisabled("Prefetched %s (%d assets)", m_prefetch.GetID().c_str(), done);
+				else if (total < 0)
+					ImGui::TextDisabled("Prefetching %s...", m_prefetch.GetID().c_str());
+				else
+					ImGui::TextDisabled("Prefetching %s: %d/%d assets", m_prefetch.GetID().c_str(), done, total);
+			}
 
 			ImGui::Text("Project path:"); ImGui::SameLine();
 			ImGui::PushItemWidth(BUTTON_SPACE_LEFT);
@@ -481,6 +1455,171 @@ void main() {
 				ImGuiFileDialogClose("ShadertoyLocationDlg");
 			}
 
+			ImGui::Text("Media pack:"); ImGui::SameLine();
+			ImGui::PushItemWidth(BUTTON_SPACE_LEFT);
+			ImGui::InputText("##st_media_path", m_mediaPackPath, MY_PATH_LENGTH);
+			ImGui::PopItemWidth();
+			ImGui::SameLine();
+			if (ImGui::Button("...##st_media_btn", ImVec2(-1, 0)) && m_hostVersion >= 2)
+				ImGuiDirectoryDialogOpen("ShadertoyMediaDlg", "Media pack location");
+
+			if (m_hostVersion >= 2 && ImGuiFileDialogIsDone("ShadertoyMediaDlg")) {
+				if (ImGuiFileDialogGetResult())
+					ImGuiFileDialogGetPath(m_mediaPackPath);
+
+				ImGuiFileDialogClose("ShadertoyMediaDlg");
+			}
+
+			ImGui::Text("Shader store:"); ImGui::SameLine();
+			ImGui::PushItemWidth(BUTTON_SPACE_LEFT);
+			ImGui::InputText("##st_store_path", m_storePath, MY_PATH_LENGTH);
+			ImGui::PopItemWidth();
+			ImGui::SameLine();
+			if (ImGui::Button("...##st_store_btn", ImVec2(-1, 0)) && m_hostVersion >= 2)
+				ImGuiDirectoryDialogOpen("ShadertoyStoreDlg", "Shader store location");
+
+			if (m_hostVersion >= 2 && ImGuiFileDialogIsDone("ShadertoyStoreDlg")) {
+				if (ImGuiFileDialogGetResult())
+					ImGuiFileDialogGetPath(m_storePath);
+
+				ImGuiFileDialogClose("ShadertoyStoreDlg");
+			}
+
+			// code search over the stored shaders - picking a hit loads it
+			if (m_storePath[0] != 0) {
+				ImGui::Text("Search code:"); ImGui::SameLine();
+				ImGui::PushItemWidth(-1);
+				if (ImGui::InputText("##st_code_query", m_codeQuery, sizeof(m_codeQuery), ImGuiInputTextFlags_EnterReturnsTrue) && m_openStore())
+					m_codeIndex.Search(m_store, m_codeQuery, 100, m_codeHits);
+				ImGui::PopItemWidth();
+
+				if (!m_codeHits.empty()) {
+					ImGui::BeginChild("##st_code_hits", ImVec2(0, 100), true);
+					for (const auto& hit : m_codeHits) {
+						std::string label = hit.ID + "  " + hit.Name + "  [" + hit.Pass + ":" + std::to_string(hit.Line) + "] " + hit.Snippet;
+						if (ImGui::Selectable((label + "##st_hit_" + hit.ID).c_str(), hit.ID == m_loadedID)) {
+							snprintf(m_link, sizeof(m_link), "https://www.shadertoy.com/view/%s", hit.ID.c_str());
+							m_error = m_loadShader(hit.ID) ? "" : "Shader either doesn't exist or doesn't have the PublicAPI flag set";
+							m_errorOccured = (m_error.size() != 0);
+						}
+					}
+					ImGui::EndChild();
+				}
+			}
+
+			ImGui::Checkbox("Use " SHADERTOY_LANGUAGE_NAME " language (cached SPIR-V compilation)", &m_options.UseCustomLanguage);
+			ImGui::Checkbox("Inline common code into every pass", &m_options.InlineCommon);
+			ImGui::Checkbox("Render static buffers only once", &m_options.RenderStaticOnce);
+			ImGui::Checkbox("Fuse buffers that are only read at the same pixel", &m_options.FusePasses);
+			ImGui::Checkbox("Use compute shaders for buffers", &m_options.UseComputePasses);
+			ImGui::Checkbox("Infer render texture formats", &m_options.InferFormats);
+			ImGui::Checkbox("Apply vertical flip & sRGB to the texture files", &m_options.ProcessTextures);
+			ImGui::Checkbox("Save textures as DDS with precomputed mipmaps", &m_options.PrecomputeMipmaps);
+
+			const char* scaleNames[] = { "100%", "75%", "50%", "25%" };
+			const float scaleValues[] = { 1.0f, 0.75f, 0.5f, 0.25f };
+			int scaleIndex = 0;
+			for (int i = 0; i < 4; i++)
+				if (m_options.ImageScale == scaleValues[i])
+					scaleIndex = i;
+			ImGui::Text("Image resolution:"); ImGui::SameLine();
+			ImGui::PushItemWidth(100);
+			if (ImGui::Combo("##st_image_scale", &scaleIndex, scaleNames, 4))
+				m_options.ImageScale = scaleValues[scaleIndex];
+			ImGui::PopItemWidth();
+			if (m_options.ImageScale < 1.0f) {
+				ImGui::SameLine();
+				ImGui::Checkbox("Sharpen when upscaling", &m_options.SharpenUpscale);
+			}
+
+			const char* durationNames[] = { "10 s", "30 s", "60 s", "180 s" };
+			const int durationValues[] = { 10, 30, 60, SOUND_MAX_DURATION };
+			int durationIndex = 3;
+			for (int i = 0; i < 4; i++)
+				if (m_options.SoundDuration == durationValues[i])
+					durationIndex = i;
+			ImGui::Text("Sound duration:"); ImGui::SameLine();
+			ImGui::PushItemWidth(100);
+			if (ImGui::Combo("##st_sound_duration", &durationIndex, durationNames, 4))
+				m_options.SoundDuration = durationValues[durationIndex];
+			ImGui::PopItemWidth();
+
+			const char* cubeSizeNames[] = { "1024", "512", "256", "128" };
+			int cubeSizeIndex = 0;
+			for (int i = 0; i < 4; i++)
+				if (m_options.CubemapSize == (CUBEMAP_BUFFER_SIZE >> i))
+					cubeSizeIndex = i;
+			ImGui::SameLine();
+			ImGui::Text("Cube buffer face size:"); ImGui::SameLine();
+			ImGui::PushItemWidth(100);
+			if (ImGui::Combo("##st_cube_size", &cubeSizeIndex, cubeSizeNames, 4))
+				m_options.CubemapSize = CUBEMAP_BUFFER_SIZE >> cubeSizeIndex;
+			ImGui::PopItemWidth();
+
+			const char* compressionNames[] = { "None", "Fast", "High quality" };
+			int compressionIndex = (int)m_options.TextureCompression;
+			ImGui::Text("Texture compression:"); ImGui::SameLine();
+			ImGui::PushItemWidth(100);
+			if (ImGui::Combo("##st_tex_compression", &compressionIndex, compressionNames, 3))
+				m_options.TextureCompression = (CompressionQuality)compressionIndex;
+			ImGui::PopItemWidth();
+
+			const char* sizeNames[] = { "Default", "Original", "2048", "1024", "512", "256" };
+			const int sizeValues[] = { -1, 0, 2048, 1024, 512, 256 };
+			int sizeIndex = 0; // the global limit has no "Default" entry
+			for (int i = 1; i < 6; i++)
+				if (m_options.MaxTextureSize == sizeValues[i])
+					sizeIndex = i - 1;
+			ImGui::SameLine();
+			ImGui::Text("Max texture size:"); ImGui::SameLine();
+			ImGui::PushItemWidth(100);
+			if (ImGui::Combo("##st_max_tex_size", &sizeIndex, sizeNames + 1, 5))
+				m_options.MaxTextureSize = sizeValues[sizeIndex + 1];
+			ImGui::PopItemWidth();
+
+			// per texture size limits
+			if (m_options.TextureSizes.size() > 0 && ImGui::CollapsingHeader("Texture sizes")) {
+				ImGui::Columns(2, "##st_tex_sizes", false);
+				for (auto& tex : m_options.TextureSizes) {
+					ImGui::Text("%s", tex.first.c_str());
+					ImGui::NextColumn();
+
+					int texSizeIndex = 0;
+					for (int i = 0; i < 6; i++)
+						if (tex.second == sizeValues[i])
+							texSizeIndex = i;
+					ImGui::PushItemWidth(-1);
+					if (ImGui::Combo(("##st_tex_size_" + tex.first).c_str(), &texSizeIndex, sizeNames, 6))
+						tex.second = sizeValues[texSizeIndex];
+					ImGui::PopItemWidth();
+					ImGui::NextColumn();
+				}
+				ImGui::Columns(1);
+			}
+
+			// quality knobs
+			if (m_options.Knobs.size() > 0 && ImGui::CollapsingHeader("Quality settings")) {
+				ImGui::Columns(3, "##st_knobs", false);
+				for (auto& knob : m_options.Knobs) {
+					ImGui::Text("%s", knob.Name.c_str());
+					ImGui::NextColumn();
+
+					ImGui::PushItemWidth(-1);
+					ImGui::InputText(("##st_knob_" + knob.Name).c_str(), knob.Value, sizeof(knob.Value));
+					ImGui::PopItemWidth();
+					ImGui::NextColumn();
+
+					ImGui::TextDisabled("default: %s%s", knob.Default.c_str(), knob.InCommon ? " (common)" : "");
+					ImGui::NextColumn();
+				}
+				ImGui::Columns(1);
+
+				if (ImGui::Button("Performance preset"))
+					ApplyPerformancePreset(m_options.Knobs);
+				ImGui::SameLine();
+				if (ImGui::Button("Reset"))
+					ResetQualityKnobs(m_options.Knobs);
+			}
 
 			if (!m_errorOccured)
 				ImGui::NewLine();
@@ -489,25 +1628,37 @@ void main() {
 
 
 			if (ImGui::Button("Ok")) {
-				std::string stLink = m_link;
+				std::string id;
 				std::string errMessage = "";
-				if (stLink.find("www.shadertoy.com/view/") == std::string::npos)
+				if (!ParseShadertoyID(m_link, id))
 					errMessage = "Please insert correct Shadertoy link.";
 
 				if (errMessage.size() == 0) {
-					size_t lastSlash = stLink.find_last_of('/');
-					std::string id = stLink.substr(lastSlash+1);
-
 					std::string outPath(m_path);
 
 					if (outPath.size() == 0)
 						errMessage = "Please set the output path";
 					else {
-						bool res = Generate(id, outPath);
-						if (!res)
+						// the link might have changed since the last Load
+						bool res = (id == m_loadedID) || m_loadShader(id);
+						m_options.MediaPackPath = m_mediaPackPath;
+
+						// Generate downloads the assets that haven't arrived yet in parallel
+						std::map<std::string, std::string> prefetched;
+						if (m_prefetch.GetID() == id)
+							prefetched = m_prefetch.TakeFiles();
+						m_prefetch.Cancel();
+
+						m_options.Prefetched = &prefetched;
+						if (res)
+							res = Generate(m_shaderData, outPath, m_options, m_soundJob, m_summary);
+						m_options.Prefetched = nullptr;
+
+						if (!res) {
+							m_soundJob.Cancel();
 							errMessage = "Shader either doesn't exist or doesn't have the PublicAPI flag set";
-						else
-							OpenProject(UI, (outPath + "/project.sprj").c_str());
+						} else
+							m_openImported(outPath);
 					}
 				}
 
@@ -518,10 +1669,510 @@ void main() {
 					ImGui::CloseCurrentPopup();
 			}
 			ImGui::SameLine();
-			if (ImGui::Button("Cancel"))
+			if (ImGui::Button("Cancel")) {
+				m_prefetch.Cancel();
 				ImGui::CloseCurrentPopup();
+			}
 			ImGui::EndPopup();
 		}
+
+		// ##### SOUND RENDERING POPUP #####
+		if (m_isSoundPopupOpened) {
+			ImGui::OpenPopup("Rendering sound##st_sound");
+			m_isSoundPopupOpened = false;
+		}
+		if (ImGui::BeginPopupModal("Rendering sound##st_sound", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
+			ImGui::Text("Evaluating mainSound for %d s of audio on the CPU...", m_options.SoundDuration);
+			ImGui::ProgressBar(m_soundJob.GetProgress(), ImVec2(400, 0));
+
+			bool cancelled = ImGui::Button("Cancel");
+			if (cancelled || m_soundJob.IsFinished()) {
+				std::string wavName = m_soundJob.GetPath().substr(m_soundJob.GetPath().find_last_of('/') + 1);
+				std::string error;
+				double seconds = 0.0;
+				size_t bytes = 0;
+
+				// a sound that failed to render fails the import, the project would reference a missing or broken WAV file
+				if (cancelled) {
+					m_soundJob.Cancel();
+					m_summary += "\nThe sound rendering was cancelled, the project wasn't opened\n";
+				} else if (m_soundJob.Finish(error, seconds, bytes)) {
+					char buffer[256];
+					snprintf(buffer, sizeof(buffer), "\nSound rendered on the CPU: %s, %d s at %d Hz, %.2f MB (took %.1f s)\n", wavName.c_str(), m_options.SoundDuration,
+						SOUND_SAMPLE_RATE, bytes / (1024.0 * 1024.0), seconds);
+					m_summary += buffer;
+					OpenProject(UI, m_soundProjectPath.c_str());
+				} else
+					m_summary += "\nFailed to render the sound pass: " + error + "\nThe project wasn't opened\n";
+
+				m_isSummaryOpened = true;
+				ImGui::CloseCurrentPopup();
+			}
+			ImGui::EndPopup();
+		}
+
+		// ##### IMPORT SUMMARY POPUP #####
+		if (m_isSummaryOpened) {
+			ImGui::OpenPopup("Import summary##st_summary");
+			m_isSummaryOpened = false;
+		}
+		ImGui::SetNextWindowSize(ImVec2(600, 300), ImGuiCond_Once);
+		if (ImGui::BeginPopupModal("Import summary##st_summary")) {
+			ImGui::BeginChild("##st_summary_text", ImVec2(0, -ImGui::GetFrameHeightWithSpacing()));
+			ImGui::TextUnformatted(m_summary.c_str());
+			ImGui::EndChild();
+
+			if (ImGui::Button("Ok"))
+				ImGui::CloseCurrentPopup();
+			ImGui::EndPopup();
+		}
+	}
+
+	bool Shadertoy::m_loadShader(const std::string& id, bool fromStore)
+	{
+		m_loadedID = "";
+		m_options.Knobs.clear();
+		m_options.TextureSizes.clear();
+
+		std::string response, err;
+		if (fromStore && m_openStore() && m_store.Get(id, response)) {
+			m_shaderData = json11::Json::parse(response, err);
+			if (!err.empty() || !m_shaderData["Shader"].is_object())
+				return false;
+		} else {
+			bool prefetched = m_prefetch.GetID() == id && m_prefetch.WaitForShader(m_shaderData);
+			if (!prefetched && !FetchShader(id, m_shaderData))
+				return false;
+
+			if (m_openStore()) {
+				response = m_shaderData.dump();
+				bool changed = false;
+				if (m_store.Put(id, response, &changed) && (changed || !m_codeIndex.Has(id)))
+					m_codeIndex.Add(id, response);
+				m_isBrowserDirty |= changed;
+			}
+		}
+
+		m_loadedID = id;
+		std::vector<RenderPass> passes = ParseRenderPasses(m_shaderData["Shader"]["renderpass"]);
+		m_options.Knobs = FindQualityKnobs(passes);
+		for (const auto& pass : passes)
+			for (const auto& inp : pass.Inputs)
+				if (inp.Type == "texture" || (inp.Type == "cubemap" && FindCubemapBuffer(passes, inp).empty()))
+					m_options.TextureSizes[inp.Source] = -1;
+
+		return true;
+	}
+
+	bool Shadertoy::m_openStore()
+	{
+		if (m_storePath[0] == 0)
+			return false;
+		if (m_openedStorePath == m_storePath)
+			return true;
+
+		m_openedStorePath = "";
+		m_codeHits.clear();
+		if (!m_store.Open(m_storePath) || !m_codeIndex.Open(m_storePath))
+			return false;
+
+		m_openedStorePath = m_storePath;
+		return true;
+	}
+
+	void Shadertoy::m_startPrefetch()
+	{
+		// only complete IDs are worth a request
+		std::string id;
+		bool isComplete = ParseShadertoyID(m_link, id) && id.size() == 6 &&
+			std::all_of(id.begin(), id.end(), [](char c) { return isalnum((unsigned char)c) != 0; });
+		if (!isComplete) {
+			m_prefetch.Cancel();
+			return;
+		}
+
+		if (id != m_prefetch.GetID())
+			m_prefetch.Start(id, m_mediaPackPath, ListAssetSources);
+	}
+	void Shadertoy::m_renderBrowser()
+	{
+		ImGui::SetNextWindowSize(ImVec2(620, 500), ImGuiCond_FirstUseEver);
+		if (!ImGui::Begin("Shadertoy browser##st_browser", &m_isBrowserOpened)) {
+			ImGui::End();
+			return;
+		}
+
+		if (!m_openStore()) {
+			ImGui::TextWrapped("Set the shader store in the import dialog (File -> Import Shadertoy project) or fill it with the shadermirror tool to browse the shaders that were fetched before.");
+			ImGui::End();
+			return;
+		}
+		if (m_browserStorePath != m_openedStorePath || m_isBrowserDirty)
+			m_updateBrowser();
+
+		ImGui::Text("Filter:"); ImGui::SameLine();
+		ImGui::PushItemWidth(-80 * GetDPI());
+		if (ImGui::InputText("##st_browser_filter", m_browserFilter, sizeof(m_browserFilter)))
+			m_filterBrowser();
+		ImGui::PopItemWidth();
+		ImGui::SameLine();
+		if (ImGui::Button("Refresh##st_browser_refresh", ImVec2(-1, 0)))
+			m_updateBrowser();
+		ImGui::TextDisabled("%d of %d shaders - name, author & tag words, or pass, input & flag terms (bufferd, cubemap, mouse, ...)", (int)m_browserRows.size(), m_shaderIndex.GetCount());
+
+		if (!m_errorOccured)
+			ImGui::Separator();
+		else
+			ImGui::Text("[ERROR] %s", m_error.c_str());
+
+		// only the visible rows are laid out & only their thumbnails are requested
+		float thumbWidth = BROWSER_THUMBNAIL_WIDTH * GetDPI(), thumbHeight = BROWSER_THUMBNAIL_HEIGHT * GetDPI();
+		ImGui::BeginChild("##st_browser_rows");
+		ImGuiListClipper clipper;
+		clipper.Begin(m_browserRows.size(), thumbHeight + ImGui::GetStyle().ItemSpacing.y);
+		while (clipper.Step()) {
+			for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+				const ShaderIndexRecord& record = m_shaderIndex.GetRecord(m_browserRows[i]);
+				ImGui::PushID(i);
+
+				int width = 0, height = 0;
+				unsigned int tex = m_thumbnails.GetTexture(record.ID, width, height);
+				if (tex != 0)
+					ImGui::Image((ImTextureID)(intptr_t)tex, ImVec2(thumbWidth, thumbHeight));
+				else
+					ImGui::Dummy(ImVec2(thumbWidth, thumbHeight));
+				ImGui::SameLine();
+
+				ImGui::BeginGroup();
+				ImGui::Text("%s", m_shaderIndex.GetString(record.Name));
+				ImGui::TextDisabled("%s by %s - %u likes, %u views, %d passes", record.ID, m_shaderIndex.GetString(record.Author), record.Likes, record.Views, (int)record.PassCount);
+				if (ImGui::Button("Import"))
+					m_importStored(record.ID);
+				ImGui::EndGroup();
+
+				ImGui::PopID();
+			}
+		}
+		clipper.End();
+		ImGui::EndChild();
+
+		ImGui::End();
+	}
+	void Shadertoy::m_updateBrowser()
+	{
+		// the index is rewritten incrementally - only the responses stored since the last time are parsed
+		std::string indexPath = m_openedStorePath + "/" SHADER_INDEX_FILE;
+		m_shaderIndex.Close();
+		WriteShaderIndex(m_store, indexPath);
+		m_shaderIndex.Open(indexPath);
+
+		if (m_browserStorePath != m_openedStorePath || !m_thumbnails.IsRunning())
+			m_thumbnails.Start(m_openedStorePath + "/thumbs");
+
+		m_browserStorePath = m_openedStorePath;
+		m_isBrowserDirty = false;
+		m_filterBrowser();
+	}
+	void Shadertoy::m_filterBrowser()
+	{
+		ShaderIndexFilter filter = { 0, 0, 0, 0 };
+		std::vector<std::string> words;
+		std::stringstream ss(m_browserFilter);
+		std::string word;
+		while (ss >> word) {
+			std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+			if (!AddFilterTerm(filter, word))
+				words.push_back(word);
+		}
+
+		m_shaderIndex.Filter(filter, m_browserRows);
+
+		// other words have to appear in the name, the author or the tags
+		if (!words.empty()) {
+			std::vector<int> rows;
+			for (int row : m_browserRows) {
+				const ShaderIndexRecord& record = m_shaderIndex.GetRecord(row);
+				std::string text = std::string(m_shaderIndex.GetString(record.Name)) + " " + m_shaderIndex.GetString(record.Author) + " " + m_shaderIndex.GetString(record.Tags);
+				std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+
+				bool matches = true;
+				for (const auto& w : words)
+					matches &= text.find(w) != std::string::npos;
+				if (matches)
+					rows.push_back(row);
+			}
+			m_browserRows.swap(rows);
+		}
+
+		// newest first
+		std::stable_sort(m_browserRows.begin(), m_browserRows.end(), [&](int a, int b) {
+			return m_shaderIndex.GetRecord(a).Date > m_shaderIndex.GetRecord(b).Date;
+		});
+	}
+	void Shadertoy::m_openImported(const std::string& outPath)
+	{
+		// the project references the sound's WAV file, so it waits until the sound is rendered
+		std::string projectPath = outPath + "/project.sprj";
+		if (m_soundJob.IsActive()) {
+			m_soundProjectPath = projectPath;
+			m_isSoundPopupOpened = true;
+			return;
+		}
+
+		OpenProject(UI, projectPath.c_str());
+		m_isSummaryOpened = true;
+	}
+	void Shadertoy::m_importStored(const std::string& id)
+	{
+		snprintf(m_link, sizeof(m_link), "https://www.shadertoy.com/view/%s", id.c_str());
+		m_error = "";
+		if (!m_loadShader(id, true))
+			m_error = "Failed to read " + id + " from the shader store";
+		m_errorOccured = (m_error.size() != 0);
+		if (m_errorOccured)
+			return;
+
+		// with a project path the shader is imported right away (into <path>/<id>), otherwise the import dialog is opened
+		std::string outPath(m_path);
+		if (outPath.empty()) {
+			m_isPopupOpened = true;
+			return;
+		}
+
+		outPath += "/" + id;
+		m_options.MediaPackPath = m_mediaPackPath;
+		if (Generate(m_shaderData, outPath, m_options, m_soundJob, m_summary))
+			m_openImported(outPath);
+		else {
+			m_soundJob.Cancel();
+			m_error = "Failed to import " + id;
+			m_errorOccured = true;
+		}
+	}
+
+	const unsigned int* Shadertoy::CustomLanguage_CompileToSPIRV(int langID, const char* src, size_t src_len, ed::plugin::ShaderStage stage, const char* entry, ed::plugin::ShaderMacro* macros, size_t macroCount, size_t* spv_length, bool* compiled)
+	{
+		// common.glsl & other includes are searched for in the project directory and the include paths
+		std::vector<std::string> includeDirs;
+		includeDirs.push_back(GetProjectDirectory(Project));
+		int includePathCount = GetIncludePathCount();
+		for (int i = 0; i < includePathCount; i++)
+			includeDirs.push_back(GetIncludePath(Project, i));
+		m_compiler.SetIncludeDirectories(includeDirs);
+
+		*compiled = m_compiler.Compile(src, src_len, stage, entry, macros, macroCount, m_spv);
+
+		const char* itemName = GetMessagesCurrentItem(Messages);
+		for (const auto& msg : m_compiler.GetMessages()) {
+			ed::plugin::MessageType type = msg.Error ? ed::plugin::MessageType::Error : ed::plugin::MessageType::Warning;
+			if (msg.File.empty())
+				AddMessage(Messages, type, itemName, msg.Text.c_str(), msg.Line);
+			else
+				AddMessage(Messages, type, itemName, (msg.File + "(" + std::to_string(msg.Line) + "): " + msg.Text).c_str(), -1);
+		}
+
+		if (!*compiled)
+			m_spv.clear();
+
+		*spv_length = m_spv.size();
+		return m_spv.data();
+	}
+
+	bool Shadertoy::Object_IsBindable(const char* type)
+	{
+		return strcmp(type, SHADERTOY_MUSIC_OBJECT) == 0 || strcmp(type, SHADERTOY_CUBEMAP_OBJECT) == 0;
+	}
+	void Shadertoy::Object_Remove(const char* name, const char* type, void* data, unsigned int id)
+	{
+		if (strcmp(type, SHADERTOY_CUBEMAP_OBJECT) == 0) {
+			m_cubemaps.erase(name);
+			delete (CubemapObject*)data;
+			return;
+		}
+		if (strcmp(type, SHADERTOY_MUSIC_OBJECT) != 0)
+			return;
+
+		MusicObject* obj = (MusicObject*)data;
+		glDeleteTextures(1, &obj->Texture);
+		delete obj;
+	}
+	void Shadertoy::Object_Bind(const char* type, void* data, unsigned int id)
+	{
+		if (strcmp(type, SHADERTOY_CUBEMAP_OBJECT) == 0) {
+			glBindTexture(GL_TEXTURE_CUBE_MAP, ((CubemapObject*)data)->Buffer.GetTexture());
+			return;
+		}
+		if (strcmp(type, SHADERTOY_MUSIC_OBJECT) != 0)
+			return;
+
+		// the frame is only uploaded when it changes - nothing is decoded on the render thread
+		MusicObject* obj = (MusicObject*)data;
+		glBindTexture(GL_TEXTURE_2D, obj->Texture);
+
+		float time = GetTime();
+		int frame = obj->Spectrogram.GetFrameCount() == 0 ? -1 : (int)((long long)(std::max(0.0f, time) * SPECTRUM_FRAME_RATE) % obj->Spectrogram.GetFrameCount());
+		if (frame >= 0 && frame != obj->Frame) {
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, SPECTRUM_WIDTH, 2, GL_RED, GL_UNSIGNED_BYTE, obj->Spectrogram.GetFrame(time));
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+			obj->Frame = frame;
+		}
+	}
+	const char* Shadertoy::Object_Export(char* type, void* data, unsigned int id)
+	{
+		if (strcmp(type, SHADERTOY_CUBEMAP_OBJECT) == 0)
+			return ((CubemapObject*)data)->Args.c_str();
+		if (strcmp(type, SHADERTOY_MUSIC_OBJECT) != 0)
+			return nullptr;
+
+		return ((MusicObject*)data)->Path.c_str();
+	}
+	void Shadertoy::Object_Import(const char* name, const char* type, const char* argsString)
+	{
+		if (!m_hasGL && Object_IsBindable(type)) {
+			AddMessage(Messages, ed::plugin::MessageType::Error, name, "GLEW failed to initialize, the object is disabled", -1);
+			return;
+		}
+
+		if (strcmp(type, SHADERTOY_CUBEMAP_OBJECT) == 0) {
+			CubemapObject* obj = new CubemapObject();
+			obj->Args = argsString == nullptr ? "" : argsString;
+
+			int size = CUBEMAP_BUFFER_SIZE, feedback = 0;
+			std::string filter = "linear";
+			std::istringstream(obj->Args) >> size >> filter >> feedback;
+			if (!obj->Buffer.Create(size, filter, feedback != 0))
+				AddMessage(Messages, ed::plugin::MessageType::Error, name, "Failed to create the cubemap", -1);
+
+			m_cubemaps[name] = obj;
+			AddObject(ObjectManager, name, type, obj, obj->Buffer.GetTexture(), this);
+			return;
+		}
+		if (strcmp(type, SHADERTOY_MUSIC_OBJECT) != 0)
+			return;
+
+		MusicObject* obj = new MusicObject();
+		obj->Path = argsString == nullptr ? "" : argsString;
+		obj->Frame = -1;
+
+		char path[MY_PATH_LENGTH];
+		GetProjectPath(Project, obj->Path.c_str(), path);
+		if (!obj->Spectrogram.Open(path))
+			AddMessage(Messages, ed::plugin::MessageType::Error, name, ("Failed to open the spectrogram " + obj->Path).c_str(), -1);
+
+		// row 0 = FFT, row 1 = waveform, silent until the first frame is uploaded
+		std::vector<unsigned char> silence(SPECTRUM_WIDTH * 2, 0);
+		memset(silence.data() + SPECTRUM_WIDTH, 128, SPECTRUM_WIDTH);
+
+		glGenTextures(1, &obj->Texture);
+		glBindTexture(GL_TEXTURE_2D, obj->Texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, SPECTRUM_WIDTH, 2, 0, GL_RED, GL_UNSIGNED_BYTE, silence.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		AddObject(ObjectManager, name, type, obj, obj->Texture, this);
+	}
+
+	void Shadertoy::PipelineItem_Remove(const char* itemName, const char* type, void* data)
+	{
+		if (strcmp(type, SHADERTOY_CUBEMAP_PASS) != 0)
+			return;
+
+		m_cubemapPasses.erase(itemName);
+		delete (CubemapPassItem*)data;
+	}
+	void Shadertoy::PipelineItem_Execute(const char* type, void* data, void* children, int count)
+	{
+		if (strcmp(type, SHADERTOY_CUBEMAP_PASS) != 0)
+			return;
+
+		CubemapPassItem* item = (CubemapPassItem*)data;
+		auto target = m_cubemaps.find(item->Name);
+		if (target == m_cubemaps.end())
+			return;
+
+		// a cube buffer that reads itself gets the previous frame, the new one is rendered to its second texture
+		CubemapChannel channels[4] = {};
+		for (const auto& channel : item->Channels) {
+			if (channel.Slot < 0 || channel.Slot >= 4)
+				continue;
+
+			auto cube = m_cubemaps.find(channel.Object);
+			if (cube != m_cubemaps.end())
+				channels[channel.Slot] = { GL_TEXTURE_CUBE_MAP, cube->second->Buffer.GetTexture() };
+			else {
+				GLenum texTarget = channel.Type == "cube" ? GL_TEXTURE_CUBE_MAP : (channel.Type == "3d" ? GL_TEXTURE_3D : GL_TEXTURE_2D);
+				channels[channel.Slot] = { texTarget, GetTexture(ObjectManager, channel.Object.c_str()) };
+			}
+		}
+
+		float time = GetTime();
+		item->Pass.Render(target->second->Buffer, time, std::max(0.0f, time - item->LastTime), GetFrameIndex(), channels);
+		item->LastTime = time;
+	}
+	const char* Shadertoy::PipelineItem_Export(const char* type, void* data)
+	{
+		if (strcmp(type, SHADERTOY_CUBEMAP_PASS) != 0)
+			return nullptr;
+
+		return ((CubemapPassItem*)data)->Args.c_str();
+	}
+	void* Shadertoy::PipelineItem_Import(const char* ownerName, const char* name, const char* type, const char* argsString)
+	{
+		if (strcmp(type, SHADERTOY_CUBEMAP_PASS) != 0)
+			return nullptr;
+
+		CubemapPassItem* item = new CubemapPassItem();
+		item->Name = name;
+		item->Args = argsString == nullptr ? "" : argsString;
+		item->LastTime = 0.0f;
+
+		// <shader path>\n<slot> <type> <object name>\n...
+		std::istringstream stream(item->Args);
+		std::getline(stream, item->ShaderPath);
+		std::string line;
+		while (std::getline(stream, line)) {
+			CubemapPassChannel channel;
+			std::istringstream lineStream(line);
+			if (lineStream >> channel.Slot >> channel.Type && std::getline(lineStream >> std::ws, channel.Object))
+				item->Channels.push_back(channel);
+		}
+
+		m_compileCubemapPass(item);
+		m_cubemapPasses[name] = item;
+		return item;
+	}
+	void Shadertoy::HandleRecompile(const char* itemName)
+	{
+		auto item = m_cubemapPasses.find(itemName);
+		if (item != m_cubemapPasses.end())
+			m_compileCubemapPass(item->second);
+	}
+	void Shadertoy::m_compileCubemapPass(CubemapPassItem* item)
+	{
+		// never rendered since its cube buffer doesn't exist either
+		if (!m_hasGL)
+			return;
+
+		char path[MY_PATH_LENGTH];
+		GetProjectPath(Project, item->ShaderPath.c_str(), path);
+
+		std::ifstream file(path);
+		std::stringstream source;
+		source << file.rdbuf();
+
+		ClearMessageGroup(Messages, item->Name.c_str());
+
+		std::string log = "";
+		if (!file.is_open())
+			AddMessage(Messages, ed::plugin::MessageType::Error, item->Name.c_str(), ("Failed to open " + item->ShaderPath).c_str(), -1);
+		else if (!item->Pass.Compile(source.str(), log))
+			AddMessage(Messages, ed::plugin::MessageType::Error, item->Name.c_str(), log.c_str(), -1);
 	}
 
 	bool Shadertoy::HasMenuItems(const char* name)
@@ -534,6 +2185,8 @@ void main() {
 			if (ImGui::Selectable("Import Shadertoy project")) {
 				m_isPopupOpened = true;
 			}
+			if (ImGui::Selectable("Browse stored Shadertoy shaders"))
+				m_isBrowserOpened = true;
 		}
 	}
 }
\ No newline at end of file
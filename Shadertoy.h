@@ -1,12 +1,85 @@
 #pragma once
 #include <PluginAPI/Plugin.h>
+#include "ShaderCompiler.h"
+#include "ShaderAnalyzer.h"
+#include "TextureCompression.h"
+#include "AudioSpectrum.h"
+#include "CubemapPass.h"
+#include "ShaderStore.h"
+#include "CodeIndex.h"
+#include "ShaderIndex.h"
+#include "ThumbnailCache.h"
+#include "ShaderPrefetch.h"
+#include "SoundRenderer.h"
+#include <json11/json11.hpp>
 #include <vector>
 #include <string>
+#include <map>
+#include <set>
 
 #define MY_PATH_LENGTH 512 // TODO: use MAX_PATH or sth
+#define SHADERTOY_LANGUAGE_NAME "Shadertoy GLSL"
+#define SHADERTOY_LANGUAGE_EXT "stglsl"
+#define SHADERTOY_MUSIC_OBJECT "ShadertoyMusic"
+#define SHADERTOY_CUBEMAP_OBJECT "ShadertoyCubemap"
+#define SHADERTOY_CUBEMAP_PASS "ShadertoyCubemapPass"
 
 namespace st
 {
+	struct ImportOptions
+	{
+		bool UseCustomLanguage; // write raw mainImage code & compile it through the plugin
+		bool InlineCommon; // paste common code (with #line directives) instead of #include <common.glsl>
+		std::vector<QualityKnob> Knobs;
+		float ImageScale; // < 1 renders the Image pass to a smaller render texture & upscales it
+		bool SharpenUpscale;
+		bool RenderStaticOnce; // buffers that don't depend on time, input or feedback are only rendered on the first frame & resize
+		bool FusePasses; // merge buffers into the pass that reads them at the same pixel
+		bool UseComputePasses; // render eligible buffers with compute shaders that write to images
+		bool InferFormats; // pick the render texture format from the buffer's code instead of the host default
+		bool ProcessTextures; // apply vflip & sRGB to the texture files instead of leaving it to the host
+		bool PrecomputeMipmaps; // save the textures as DDS with the mip chain so that the host only uploads them
+		CompressionQuality TextureCompression; // block compress the textures (saved as DDS)
+		int MaxTextureSize; // larger textures are downscaled during the import, 0 = no limit
+		std::map<std::string, int> TextureSizes; // per texture source, overrides MaxTextureSize when >= 0
+		std::set<std::string> RawTextures; // sources that failed to process, the downloaded file is used as it is (filled by Generate)
+		std::string MediaPackPath; // stock media is read from this pack before falling back to shadertoy.com
+		int SoundDuration; // seconds of audio rendered on the CPU for the sound pass
+		int CubemapSize; // face size of the cube buffers
+		const std::map<std::string, std::string>* Prefetched; // assets downloaded while the import dialog was open, can be null
+	};
+
+	/* music channel - a 512x2 texture that is updated with the precomputed spectrogram frame when it's bound */
+	struct MusicObject
+	{
+		std::string Path; // relative to the project
+		SpectrogramFile Spectrogram;
+		unsigned int Texture;
+		int Frame; // currently uploaded
+	};
+
+	/* Cube A - the pass (a pipeline item) renders to the cubemap object with the same name */
+	struct CubemapObject
+	{
+		std::string Args; // <face size> <filter> <1 if the pass reads itself>
+		CubemapBuffer Buffer;
+	};
+	struct CubemapPassChannel
+	{
+		int Slot;
+		std::string Type; // 2d, cube or 3d
+		std::string Object;
+	};
+	struct CubemapPassItem
+	{
+		std::string Name;
+		std::string Args; // shader path on the first line, then one <slot> <type> <object name> line per channel
+		std::string ShaderPath;
+		std::vector<CubemapPassChannel> Channels;
+		CubemapPass Pass;
+		float LastTime;
+	};
+
 	class Shadertoy : public ed::IPlugin2
 	{
 	public:
@@ -14,7 +87,7 @@ namespace st
 		virtual void InitUI(void* ctx);
 		virtual void OnEvent(void* e) { }
 		virtual void Update(float delta);
-		virtual void Destroy() { }
+		virtual void Destroy();
 
 		virtual bool IsRequired() { return 0; }
 		virtual bool IsVersionCompatible(int version) { return 1; }
@@ -59,16 +132,16 @@ namespace st
 		// object manager stuff
 		virtual bool Object_HasPreview(const char* type) { return 0; }
 		virtual void Object_ShowPreview(const char* type, void* data, unsigned int id) { }
-		virtual bool Object_IsBindable(const char* type) { return 0; }
+		virtual bool Object_IsBindable(const char* type);
 		virtual bool Object_IsBindableUAV(const char* type) { return 0; }
-		virtual void Object_Remove(const char* name, const char* type, void* data, unsigned int id) { }
+		virtual void Object_Remove(const char* name, const char* type, void* data, unsigned int id);
 		virtual bool Object_HasExtendedPreview(const char* type) { return 0; }
 		virtual void Object_ShowExtendedPreview(const char* type, void* data, unsigned int id) { }
 		virtual bool Object_HasProperties(const char* type) { return 0; }
 		virtual void Object_ShowProperties(const char* type, void* data, unsigned int id) { }
-		virtual void Object_Bind(const char* type, void* data, unsigned int id) { }
-		virtual const char* Object_Export(char* type, void* data, unsigned int id) { return 0; }
-		virtual void Object_Import(const char* name, const char* type, const char* argsString) { }
+		virtual void Object_Bind(const char* type, void* data, unsigned int id);
+		virtual const char* Object_Export(char* type, void* data, unsigned int id);
+		virtual void Object_Import(const char* name, const char* type, const char* argsString);
 		virtual bool Object_HasContext(const char* type) { return 0; }
 		virtual void Object_ShowContext(const char* type, void* data) { }
 
@@ -81,20 +154,20 @@ namespace st
 		virtual bool PipelineItem_CanHaveChild(const char* type, void* data, ed::plugin::PipelineItemType itemType) { return 0; }
 		virtual int PipelineItem_GetInputLayoutSize(const char* type, void* data) { return 0; }
 		virtual void PipelineItem_GetInputLayoutItem(const char* type, void* data, int index, ed::plugin::InputLayoutItem& out) { }
-		virtual void PipelineItem_Remove(const char* itemName, const char* type, void* data) { }
+		virtual void PipelineItem_Remove(const char* itemName, const char* type, void* data);
 		virtual void PipelineItem_Rename(const char* oldName, const char* newName) { }
 		virtual void PipelineItem_AddChild(const char* owner, const char* name, ed::plugin::PipelineItemType type, void* data) { }
 		virtual bool PipelineItem_CanHaveChildren(const char* type, void* data) { return 0; }
 		virtual void* PipelineItem_CopyData(const char* type, void* data) { return 0; }
 		virtual void PipelineItem_Execute(void* Owner, ed::plugin::PipelineItemType OwnerType, const char* type, void* data) { }
-		virtual void PipelineItem_Execute(const char* type, void* data, void* children, int count) { }
+		virtual void PipelineItem_Execute(const char* type, void* data, void* children, int count);
 		virtual void PipelineItem_GetWorldMatrix(const char* type, void* data, float(&pMat)[16]) { }
 		virtual bool PipelineItem_Intersect(const char* type, void* data, const float* rayOrigin, const float* rayDir, float& hitDist) { return 0; }
 		virtual void PipelineItem_GetBoundingBox(const char* type, void* data, float(&minPos)[3], float(&maxPos)[3]) { }
 		virtual bool PipelineItem_HasContext(const char* type, void* data) { return 0; }
 		virtual void PipelineItem_ShowContext(const char* type, void* data) { }
-		virtual const char* PipelineItem_Export(const char* type, void* data) { return 0; }
-		virtual void* PipelineItem_Import(const char* ownerName, const char* name, const char* type, const char* argsString) { return 0; }
+		virtual const char* PipelineItem_Export(const char* type, void* data);
+		virtual void* PipelineItem_Import(const char* ownerName, const char* name, const char* type, const char* argsString);
 		virtual void PipelineItem_MoveDown(void* ownerData, const char* ownerType, const char* itemName) { }
 		virtual void PipelineItem_MoveUp(void* ownerData, const char* ownerType, const char* itemName) { }
 		virtual void PipelineItem_ApplyGizmoTransform(const char* type, void* data, float* transl, float* scale, float* rota) { }
@@ -132,13 +205,13 @@ namespace st
 		virtual const char* Options_GetValue(int index) { return 0; }
 
 		// languages
-		virtual int CustomLanguage_GetCount() { return 0; }
-		virtual const char* CustomLanguage_GetName(int langID) { return 0; }
-		virtual const unsigned int* CustomLanguage_CompileToSPIRV(int langID, const char* src, size_t src_len, ed::plugin::ShaderStage stage, const char* entry, ed::plugin::ShaderMacro* macros, size_t macroCount, size_t* spv_length, bool* compiled) { return 0; }
-		virtual const char* CustomLanguage_ProcessGeneratedGLSL(int langID, const char* src) { return 0; }
-		virtual bool CustomLanguage_SupportsAutoUniforms(int langID) { return 0; }
+		virtual int CustomLanguage_GetCount() { return 1; }
+		virtual const char* CustomLanguage_GetName(int langID) { return SHADERTOY_LANGUAGE_NAME; }
+		virtual const unsigned int* CustomLanguage_CompileToSPIRV(int langID, const char* src, size_t src_len, ed::plugin::ShaderStage stage, const char* entry, ed::plugin::ShaderMacro* macros, size_t macroCount, size_t* spv_length, bool* compiled);
+		virtual const char* CustomLanguage_ProcessGeneratedGLSL(int langID, const char* src) { return src; }
+		virtual bool CustomLanguage_SupportsAutoUniforms(int langID) { return 1; }
 		virtual bool CustomLanguage_IsDebuggable(int langID) { return 0; }
-		virtual const char* CustomLanguage_GetDefaultExtension(int langID) { return 0; }
+		virtual const char* CustomLanguage_GetDefaultExtension(int langID) { return SHADERTOY_LANGUAGE_EXT; }
 
 		// language text editor
 		virtual bool ShaderEditor_Supports(int langID) { return 0; }
@@ -191,7 +264,7 @@ namespace st
 
 		// misc
 		virtual bool HandleDropFile(const char* filename) { return 0; }
-		virtual void HandleRecompile(const char* itemName) { }
+		virtual void HandleRecompile(const char* itemName);
 		virtual void HandleRecompileFromSource(const char* itemName, int sid, const char* shaderCode, int shaderSize) { }
 		virtual void HandleShortcut(const char* name) { }
 		virtual void HandlePluginMessage(const char* sender, char* msg, int msgLen) { }
@@ -211,11 +284,56 @@ namespace st
 		virtual int ImmediateMode_GetResultID() { return 0; }
 
 	private:
+		bool m_loadShader(const std::string& id, bool fromStore = false);
+		void m_compileCubemapPass(CubemapPassItem* item);
+		bool m_openStore();
+		void m_startPrefetch();
+		void m_renderBrowser();
+		void m_updateBrowser();
+		void m_filterBrowser();
+		void m_importStored(const std::string& id);
+		void m_openImported(const std::string& outPath);
+
 		bool m_errorOccured;
 		std::string m_error;
-		char m_link[256], m_path[MY_PATH_LENGTH];
+		char m_link[256], m_path[MY_PATH_LENGTH], m_mediaPackPath[MY_PATH_LENGTH], m_storePath[MY_PATH_LENGTH];
 		bool m_isPopupOpened;
 
+		std::string m_loadedID;
+		json11::Json m_shaderData;
+		bool m_isSummaryOpened;
+		std::string m_summary;
+		ImportOptions m_options;
+		ShaderPrefetch m_prefetch;
+
+		// the sound pass is rendered in the background, the project is opened once the WAV file is written
+		SoundJob m_soundJob;
+		bool m_isSoundPopupOpened;
+		std::string m_soundProjectPath;
+
+		ShaderCompiler m_compiler;
+		std::vector<unsigned int> m_spv;
+
 		int m_hostVersion;
+		bool m_hasGL; // glewInit() succeeded - cube buffers & music textures are disabled otherwise
+
+		// fetched shaders are kept in the store & indexed for the code search
+		std::string m_openedStorePath;
+		ShaderStore m_store;
+		CodeIndex m_codeIndex;
+		char m_codeQuery[128];
+		std::vector<CodeSearchHit> m_codeHits;
+
+		// browser over the stored shaders
+		bool m_isBrowserOpened;
+		bool m_isBrowserDirty; // the store changed since the index was written
+		std::string m_browserStorePath;
+		ShaderIndex m_shaderIndex;
+		std::vector<int> m_browserRows; // indices of the filtered records
+		char m_browserFilter[128];
+		ThumbnailCache m_thumbnails;
+
+		std::map<std::string, CubemapObject*> m_cubemaps;
+		std::map<std::string, CubemapPassItem*> m_cubemapPasses;
 	};
 }
\ No newline at end of file
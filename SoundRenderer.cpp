@@ -0,0 +1,237 @@
+#include "SoundRenderer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <cmath>
+
+extern "C" {
+#include <spvm/context.h>
+#include <spvm/program.h>
+#include <spvm/state.h>
+#include <spvm/ext/GLSL450.h>
+#include <spvm/ext/GLSL.std.450.h>
+}
+
+namespace st
+{
+	std::string GenerateSoundShader(const std::string& code, const std::string& commonCode)
+	{
+		// older shaders use the mainSound(float time) signature
+		bool hasSampleArg = false;
+		size_t pos = code.find("mainSound");
+		if (pos != std::string::npos) {
+			pos = code.find_first_not_of(" \t\r\n", code.find('(', pos) + 1);
+			hasSampleArg = pos != std::string::npos && code.compare(pos, 3, "int") == 0;
+		}
+
+		// the sample index is passed as a float, it's exact for the whole 3 minutes
+		return "#version 330\n\n"
+			"uniform float iSampleRate;\n"
+			"uniform float stSample;\n"
+			"out vec2 stSound;\n\n" + commonCode + "\n" + code + "\n"
+			"void main()\n{\n"
+			"\tfloat stTime = stSample / iSampleRate;\n"
+			"\tstSound = clamp(" + std::string(hasSampleArg ? "mainSound(int(stSample), stTime)" : "mainSound(stTime)") + ", -1.0, 1.0);\n"
+			"}\n";
+	}
+
+	/////// RENDERING ///////
+	// the interpreter skips the GLSL.std.450 functions it doesn't implement, leaving their result undefined - these
+	// are replaced with a handler that flags the sample (every worker thread runs its own interpreter state)
+	thread_local int t_unsupportedInstruction = 0;
+	void UnsupportedInstruction(spvm_word type, spvm_word id, spvm_word word_count, spvm_state_t state)
+	{
+		t_unsupportedInstruction = 1;
+	}
+
+	struct SoundWorker
+	{
+		int First, Last;
+		bool Ok;
+		std::string Error;
+	};
+	void RenderSamples(const std::vector<unsigned int>& spv, std::vector<short>& pcm, std::atomic<int>& progress, const std::atomic<bool>& cancelled, SoundWorker& worker)
+	{
+		spvm_context_t ctx = spvm_context_initialize();
+		spvm_program_t prog = spvm_program_create(ctx, (spvm_source)spv.data(), spv.size());
+		spvm_state_t state = spvm_state_create(prog);
+		spvm_ext_opcode_func* glslExt = spvm_build_glsl450_ext();
+		for (int i = 0; i < GLSLstd450Count; i++)
+			if (glslExt[i] == nullptr)
+				glslExt[i] = UnsupportedInstruction;
+		spvm_state_set_extension(state, "GLSL.std.450", glslExt);
+
+		spvm_word fnMain = spvm_state_get_result_location(state, "main");
+		spvm_result_t output = spvm_state_get_result(state, "stSound");
+		worker.Ok = fnMain != 0 && output != nullptr && output->member_count >= 2;
+		if (!worker.Ok)
+			worker.Error = "the sound shader has no main() or stSound output";
+
+		t_unsupportedInstruction = 0;
+		float sampleRate = SOUND_SAMPLE_RATE;
+		for (int i = worker.First; i < worker.Last && worker.Ok && !cancelled; i++) {
+			float sample = (float)i;
+			spvm_state_prepare(state, fnMain);
+			spvm_state_set_value_f(state, "iSampleRate", &sampleRate);
+			spvm_state_set_value_f(state, "stSample", &sample);
+			spvm_state_call_function(state);
+
+			// a bad sample fails the whole sound instead of ending up in the WAV file
+			float left = output->members[0].value.f, right = output->members[1].value.f;
+			if (t_unsupportedInstruction) {
+				worker.Error = "mainSound calls a GLSL function that the interpreter doesn't implement (sample " + std::to_string(i) + ")";
+				worker.Ok = false;
+			} else if (!std::isfinite(left) || !std::isfinite(right)) {
+				worker.Error = "mainSound returned NaN or infinity (sample " + std::to_string(i) + ")";
+				worker.Ok = false;
+			} else {
+				pcm[i * 2 + 0] = (short)(left * 32767.0f);
+				pcm[i * 2 + 1] = (short)(right * 32767.0f);
+				progress++;
+			}
+		}
+
+		spvm_state_delete(state);
+		spvm_program_delete(prog);
+		free(glslExt);
+		spvm_context_deinitialize(ctx);
+	}
+	bool RenderSound(const std::vector<unsigned int>& spv, int sampleCount, std::vector<short>& pcm, std::atomic<int>& progress, const std::atomic<bool>& cancelled, std::string& error)
+	{
+		pcm.assign((size_t)sampleCount * 2, 0);
+
+		// every thread gets its own interpreter state
+		int workerCount = std::max(1u, std::thread::hardware_concurrency());
+		int samplesPerWorker = (sampleCount + workerCount - 1) / workerCount;
+		std::vector<SoundWorker> workers(workerCount);
+		for (int i = 0; i < workerCount; i++) {
+			workers[i].First = std::min(sampleCount, i * samplesPerWorker);
+			workers[i].Last = std::min(sampleCount, (i + 1) * samplesPerWorker);
+		}
+
+		std::vector<std::thread> threads;
+		for (int i = 1; i < workerCount; i++)
+			threads.push_back(std::thread(RenderSamples, std::cref(spv), std::ref(pcm), std::ref(progress), std::cref(cancelled), std::ref(workers[i])));
+		RenderSamples(spv, pcm, progress, cancelled, workers[0]);
+		for (auto& thread : threads)
+			thread.join();
+
+		if (cancelled) {
+			error = "cancelled";
+			return false;
+		}
+		for (const auto& worker : workers)
+			if (!worker.Ok) {
+				error = worker.Error;
+				return false;
+			}
+		return true;
+	}
+
+	/////// JOB ///////
+	SoundJob::~SoundJob()
+	{
+		Cancel();
+	}
+	void SoundJob::Start(const std::vector<unsigned int>& spv, int sampleCount, const std::string& wavPath)
+	{
+		Cancel();
+
+		m_path = wavPath;
+		m_state = std::make_shared<State>();
+		m_state->SampleCount = sampleCount;
+		m_thread = std::thread(&SoundJob::m_run, m_state, spv, wavPath);
+	}
+	void SoundJob::Cancel()
+	{
+		if (m_state != nullptr)
+			m_state->Cancelled = true;
+		if (m_thread.joinable())
+			m_thread.join();
+		m_state = nullptr;
+		m_path = "";
+	}
+	bool SoundJob::IsFinished() const
+	{
+		return m_state == nullptr || m_state->Finished;
+	}
+	float SoundJob::GetProgress() const
+	{
+		if (m_state == nullptr || m_state->SampleCount == 0)
+			return 1.0f;
+		return m_state->Progress / (float)m_state->SampleCount;
+	}
+	bool SoundJob::Finish(std::string& error, double& seconds, size_t& bytes)
+	{
+		if (m_state == nullptr) {
+			error = "no sound is being rendered";
+			return false;
+		}
+		if (m_thread.joinable())
+			m_thread.join();
+
+		bool ok = m_state->Ok;
+		error = m_state->Error;
+		seconds = m_state->Seconds;
+		bytes = m_state->Bytes;
+
+		m_state = nullptr;
+		m_path = "";
+		return ok;
+	}
+	void SoundJob::m_run(std::shared_ptr<State> state, std::vector<unsigned int> spv, std::string path)
+	{
+		auto startTime = std::chrono::steady_clock::now();
+
+		std::vector<short> pcm;
+		state->Ok = RenderSound(spv, state->SampleCount, pcm, state->Progress, state->Cancelled, state->Error);
+		if (state->Ok && !WriteWAV(path, pcm)) {
+			state->Error = "failed to write " + path;
+			state->Ok = false;
+		}
+		state->Bytes = pcm.size() * sizeof(short);
+		state->Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		state->Finished = true;
+	}
+
+	/////// WAV ///////
+	void WriteUInt(FILE* file, unsigned int value, int bytes)
+	{
+		unsigned char data[4] = { (unsigned char)value, (unsigned char)(value >> 8), (unsigned char)(value >> 16), (unsigned char)(value >> 24) };
+		fwrite(data, 1, bytes, file);
+	}
+	bool WriteWAV(const std::string& path, const std::vector<short>& pcm)
+	{
+		FILE* file = fopen(path.c_str(), "wb");
+		if (file == nullptr)
+			return false;
+
+		const int channels = 2, bytesPerSample = 2;
+		unsigned int dataSize = pcm.size() * bytesPerSample;
+
+		fwrite("RIFF", 1, 4, file);
+		WriteUInt(file, 36 + dataSize, 4);
+		fwrite("WAVEfmt ", 1, 8, file);
+		WriteUInt(file, 16, 4);
+		WriteUInt(file, 1, 2); // PCM
+		WriteUInt(file, channels, 2);
+		WriteUInt(file, SOUND_SAMPLE_RATE, 4);
+		WriteUInt(file, SOUND_SAMPLE_RATE * channels * bytesPerSample, 4);
+		WriteUInt(file, channels * bytesPerSample, 2);
+		WriteUInt(file, bytesPerSample * 8, 2);
+		fwrite("data", 1, 4, file);
+		WriteUInt(file, dataSize, 4);
+
+		// little endian samples
+		std::vector<unsigned char> data(dataSize);
+		for (size_t i = 0; i < pcm.size(); i++) {
+			data[i * 2 + 0] = (unsigned char)(pcm[i] & 0xFF);
+			data[i * 2 + 1] = (unsigned char)((pcm[i] >> 8) & 0xFF);
+		}
+		bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+		fclose(file);
+		return ok;
+	}
+}
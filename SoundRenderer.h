@@ -0,0 +1,60 @@
+#pragma once
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <string>
+
+#define SOUND_SAMPLE_RATE 44100
+#define SOUND_MAX_DURATION 180 // Shadertoy stops the sound after 3 minutes
+#define SOUND_DEFAULT_DURATION 10 // interpreting every sample takes a while
+
+namespace st
+{
+	/* standalone shader that evaluates mainSound() for the sample set in the stSample uniform & writes it to stSound */
+	std::string GenerateSoundShader(const std::string& code, const std::string& commonCode);
+
+	/* runs the SPIR-V of GenerateSoundShader() in an interpreter, the samples are split between threads - stereo, 16 bit.
+	   progress counts the rendered samples, the workers stop at the next sample once cancelled is set. Fails (with the
+	   reason in error) if the interpreter hits an instruction it doesn't implement or mainSound returns NaN/Inf. */
+	bool RenderSound(const std::vector<unsigned int>& spv, int sampleCount, std::vector<short>& pcm, std::atomic<int>& progress, const std::atomic<bool>& cancelled, std::string& error);
+	bool WriteWAV(const std::string& path, const std::vector<short>& pcm);
+
+	/* renders the sound pass & writes the WAV file on a background thread, so that the UI isn't blocked during the import */
+	class SoundJob
+	{
+	public:
+		SoundJob() { }
+		~SoundJob();
+
+		void Start(const std::vector<unsigned int>& spv, int sampleCount, const std::string& wavPath);
+		void Cancel(); // waits until the workers stop, nothing is written
+
+		inline bool IsActive() const { return m_state != nullptr; }
+		inline const std::string& GetPath() const { return m_path; }
+		bool IsFinished() const;
+		float GetProgress() const; // 0..1
+
+		/* joins the thread - false if the sound wasn't rendered/written, with the reason in error */
+		bool Finish(std::string& error, double& seconds, size_t& bytes);
+
+	private:
+		struct State
+		{
+			State() : Cancelled(false), Finished(false), Progress(0), SampleCount(0), Ok(false), Seconds(0.0), Bytes(0) { }
+
+			std::atomic<bool> Cancelled, Finished;
+			std::atomic<int> Progress;
+			int SampleCount;
+			bool Ok;
+			std::string Error;
+			double Seconds;
+			size_t Bytes;
+		};
+		static void m_run(std::shared_ptr<State> state, std::vector<unsigned int> spv, std::string path);
+
+		std::string m_path;
+		std::shared_ptr<State> m_state;
+		std::thread m_thread;
+	};
+}
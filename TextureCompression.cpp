@@ -0,0 +1,502 @@
+#include "TextureCompression.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace st
+{
+	const char* GetBlockFormatName(BlockFormat fmt)
+	{
+		switch (fmt) {
+		case BlockFormat::BC1: return "BC1";
+		case BlockFormat::BC4: return "BC4";
+		case BlockFormat::BC7: return "BC7";
+		}
+		return "";
+	}
+	int GetBlockSize(BlockFormat fmt)
+	{
+		return fmt == BlockFormat::BC7 ? 16 : 8;
+	}
+	double CompressionStats::GetPSNR() const
+	{
+		if (Samples == 0 || SquaredError <= 0.0)
+			return std::numeric_limits<double>::infinity();
+
+		double mse = SquaredError / Samples;
+		return 10.0 * log10(255.0 * 255.0 / mse);
+	}
+
+	BlockFormat ChooseBlockFormat(const Image& img, bool redOnly, CompressionQuality quality)
+	{
+		bool gray = true, alpha = false;
+		const unsigned char* data = img.Data.data();
+		for (size_t i = 0; i < img.Data.size(); i += 4) {
+			gray &= data[i] == data[i + 1] && data[i] == data[i + 2];
+			alpha |= data[i + 3] != 255;
+		}
+
+		if (gray && !alpha && redOnly)
+			return BlockFormat::BC4;
+		if (alpha || quality == CompressionQuality::High)
+			return BlockFormat::BC7;
+		return BlockFormat::BC1;
+	}
+
+	/////// ENDPOINT FITTING ///////
+	// the loops work on fixed size float arrays so that the compiler can vectorize them
+	struct Block
+	{
+		float Texels[16][4];
+	};
+	void FitEndpoints(const Block& block, int channels, bool principalAxis, float e0[4], float e1[4])
+	{
+		float mean[4] = { 0, 0, 0, 0 };
+		for (int i = 0; i < 16; i++)
+			for (int c = 0; c < 4; c++)
+				mean[c] += block.Texels[i][c] * (1.0f / 16.0f);
+
+		float cov[4][4] = {};
+		for (int i = 0; i < 16; i++) {
+			float d[4];
+			for (int c = 0; c < 4; c++)
+				d[c] = block.Texels[i][c] - mean[c];
+			for (int a = 0; a < 4; a++)
+				for (int b = 0; b < 4; b++)
+					cov[a][b] += d[a] * d[b];
+		}
+
+		if (!principalAxis) {
+			// bounding box, with the diagonal picked from the covariance with the green channel
+			for (int c = 0; c < 4; c++) {
+				float lo = 255.0f, hi = 0.0f;
+				for (int i = 0; i < 16; i++) {
+					lo = std::min(lo, block.Texels[i][c]);
+					hi = std::max(hi, block.Texels[i][c]);
+				}
+				bool flip = c < channels && c != 1 && channels > 1 && cov[c][1] < 0.0f;
+				e0[c] = flip ? lo : hi;
+				e1[c] = flip ? hi : lo;
+			}
+			return;
+		}
+
+		// power iteration, starting from the largest diagonal
+		float axis[4] = { 0, 0, 0, 0 };
+		int largest = 0;
+		for (int c = 1; c < channels; c++)
+			if (cov[c][c] > cov[largest][largest])
+				largest = c;
+		axis[largest] = 1.0f;
+
+		for (int iter = 0; iter < 8; iter++) {
+			float next[4] = { 0, 0, 0, 0 };
+			for (int a = 0; a < channels; a++)
+				for (int b = 0; b < channels; b++)
+					next[a] += cov[a][b] * axis[b];
+
+			float len = 0.0f;
+			for (int c = 0; c < 4; c++)
+				len += next[c] * next[c];
+			if (len < 1e-8f)
+				break;
+
+			len = 1.0f / sqrtf(len);
+			for (int c = 0; c < 4; c++)
+				axis[c] = next[c] * len;
+		}
+
+		float tMin = 0.0f, tMax = 0.0f;
+		for (int i = 0; i < 16; i++) {
+			float t = 0.0f;
+			for (int c = 0; c < 4; c++)
+				t += (block.Texels[i][c] - mean[c]) * axis[c];
+			tMin = std::min(tMin, t);
+			tMax = std::max(tMax, t);
+		}
+
+		for (int c = 0; c < 4; c++) {
+			e0[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * tMax));
+			e1[c] = std::min(255.0f, std::max(0.0f, mean[c] + axis[c] * tMin));
+		}
+	}
+	/* least squares endpoints for the given per-texel interpolation weights (0 = e0, 1 = e1) */
+	bool RefineEndpoints(const Block& block, const float weights[16], float e0[4], float e1[4])
+	{
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[4] = { 0, 0, 0, 0 }, bx[4] = { 0, 0, 0, 0 };
+		for (int i = 0; i < 16; i++) {
+			float b = weights[i], a = 1.0f - b;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (int c = 0; c < 4; c++) {
+				ax[c] += a * block.Texels[i][c];
+				bx[c] += b * block.Texels[i][c];
+			}
+		}
+
+		float det = aa * bb - ab * ab;
+		if (fabsf(det) < 1e-6f)
+			return false;
+
+		det = 1.0f / det;
+		for (int c = 0; c < 4; c++) {
+			e0[c] = std::min(255.0f, std::max(0.0f, (ax[c] * bb - bx[c] * ab) * det));
+			e1[c] = std::min(255.0f, std::max(0.0f, (bx[c] * aa - ax[c] * ab) * det));
+		}
+		return true;
+	}
+	int FindNearest(const float texel[4], const float palette[][4], int count, int channels, float& error)
+	{
+		int best = 0;
+		error = std::numeric_limits<float>::max();
+		for (int p = 0; p < count; p++) {
+			float dist = 0.0f;
+			for (int c = 0; c < channels; c++) {
+				float d = texel[c] - palette[p][c];
+				dist += d * d;
+			}
+			if (dist < error) {
+				error = dist;
+				best = p;
+			}
+		}
+		return best;
+	}
+
+	/////// BC1 ///////
+	unsigned short PackRGB565(const float c[4])
+	{
+		int r = (int)(c[0] * 31.0f / 255.0f + 0.5f);
+		int g = (int)(c[1] * 63.0f / 255.0f + 0.5f);
+		int b = (int)(c[2] * 31.0f / 255.0f + 0.5f);
+		return (unsigned short)((r << 11) | (g << 5) | b);
+	}
+	void UnpackRGB565(unsigned short v, float c[4])
+	{
+		int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+		c[0] = (float)((r << 3) | (r >> 2));
+		c[1] = (float)((g << 2) | (g >> 4));
+		c[2] = (float)((b << 3) | (b >> 2));
+		c[3] = 255.0f;
+	}
+	float EncodeBC1Endpoints(const Block& block, const float e0[4], const float e1[4], unsigned char* out, float weights[16])
+	{
+		unsigned short c0 = PackRGB565(e0), c1 = PackRGB565(e1);
+		if (c0 < c1)
+			std::swap(c0, c1);
+
+		// c0 > c1 selects the 4 color mode, c0 == c1 is a solid block either way
+		float palette[4][4];
+		UnpackRGB565(c0, palette[0]);
+		UnpackRGB565(c1, palette[1]);
+		for (int c = 0; c < 4; c++) {
+			palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+			palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+		}
+		const float paletteWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+		unsigned int indices = 0;
+		float error = 0.0f;
+		for (int i = 0; i < 16; i++) {
+			float dist = 0.0f;
+			int index = c0 == c1 ? 0 : FindNearest(block.Texels[i], palette, 4, 3, dist);
+			if (c0 == c1)
+				FindNearest(block.Texels[i], palette, 1, 3, dist);
+			indices |= (unsigned int)index << (i * 2);
+			weights[i] = paletteWeights[index];
+			error += dist;
+		}
+
+		out[0] = c0 & 0xFF;
+		out[1] = c0 >> 8;
+		out[2] = c1 & 0xFF;
+		out[3] = c1 >> 8;
+		for (int i = 0; i < 4; i++)
+			out[4 + i] = (indices >> (i * 8)) & 0xFF;
+		return error;
+	}
+	float EncodeBC1(const Block& block, CompressionQuality quality, unsigned char* out)
+	{
+		bool high = quality == CompressionQuality::High;
+		float e0[4], e1[4], weights[16];
+		FitEndpoints(block, 3, high, e0, e1);
+		float error = EncodeBC1Endpoints(block, e0, e1, out, weights);
+
+		for (int iter = 0; high && iter < 2 && error > 0.0f; iter++) {
+			unsigned char refined[8];
+			if (!RefineEndpoints(block, weights, e0, e1))
+				break;
+
+			float refinedError = EncodeBC1Endpoints(block, e0, e1, refined, weights);
+			if (refinedError >= error)
+				break;
+
+			error = refinedError;
+			memcpy(out, refined, sizeof(refined));
+		}
+		return error;
+	}
+
+	/////// BC4 ///////
+	float EncodeBC4Endpoints(const Block& block, int r0, int r1, unsigned char* out)
+	{
+		// r0 > r1: 8 interpolated values
+		float palette[8][4] = {};
+		palette[0][0] = (float)r0;
+		palette[1][0] = (float)r1;
+		for (int i = 1; i < 7; i++)
+			palette[i + 1][0] = (float)(((7 - i) * r0 + i * r1) / 7);
+
+		unsigned long long indices = 0;
+		float error = 0.0f;
+		for (int i = 0; i < 16; i++) {
+			float dist = 0.0f;
+			int index = r0 == r1 ? 0 : FindNearest(block.Texels[i], palette, 8, 1, dist);
+			if (r0 == r1)
+				FindNearest(block.Texels[i], palette, 1, 1, dist);
+			indices |= (unsigned long long)index << (i * 3);
+			error += dist;
+		}
+
+		out[0] = (unsigned char)r0;
+		out[1] = (unsigned char)r1;
+		for (int i = 0; i < 6; i++)
+			out[2 + i] = (indices >> (i * 8)) & 0xFF;
+		return error;
+	}
+	float EncodeBC4(const Block& block, CompressionQuality quality, unsigned char* out)
+	{
+		float lo = 255.0f, hi = 0.0f;
+		for (int i = 0; i < 16; i++) {
+			lo = std::min(lo, block.Texels[i][0]);
+			hi = std::max(hi, block.Texels[i][0]);
+		}
+
+		int r0 = (int)hi, r1 = (int)lo;
+		float error = EncodeBC4Endpoints(block, r0, r1, out);
+
+		// the extremes aren't always the best endpoints - nudge them inwards
+		if (quality == CompressionQuality::High && r0 - r1 > 7) {
+			for (int d0 = 0; d0 <= 3; d0++) {
+				for (int d1 = 0; d1 <= 3; d1++) {
+					if (d0 == 0 && d1 == 0)
+						continue;
+
+					unsigned char candidate[8];
+					float candidateError = EncodeBC4Endpoints(block, r0 - d0, r1 + d1, candidate);
+					if (candidateError < error) {
+						error = candidateError;
+						memcpy(out, candidate, sizeof(candidate));
+					}
+				}
+			}
+		}
+		return error;
+	}
+
+	/////// BC7 (MODE 6) ///////
+	const int BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	struct BitWriter
+	{
+		unsigned char* Data;
+		int Position;
+
+		void Write(unsigned int value, int bits)
+		{
+			for (int i = 0; i < bits; i++, Position++)
+				if ((value >> i) & 1)
+					Data[Position / 8] |= 1 << (Position % 8);
+		}
+	};
+	void QuantizeBC7Endpoint(const float e[4], int q[4], int& pbit)
+	{
+		// 7 bits per channel + a shared lowest bit, pick the p-bit that fits better
+		float bestError = std::numeric_limits<float>::max();
+		for (int p = 0; p < 2; p++) {
+			int cand[4];
+			float error = 0.0f;
+			for (int c = 0; c < 4; c++) {
+				cand[c] = std::min(127, std::max(0, (int)((e[c] - p) * 0.5f + 0.5f)));
+				float d = (float)((cand[c] << 1) | p) - e[c];
+				error += d * d;
+			}
+			if (error < bestError) {
+				bestError = error;
+				pbit = p;
+				memcpy(q, cand, sizeof(cand));
+			}
+		}
+	}
+	float EncodeBC7Endpoints(const Block& block, const float e0[4], const float e1[4], unsigned char* out, float weights[16])
+	{
+		int q0[4], q1[4], p0 = 0, p1 = 0;
+		QuantizeBC7Endpoint(e0, q0, p0);
+		QuantizeBC7Endpoint(e1, q1, p1);
+
+		float palette[16][4];
+		for (int c = 0; c < 4; c++) {
+			int a = (q0[c] << 1) | p0, b = (q1[c] << 1) | p1;
+			for (int w = 0; w < 16; w++)
+				palette[w][c] = (float)(((64 - BC7Weights[w]) * a + BC7Weights[w] * b + 32) >> 6);
+		}
+
+		int indices[16];
+		float error = 0.0f;
+		for (int i = 0; i < 16; i++) {
+			float dist = 0.0f;
+			indices[i] = FindNearest(block.Texels[i], palette, 16, 4, dist);
+			weights[i] = BC7Weights[indices[i]] / 64.0f;
+			error += dist;
+		}
+
+		// the anchor texel's index has an implicit 0 high bit
+		if (indices[0] >= 8) {
+			std::swap(q0, q1);
+			std::swap(p0, p1);
+			for (int i = 0; i < 16; i++)
+				indices[i] = 15 - indices[i];
+		}
+
+		memset(out, 0, 16);
+		BitWriter writer = { out, 0 };
+		writer.Write(1 << 6, 7);
+		for (int c = 0; c < 4; c++) {
+			writer.Write(q0[c], 7);
+			writer.Write(q1[c], 7);
+		}
+		writer.Write(p0, 1);
+		writer.Write(p1, 1);
+		writer.Write(indices[0], 3);
+		for (int i = 1; i < 16; i++)
+			writer.Write(indices[i], 4);
+
+		return error;
+	}
+	float EncodeBC7(const Block& block, CompressionQuality quality, unsigned char* out)
+	{
+		bool high = quality == CompressionQuality::High;
+		float e0[4], e1[4], weights[16];
+		FitEndpoints(block, 4, high, e0, e1);
+		float error = EncodeBC7Endpoints(block, e0, e1, out, weights);
+
+		for (int iter = 0; high && iter < 2 && error > 0.0f; iter++) {
+			unsigned char refined[16];
+			if (!RefineEndpoints(block, weights, e0, e1))
+				break;
+
+			float refinedError = EncodeBC7Endpoints(block, e0, e1, refined, weights);
+			if (refinedError >= error)
+				break;
+
+			error = refinedError;
+			memcpy(out, refined, sizeof(refined));
+		}
+		return error;
+	}
+
+	/////// IMAGE ///////
+	void CompressBlockRows(const Image& img, BlockFormat fmt, CompressionQuality quality, CompressedImage& out, int rowBegin, int rowEnd, double& error)
+	{
+		int blocksX = (img.Width + 3) / 4;
+		int blockSize = GetBlockSize(fmt);
+
+		error = 0.0;
+		for (int by = rowBegin; by < rowEnd; by++) {
+			for (int bx = 0; bx < blocksX; bx++) {
+				// edge blocks repeat the last row/column
+				Block block;
+				for (int i = 0; i < 16; i++) {
+					int x = std::min(bx * 4 + (i % 4), img.Width - 1);
+					int y = std::min(by * 4 + (i / 4), img.Height - 1);
+					const unsigned char* px = img.Data.data() + ((size_t)y * img.Width + x) * 4;
+					for (int c = 0; c < 4; c++)
+						block.Texels[i][c] = px[c];
+				}
+
+				unsigned char* dst = out.Data.data() + ((size_t)by * blocksX + bx) * blockSize;
+				if (fmt == BlockFormat::BC1)
+					error += EncodeBC1(block, quality, dst);
+				else if (fmt == BlockFormat::BC4)
+					error += EncodeBC4(block, quality, dst);
+				else
+					error += EncodeBC7(block, quality, dst);
+			}
+		}
+	}
+	void CompressImage(const Image& img, BlockFormat fmt, CompressionQuality quality, CompressedImage& out, CompressionStats& stats)
+	{
+		int blocksX = (img.Width + 3) / 4;
+		int blocksY = (img.Height + 3) / 4;
+		out.Width = img.Width;
+		out.Height = img.Height;
+		out.Data.assign((size_t)blocksX * blocksY * GetBlockSize(fmt), 0);
+
+		unsigned int threadCount = std::max(1u, std::thread::hardware_concurrency());
+		int workers = std::min<int>(threadCount, std::max(1, blocksY / 8));
+		int rowsPerWorker = (blocksY + workers - 1) / workers;
+
+		// padded texels are counted too, they're copies of the edge
+		std::vector<double> errors(workers, 0.0);
+		std::vector<std::thread> threads;
+		for (int i = 1; i < workers; i++)
+			threads.push_back(std::thread(CompressBlockRows, std::cref(img), fmt, quality, std::ref(out), i * rowsPerWorker, std::min(blocksY, (i + 1) * rowsPerWorker), std::ref(errors[i])));
+		CompressBlockRows(img, fmt, quality, out, 0, std::min(blocksY, rowsPerWorker), errors[0]);
+		for (auto& thread : threads)
+			thread.join();
+
+		int channels = fmt == BlockFormat::BC1 ? 3 : (fmt == BlockFormat::BC4 ? 1 : 4);
+		for (double error : errors)
+			stats.SquaredError += error;
+		stats.Samples += (size_t)blocksX * blocksY * 16 * channels;
+	}
+
+	/////// DDS ///////
+	unsigned int MakeFourCC(const char* code)
+	{
+		return code[0] | (code[1] << 8) | (code[2] << 16) | (code[3] << 24);
+	}
+	bool WriteDDS(const std::string& path, BlockFormat fmt, const std::vector<CompressedImage>& mips)
+	{
+		if (mips.empty())
+			return false;
+
+		DDSHeader header;
+		memset(&header, 0, sizeof(header));
+		header.Size = sizeof(DDSHeader);
+		header.Flags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x80000 | (mips.size() > 1 ? 0x20000 : 0); // caps, height, width, pixel format, linear size, mip count
+		header.Height = mips[0].Height;
+		header.Width = mips[0].Width;
+		header.PitchOrLinearSize = mips[0].Data.size();
+		header.MipMapCount = mips.size();
+		header.PixelFormat.Size = sizeof(DDSPixelFormat);
+		header.PixelFormat.Flags = 0x4; // fourCC
+		header.PixelFormat.FourCC = MakeFourCC(fmt == BlockFormat::BC1 ? "DXT1" : (fmt == BlockFormat::BC4 ? "ATI1" : "DX10"));
+		header.Caps = 0x1000 | (mips.size() > 1 ? 0x8 | 0x400000 : 0); // texture, complex, mipmap
+
+		// BC7 only exists in the DX10 extension
+		DDSHeaderDX10 dx10;
+		memset(&dx10, 0, sizeof(dx10));
+		dx10.Format = 98; // DXGI_FORMAT_BC7_UNORM
+		dx10.ResourceDimension = 3; // texture 2D
+		dx10.ArraySize = 1;
+
+		FILE* file = fopen(path.c_str(), "wb");
+		if (file == nullptr)
+			return false;
+
+		bool ok = fwrite("DDS ", 1, 4, file) == 4 && fwrite(&header, sizeof(header), 1, file) == 1;
+		if (fmt == BlockFormat::BC7)
+			ok = ok && fwrite(&dx10, sizeof(dx10), 1, file) == 1;
+		for (const auto& mip : mips)
+			ok = ok && fwrite(mip.Data.data(), 1, mip.Data.size(), file) == mip.Data.size();
+
+		fclose(file);
+		return ok;
+	}
+}
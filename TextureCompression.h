@@ -0,0 +1,44 @@
+#pragma once
+#include "ImageIO.h"
+#include <vector>
+#include <string>
+
+namespace st
+{
+	enum class BlockFormat
+	{
+		BC1, // RGB, 4 bits per texel
+		BC4, // single channel, 4 bits per texel
+		BC7 // RGBA, 8 bits per texel (mode 6 only)
+	};
+	enum class CompressionQuality
+	{
+		None,
+		Fast, // bounding box endpoints
+		High // principal axis endpoints + least squares refinement
+	};
+
+	struct CompressedImage
+	{
+		int Width;
+		int Height;
+		std::vector<unsigned char> Data;
+	};
+	struct CompressionStats
+	{
+		double SquaredError;
+		size_t Samples;
+
+		double GetPSNR() const; // infinity if lossless
+	};
+
+	const char* GetBlockFormatName(BlockFormat fmt);
+
+	/* BC4 for grayscale images that are only read through .r/.x (it samples as (r, 0, 0, 1)), BC7 for images with alpha
+	   or for the high quality preset, BC1 otherwise */
+	BlockFormat ChooseBlockFormat(const Image& img, bool redOnly, CompressionQuality quality);
+
+	/* rows of blocks are split between threads, the error against img is added to stats */
+	void CompressImage(const Image& img, BlockFormat fmt, CompressionQuality quality, CompressedImage& out, CompressionStats& stats);
+	bool WriteDDS(const std::string& path, BlockFormat fmt, const std::vector<CompressedImage>& mips);
+}
@@ -0,0 +1,203 @@
+#include "ThumbnailCache.h"
+#include "ImageIO.h"
+#include <ghc/filesystem.hpp>
+#include <GL/glew.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+#define CPPHTTPLIB_OPENSSL_SUPPORT
+#include <httplib/httplib.h>
+
+namespace st
+{
+	ThumbnailCache::ThumbnailCache() : m_maxBytes(0), m_bytes(0), m_stop(false) { }
+	ThumbnailCache::~ThumbnailCache()
+	{
+		// textures can't be deleted here - the GL context might already be gone
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_stop = true;
+		lock.unlock();
+		m_cond.notify_all();
+		for (auto& thread : m_threads)
+			thread.join();
+	}
+	void ThumbnailCache::Start(const std::string& diskDir, size_t maxBytes, int threads)
+	{
+		Stop();
+
+		m_diskDir = diskDir;
+		m_maxBytes = maxBytes;
+		m_stop = false;
+		if (!diskDir.empty()) {
+			std::error_code ec;
+			ghc::filesystem::create_directories(diskDir, ec);
+		}
+
+		for (int i = 0; i < std::max(1, threads); i++)
+			m_threads.push_back(std::thread(&ThumbnailCache::m_worker, this));
+	}
+	void ThumbnailCache::Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_cond.notify_all();
+		for (auto& thread : m_threads)
+			thread.join();
+		m_threads.clear();
+
+		for (const auto& pair : m_entries)
+			if (pair.second.Texture != 0)
+				m_deadTextures.push_back(pair.second.Texture);
+		if (!m_deadTextures.empty())
+			glDeleteTextures(m_deadTextures.size(), m_deadTextures.data());
+
+		m_deadTextures.clear();
+		m_entries.clear();
+		m_lru.clear();
+		m_queue.clear();
+		m_bytes = 0;
+	}
+	unsigned int ThumbnailCache::GetTexture(const std::string& id, int& width, int& height)
+	{
+		width = height = 0;
+		if (m_threads.empty())
+			return 0;
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		if (!m_deadTextures.empty()) {
+			glDeleteTextures(m_deadTextures.size(), m_deadTextures.data());
+			m_deadTextures.clear();
+		}
+
+		auto it = m_entries.find(id);
+		if (it == m_entries.end()) {
+			Entry& entry = m_entries[id];
+			entry.Status = State::Queued;
+			entry.Width = entry.Height = 0;
+			entry.Texture = 0;
+			entry.Use = m_lru.insert(m_lru.begin(), id);
+
+			// rows that scrolled out of view long ago aren't worth loading anymore
+			m_queue.push_front(id);
+			if (m_queue.size() > THUMBNAIL_QUEUE_SIZE) {
+				auto dropped = m_entries.find(m_queue.back());
+				m_lru.erase(dropped->second.Use);
+				m_entries.erase(dropped);
+				m_queue.pop_back();
+			}
+			lock.unlock();
+			m_cond.notify_one();
+			return 0;
+		}
+
+		Entry& entry = it->second;
+		m_lru.splice(m_lru.begin(), m_lru, entry.Use);
+		if (entry.Status == State::Queued) {
+			// still visible - load it before the rows that were requested after it
+			auto queued = std::find(m_queue.begin(), m_queue.end(), id);
+			if (queued != m_queue.end() && queued != m_queue.begin()) {
+				m_queue.erase(queued);
+				m_queue.push_front(id);
+			}
+			return 0;
+		}
+		if (entry.Status == State::Failed)
+			return 0;
+
+		if (entry.Texture == 0) {
+			glGenTextures(1, &entry.Texture);
+			glBindTexture(GL_TEXTURE_2D, entry.Texture);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, entry.Width, entry.Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, entry.Pixels.data());
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			// still counted in m_bytes, the texture takes its place
+			std::vector<unsigned char>().swap(entry.Pixels);
+		}
+
+		width = entry.Width;
+		height = entry.Height;
+		return entry.Texture;
+	}
+
+	void ThumbnailCache::m_worker()
+	{
+		httplib::SSLClient cli("www.shadertoy.com");
+		cli.set_keep_alive_max_count(100);
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (true) {
+			m_cond.wait(lock, [&]() { return m_stop || !m_queue.empty(); });
+			if (m_stop)
+				break;
+
+			std::string id = m_queue.front();
+			m_queue.pop_front();
+			lock.unlock();
+
+			// the disk copy is checked first, downloaded thumbnails are saved next to it
+			std::string fileData;
+			std::string diskPath = m_diskDir.empty() ? "" : m_diskDir + "/" + id + ".jpg";
+			if (!diskPath.empty()) {
+				std::ifstream file(diskPath, std::ios::binary);
+				if (file) {
+					std::stringstream ss;
+					ss << file.rdbuf();
+					fileData = ss.str();
+				}
+			}
+			if (fileData.empty()) {
+				auto res = cli.Get(("/media/shaders/" + id + ".jpg").c_str());
+				if (res && res->status == 200) {
+					fileData = res->body;
+					if (!diskPath.empty()) {
+						std::ofstream file(diskPath, std::ios::binary);
+						file.write(fileData.data(), fileData.size());
+					}
+				}
+			}
+
+			Image img;
+			bool decoded = !fileData.empty() && DecodeImage(fileData, img);
+
+			lock.lock();
+			auto it = m_entries.find(id);
+			if (it == m_entries.end()) // dropped from the queue
+				continue;
+
+			Entry& entry = it->second;
+			entry.Status = decoded ? State::Ready : State::Failed;
+			if (decoded) {
+				entry.Width = img.Width;
+				entry.Height = img.Height;
+				entry.Pixels.swap(img.Data);
+				m_bytes += entry.Pixels.size();
+			}
+			m_evict();
+		}
+	}
+	void ThumbnailCache::m_evict()
+	{
+		auto it = m_lru.end();
+		while ((m_bytes > m_maxBytes || m_entries.size() > THUMBNAIL_ENTRY_LIMIT) && it != m_lru.begin()) {
+			--it;
+
+			auto entry = m_entries.find(*it);
+			if (entry->second.Status == State::Queued)
+				continue;
+
+			if (entry->second.Status == State::Ready)
+				m_bytes -= (size_t)entry->second.Width * entry->second.Height * 4;
+			if (entry->second.Texture != 0)
+				m_deadTextures.push_back(entry->second.Texture);
+			m_entries.erase(entry);
+			it = m_lru.erase(it);
+		}
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <condition_variable>
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include <thread>
+#include <deque>
+#include <mutex>
+#include <list>
+
+#define THUMBNAIL_CACHE_SIZE 64 // MB of decoded thumbnails
+#define THUMBNAIL_QUEUE_SIZE 64 // pending requests, the oldest ones are dropped
+#define THUMBNAIL_ENTRY_LIMIT 4096 // loaded & failed thumbnails, failed ones take no memory otherwise
+#define THUMBNAIL_THREADS 4
+
+namespace st
+{
+	/* shader thumbnails (/media/shaders/<id>.jpg) - downloaded (or read from the directory on disk) & decoded on
+	   worker threads, kept in an LRU cache that is capped by the size of the decoded pixels. GL textures are only
+	   created on the main thread, when a thumbnail is asked for. */
+	class ThumbnailCache
+	{
+	public:
+		ThumbnailCache();
+		~ThumbnailCache();
+
+		void Start(const std::string& diskDir, size_t maxBytes = THUMBNAIL_CACHE_SIZE * 1024 * 1024, int threads = THUMBNAIL_THREADS);
+		void Stop(); // deletes the textures, must be called on the GL thread
+
+		/* 0 while the thumbnail is loading (it's requested) or if it doesn't exist */
+		unsigned int GetTexture(const std::string& id, int& width, int& height);
+
+		inline bool IsRunning() const { return !m_threads.empty(); }
+
+	private:
+		enum class State { Queued, Ready, Failed };
+		struct Entry
+		{
+			State Status;
+			int Width, Height;
+			std::vector<unsigned char> Pixels; // released once the texture exists
+			unsigned int Texture;
+			std::list<std::string>::iterator Use; // position in m_lru
+		};
+
+		void m_worker();
+		void m_evict(); // m_mutex must be locked
+
+		std::string m_diskDir;
+		size_t m_maxBytes, m_bytes;
+		bool m_stop;
+
+		std::mutex m_mutex;
+		std::condition_variable m_cond;
+		std::unordered_map<std::string, Entry> m_entries;
+		std::list<std::string> m_lru; // most recently used first
+		std::deque<std::string> m_queue; // most recently requested first
+		std::vector<unsigned int> m_deadTextures; // of evicted entries, deleted on the main thread
+		std::vector<std::thread> m_threads;
+	};
+}